@@ -13,7 +13,7 @@ filter { "platforms:64*" }
   architecture "x86_64"
   
 filter { "configurations:*Debug" }
-  defines { "_DEBUG", "DEBUG" }
+  defines { "_DEBUG", "DEBUG", "NUI_PROFILER" }
   flags { "Symbols" }
   targetsuffix "_debug"
   
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <functional>
+#include <iterator>
 #include <nanovg/nanovg.h>
 
 #include "Config.h"
@@ -19,6 +21,86 @@ template <typename T> static T clampMaximum(T value, T max) { return (max && val
 template <typename T> static T clampMinMax(T value, T min, T max) { return clampMinimum(clampMaximum(value, max), min); }
 template <typename T> static void swapValues(T &v1, T &v2) { T temp = v1; v1 = v2; v2 = temp; }
 
+// FNV-1a, hash of a previous block can be passed to continue it
+inline uint64_t hashBytes(const void *data, size_t length, uint64_t hash = 14695981039346656037ULL)
+{
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+
+  for (size_t i = 0; i < length; ++i)
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+  return hash;
+}
+
+// Writes UTF-8 encoding of a code point, out needs room for 4 bytes. Returns number of bytes written. Negative values,
+// surrogates and values past U+10FFFF are written as the replacement character U+FFFD.
+inline size_t encodeUtf8(int codePoint, char *out)
+{
+  unsigned c = static_cast<unsigned>(codePoint);
+
+  // Negative values wrap around past the range
+  if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+    c = 0xFFFD;
+
+  if (c < 0x80)
+  {
+    out[0] = static_cast<char>(c);
+    return 1;
+  }
+
+  if (c < 0x800)
+  {
+    out[0] = static_cast<char>(0xC0 | (c >> 6));
+    out[1] = static_cast<char>(0x80 | (c & 0x3F));
+    return 2;
+  }
+
+  if (c < 0x10000)
+  {
+    out[0] = static_cast<char>(0xE0 | (c >> 12));
+    out[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    out[2] = static_cast<char>(0x80 | (c & 0x3F));
+    return 3;
+  }
+
+  out[0] = static_cast<char>(0xF0 | ((c >> 18) & 0x07));
+  out[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+  out[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+  out[3] = static_cast<char>(0x80 | (c & 0x3F));
+  return 4;
+}
+
+// Code point starting at text, length receives number of its bytes. Stray continuation bytes and truncated sequences
+// decode as single bytes.
+inline int decodeUtf8(const char *text, const char *end, size_t *length)
+{
+  const unsigned char *c = reinterpret_cast<const unsigned char *>(text);
+  size_t available = end - text;
+  size_t count = c[0] < 0xC0 ? 1 : c[0] < 0xE0 ? 2 : c[0] < 0xF0 ? 3 : 4;
+  int codePoint = count == 1 ? c[0] : c[0] & (0x3F >> (count - 1));
+
+  if (count > available)
+    count = 1;
+
+  for (size_t i = 1; i < count; ++i)
+  {
+    if ((c[i] & 0xC0) != 0x80)
+    {
+      count = 1;
+      codePoint = c[0];
+      break;
+    }
+
+    codePoint = (codePoint << 6) | (c[i] & 0x3F);
+  }
+
+  if (count == 1)
+    codePoint = c[0];
+
+  *length = count;
+  return codePoint;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 typedef std::function<void(const std::string &str, size_t index, size_t offset, size_t length)> SplitStringCallback;
@@ -392,6 +474,34 @@ struct Rect
     return result;
   }
 
+  Rect &operator|=(const Rect &rect)
+  {
+    if (rect.isEmpty())
+      return *this;
+
+    if (isEmpty())
+      return (*this = rect);
+
+    int x1 = minimum(x, rect.x);
+    int y1 = minimum(y, rect.y);
+    int x2 = maximum(x + width, rect.x + rect.width);
+    int y2 = maximum(y + height, rect.y + rect.height);
+
+    x = x1;
+    y = y1;
+    width = x2 - x1;
+    height = y2 - y1;
+
+    return *this;
+  }
+
+  Rect operator|(const Rect &rect) const
+  {
+    Rect result = *this;
+    result |= rect;
+    return result;
+  }
+
   bool operator==(const Rect &rect) const
   {
     return x == rect.x && y == rect.y && width == rect.width && height == rect.height;
@@ -407,6 +517,30 @@ struct Rect
     return !(px < x || py < y || px >= (x + width) || py >= (y + height));
   }
 
+  bool isEmpty() const { return width <= 0 || height <= 0; }
+
+  bool intersects(const Rect &rect) const
+  {
+    return !isEmpty() && !rect.isEmpty() &&
+      x < rect.x + rect.width && rect.x < x + width &&
+      y < rect.y + rect.height && rect.y < y + height;
+  }
+
+  bool contains(const Rect &rect) const
+  {
+    return !isEmpty() &&
+      rect.x >= x && rect.y >= y &&
+      rect.x + rect.width <= x + width && rect.y + rect.height <= y + height;
+  }
+
+  void inflate(int amount)
+  {
+    x -= amount;
+    y -= amount;
+    width += amount * 2;
+    height += amount * 2;
+  }
+
   void shrinkHorizontal(int amount)
   {
     x += amount;
@@ -497,6 +631,7 @@ class Ptr
 class Object
 {
   template <typename T> friend class Ptr;
+  template <typename T> friend class PtrVector;
 
   protected:
     Object() { }
@@ -512,4 +647,73 @@ class Object
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Contiguous array of owning intrusive references, unlike std::vector<Ptr<T>> it's iterated over plain pointers
+// without touching reference counts
+template <typename T>
+class PtrVector
+{
+  public:
+    typedef T *const *const_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    PtrVector() { }
+    PtrVector(const PtrVector &) = delete;
+    PtrVector &operator=(const PtrVector &) = delete;
+    ~PtrVector() { clear(); }
+
+    size_t size() const { return _items.size(); }
+    bool empty() const { return _items.empty(); }
+
+    T *operator[](size_t index) const { return _items[index]; }
+    T *back() const { return _items.back(); }
+
+    const_iterator begin() const { return _items.data(); }
+    const_iterator end() const { return _items.data() + _items.size(); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    void push_back(T *item)
+    {
+      item->addRef();
+      _items.push_back(item);
+    }
+
+    // Returns index of the item or size() if it's not stored
+    size_t indexOf(const T *item) const
+    {
+      for (size_t i = 0; i < _items.size(); ++i)
+        if (_items[i] == item)
+          return i;
+
+      return _items.size();
+    }
+
+    // Item is released only after it's removed, its destructor may already see the array without it
+    void erase(size_t index)
+    {
+      T *item = _items[index];
+      _items.erase(_items.begin() + index);
+      item->release();
+    }
+
+    // Moves item at index to the end keeping order of the others
+    void moveToBack(size_t index)
+    {
+      T *item = _items[index];
+      _items.erase(_items.begin() + index);
+      _items.push_back(item);
+    }
+
+    void clear()
+    {
+      while (!_items.empty())
+        erase(_items.size() - 1);
+    }
+
+  private:
+    std::vector<T *> _items;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace nui
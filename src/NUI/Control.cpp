@@ -1,7 +1,37 @@
 #include "Control.h"
+#include "controls/Root.h"
 
 namespace nui {
 
+Control::TickStats Control::_tickStats;
+unsigned Control::_layoutGeneration = 0;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Shrinks area so that it doesn't overlap rect but still contains the given point
+static void excludeArea(Rect &area, const Rect &rect, int x, int y)
+{
+  if (!area.intersects(rect))
+    return;
+
+  Rect pieces[4] =
+  {
+    Rect(area.x, area.y, rect.x - area.x, area.height),
+    Rect(rect.x + rect.width, area.y, area.x + area.width - rect.x - rect.width, area.height),
+    Rect(area.x, area.y, area.width, rect.y - area.y),
+    Rect(area.x, rect.y + rect.height, area.width, area.y + area.height - rect.y - rect.height)
+  };
+
+  Rect best;
+
+  for (auto &piece : pieces)
+  {
+    if (piece.isPointInside(x, y) && piece.width * piece.height > best.width * best.height)
+      best = piece;
+  }
+
+  area = best;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void Control::clear()
 {
@@ -11,6 +41,13 @@ void Control::clear()
 
 //---------------------------------------------------------------------------------------------------------------------
 Control::ControlPointInfo Control::controlAtPoint(int x, int y)
+{
+  Rect stableArea = Rect(x, y, 1, 1);
+  return controlAtPoint(x, y, stableArea);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+Control::ControlPointInfo Control::controlAtPoint(int x, int y, Rect &stableArea)
 {
   ControlPointInfo result;
   result.control = this;
@@ -32,6 +69,15 @@ Control::ControlPointInfo Control::controlAtPoint(int x, int y)
       if (x < Graphics::Style::ResizeCornerSize) result.edges |= Edge::Left;
       if (x >= _rect.width - Graphics::Style::ResizeCornerSize) result.edges |= Edge::Right;
     }
+
+    // Edges can't change further than a corner size from the borders
+    Rect inner = Rect(0, 0, _rect.width, _rect.height);
+    inner.inflate(-Graphics::Style::ResizeCornerSize);
+
+    if (inner.isPointInside(x, y))
+      stableArea *= inner;
+    else
+      stableArea = Rect(x, y, 1, 1);
   }
 
   if ((_flags & CanMove) && !result.edges)
@@ -40,69 +86,159 @@ Control::ControlPointInfo Control::controlAtPoint(int x, int y)
     {
       result.edges |= Edge::All;
     }
-  }
 
-  x -= _padding.left;
-  y -= _padding.top + _titleHeight;
+    if (_titleHeight)
+      stableArea *= (y < _titleHeight) ? Rect(0, 0, _rect.width, _titleHeight) : Rect(0, _titleHeight, _rect.width, _rect.height - _titleHeight);
+  }
 
   if (!result.edges || result.edges == Edge::All)
   {
-    for (auto child : _children)
+    Vec2 contentOffset = Vec2(_padding.left, _padding.top + _titleHeight);
+
+    x -= contentOffset.x;
+    y -= contentOffset.y;
+    stableArea.x -= contentOffset.x;
+    stableArea.y -= contentOffset.y;
+
+    Vec2 origin;
+    Control *child = childAtPoint(x, y, stableArea, origin);
+
+    if (child)
     {
-      if (!child->isVisible()) continue;
+      stableArea.x -= origin.x;
+      stableArea.y -= origin.y;
 
-      if (child->_docking != Docking::None && child->_docking != Docking::Client)
-      {
-        if (child->_rect.isPointInside(x, y))
-        {
-          int px = x - child->_rect.x;
-          int py = y - child->_rect.y;
+      result = child->controlAtPoint(x - origin.x, y - origin.y, stableArea);
 
-          result = child->controlAtPoint(px, py);
-        }
-      }
+      stableArea.x += origin.x;
+      stableArea.y += origin.y;
     }
 
-    x -= _undockedOffset.x;
-    y -= _undockedOffset.y;
+    stableArea.x += contentOffset.x;
+    stableArea.y += contentOffset.y;
+  }
 
-    for (auto child : _children)
+  return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+Control *Control::childAtPoint(int x, int y, Rect &stableArea, Vec2 &origin)
+{
+  // Parent clipped children are tested first, then undocked and docked ones, always from the topmost one
+  const int groupOrder[HitIndex::Count] = { HitIndex::ParentClipped, HitIndex::Undocked, HitIndex::Docked };
+
+  if (_children.size() < HitIndexMinChildren)
+  {
+    for (int group : groupOrder)
     {
-      if (!child->isVisible()) continue;
+      Vec2 offset = (group == HitIndex::Undocked) ? _undockedOffset : Vec2();
 
-      if ((child->_docking == Docking::None || child->_docking == Docking::Client) && !(child->_flags & ParentClip))
+      for (auto iter = _children.rbegin(); iter != _children.rend(); ++iter)
       {
-        if (child->_rect.isPointInside(x, y))
-        {
-          int px = x - child->_rect.x;
-          int py = y - child->_rect.y;
+        Control *child = *iter;
+
+        if (!child->isVisible() || getHitGroup(child) != group) continue;
+
+        Rect r = Rect(child->_rect.x + offset.x, child->_rect.y + offset.y, child->_rect.width, child->_rect.height);
 
-          result = child->controlAtPoint(px, py);
+        if (r.isPointInside(x, y))
+        {
+          stableArea *= r;
+          origin = r.getPosition();
+          return child;
         }
+
+        excludeArea(stableArea, r, x, y);
       }
     }
 
-    x += _undockedOffset.x;
-    y += _undockedOffset.y;
+    return nullptr;
+  }
+
+  updateHitIndex();
+
+  for (int group : groupOrder)
+  {
+    const HitGrid &grid = _hitIndex->groups[group];
+    Vec2 offset = (group == HitIndex::Undocked) ? _undockedOffset : Vec2();
+
+    size_t count;
+    Rect cell;
+    const unsigned *ids = grid.query(x - offset.x, y - offset.y, count, &cell);
+
+    if (cell.isEmpty())
+    {
+      Rect bounds = grid.getBounds();
+      excludeArea(stableArea, Rect(bounds.x + offset.x, bounds.y + offset.y, bounds.width, bounds.height), x, y);
+      continue;
+    }
+
+    stableArea *= Rect(cell.x + offset.x, cell.y + offset.y, cell.width, cell.height);
 
-    for (auto child : _children)
+    for (size_t i = count; i-- > 0;)
     {
-      if (!child->isVisible()) continue;
+      const HitGrid::Entry &entry = grid.getEntry(ids[i]);
+      Rect r = Rect(entry.rect.x + offset.x, entry.rect.y + offset.y, entry.rect.width, entry.rect.height);
 
-      if (child->_docking == Docking::None && (child->_flags & ParentClip))
+      if (r.isPointInside(x, y))
       {
-        if (child->_rect.isPointInside(x, y))
-        {
-          int px = x - child->_rect.x;
-          int py = y - child->_rect.y;
-
-          result = child->controlAtPoint(px, py);
-        }
+        stableArea *= r;
+        origin = r.getPosition();
+        return _children[entry.index];
       }
+
+      excludeArea(stableArea, r, x, y);
     }
   }
 
-  return result;
+  return nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int Control::getHitGroup(const Control *child)
+{
+  bool parentClip = (child->_flags & ParentClip) != 0;
+
+  switch (child->_docking)
+  {
+    case Docking::None:
+      return parentClip ? HitIndex::ParentClipped : HitIndex::Undocked;
+
+    case Docking::Client:
+      return parentClip ? -1 : HitIndex::Undocked;
+
+    default:
+      return HitIndex::Docked;
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Control::updateHitIndex()
+{
+  if (!_hitIndex)
+    _hitIndex.reset(new HitIndex());
+
+  if (_hitIndex->valid)
+    return;
+
+  for (auto &grid : _hitIndex->groups)
+    grid.clear();
+
+  for (size_t i = 0; i < _children.size(); ++i)
+  {
+    Control *child = _children[i];
+
+    if (!child->isVisible()) continue;
+
+    int group = getHitGroup(child);
+    if (group >= 0)
+      _hitIndex->groups[group].add(child->_rect, static_cast<unsigned>(i));
+  }
+
+  for (auto &grid : _hitIndex->groups)
+    grid.build();
+
+  _hitIndex->valid = true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -117,7 +253,7 @@ void Control::clampResizeStep(int &dx, int &dy) const
     dx = clampedSize.x - _rect.width;
     dy = clampedSize.y - _rect.height;
 
-    for (auto child : _children)
+    for (Control *child : _children)
       child->clampResizeStep(dx, dy);
   }
 }
@@ -129,21 +265,28 @@ void Control::resizeStep(int dx, int dy)
 
   _rect.width += dx;
   _rect.height += dy;
+  setDirty();
 
+  // Docked children are placed by the next arrange pass, anchored ones follow the size right away
   resizeStepChildren(dx, dy);
-  arrangeChildren();
 
-  Event e(Event::Type::SizeChanged, this);
-  processEvent(e);
+  if (hasEventHandler(Event::Type::SizeChanged))
+  {
+    Event e(Event::Type::SizeChanged, this);
+    processEvent(e);
+  }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void Control::resizeStepChildren(int dx, int dy)
 {
-  for (auto child : _children)
+  for (Control *child : _children)
   {
     if (child->_docking == Docking::None)
     {
+      // Child's position may change without its resizeStep() doing anything
+      _layoutConstraints.valid = false;
+
       Rect &r = child->_rect;
       unsigned a = child->_anchors;
       Vec2 delta;
@@ -157,20 +300,41 @@ void Control::resizeStepChildren(int dx, int dy)
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void Control::updateContentSize()
+void Control::measure()
 {
-  Borders dockingBorders;
-  Vec2 minimumDockingSize;
+  if (_subtreeDirty)
+  {
+    for (Control *child : _children)
+    {
+      if (child->_dirty || child->_subtreeDirty)
+        child->measure();
+    }
+  }
 
-  _contentRect = Rect(0, 0, _rect.width - _padding.getHorizontal(), _rect.height - _padding.getVertical() - _titleHeight);
+  if (_autoSizePending)
+  {
+    _autoSizePending = false;
+    autoSize(true);
+  }
+
+  if (!_layoutConstraints.valid)
+    measureChildren();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Control::measureChildren()
+{
+  NUI_PROFILE_SCOPE(Layout);
+
+  ++_tickStats.measured;
+
+  LayoutConstraints &lc = _layoutConstraints;
+  lc = LayoutConstraints();
 
-  // Undocked bounds
-  Vec2 undockedTopLeft;
-  Vec2 undockedBottomRight;
   bool hasUndocked = false;
 
   // Calculate bounds for undocked children
-  for (auto child : _children)
+  for (Control *child : _children)
   {
     if (!child->isVisible()) continue;
 
@@ -185,15 +349,15 @@ void Control::updateContentSize()
           if (!hasUndocked)
           {
             hasUndocked = true;
-            undockedTopLeft = Vec2(rect.x, rect.y);
-            undockedBottomRight = Vec2(rect.x + rect.width, rect.y + rect.height);
+            lc.undockedTopLeft = Vec2(rect.x, rect.y);
+            lc.undockedBottomRight = Vec2(rect.x + rect.width, rect.y + rect.height);
           }
           else
           {
-            undockedTopLeft.x = minimum(undockedTopLeft.x, rect.x);
-            undockedTopLeft.y = minimum(undockedTopLeft.y, rect.y);
-            undockedBottomRight.x = maximum(undockedBottomRight.x, rect.x + rect.width);
-            undockedBottomRight.y = maximum(undockedBottomRight.y, rect.y + rect.height);
+            lc.undockedTopLeft.x = minimum(lc.undockedTopLeft.x, rect.x);
+            lc.undockedTopLeft.y = minimum(lc.undockedTopLeft.y, rect.y);
+            lc.undockedBottomRight.x = maximum(lc.undockedBottomRight.x, rect.x + rect.width);
+            lc.undockedBottomRight.y = maximum(lc.undockedBottomRight.y, rect.y + rect.height);
           }
         }
       }
@@ -204,7 +368,10 @@ void Control::updateContentSize()
     }
   }
 
-  for (auto child : _children)
+  Borders &dockingBorders = lc.docking;
+  Vec2 &minimumDockingSize = lc.minimumDockingSize;
+
+  for (Control *child : _children)
   {
     if (!child->isVisible()) continue;
 
@@ -246,6 +413,22 @@ void Control::updateContentSize()
     }
   }
 
+  lc.valid = true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Control::updateContentSize()
+{
+  if (!_layoutConstraints.valid)
+    measureChildren();
+
+  const Borders &dockingBorders = _layoutConstraints.docking;
+  const Vec2 &minimumDockingSize = _layoutConstraints.minimumDockingSize;
+  const Vec2 &undockedTopLeft = _layoutConstraints.undockedTopLeft;
+  const Vec2 &undockedBottomRight = _layoutConstraints.undockedBottomRight;
+
+  _contentRect = Rect(0, 0, _rect.width - _padding.getHorizontal(), _rect.height - _padding.getVertical() - _titleHeight);
+
   _undockedOffset.x = dockingBorders.left;
   _undockedOffset.y = dockingBorders.top;
   
@@ -265,9 +448,6 @@ void Control::updateContentSize()
   if (undockedBottomRight.y > contentBottomRight.y)
     _contentRect.height += undockedBottomRight.y - contentBottomRight.y;
 
-  undockedTopLeft += _undockedOffset;
-  undockedBottomRight += _undockedOffset;
-
   if (minimumDockingSize.x)
     _contentRect.width = maximum(maximum(_contentRect.width, minimumDockingSize.x), dockingBorders.getHorizontal());
   else
@@ -280,17 +460,17 @@ void Control::updateContentSize()
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool Control::arrangeChildren()
+void Control::arrangeChildren()
 {
+  NUI_PROFILE_SCOPE(Layout);
+
   updateContentSize();
 
-  bool needsRearranging = false;
-  
   // Rectangular are that is being "redistributed" between child controls
   Rect rect = _contentRect;
 
   // Dock children
-  for (auto child : _children)
+  for (Control *child : _children)
   {
     if (!child->isVisible()) continue;
 
@@ -306,7 +486,7 @@ bool Control::arrangeChildren()
         r.y = rect.y;
         r.width = rect.width;
         r.height = r.height;
-        needsRearranging |= r.ensureMinimumSize(m);
+        r.ensureMinimumSize(m);
         rect.shrinkVertical(r.height + margins.bottom);
       }
       break;
@@ -317,7 +497,7 @@ bool Control::arrangeChildren()
         r.y = rect.y;
         r.width = r.width;
         r.height = rect.height;
-        needsRearranging |= r.ensureMinimumSize(m);
+        r.ensureMinimumSize(m);
         rect.width -= r.width + margins.left;
       }
       break;
@@ -328,7 +508,7 @@ bool Control::arrangeChildren()
         r.y = rect.y + rect.height - r.height;
         r.width = rect.width;
         r.height = r.height;
-        needsRearranging |= r.ensureMinimumSize(m);
+        r.ensureMinimumSize(m);
         rect.height -= r.height + margins.top;
       }
       break;
@@ -339,7 +519,7 @@ bool Control::arrangeChildren()
         r.y = rect.y;
         r.width = r.width;
         r.height = rect.height;
-        needsRearranging |= r.ensureMinimumSize(m);
+        r.ensureMinimumSize(m);
         rect.shrinkHorizontal(r.width + margins.right);
       }
       break;
@@ -352,7 +532,7 @@ bool Control::arrangeChildren()
   }
 
   // Position undocked children
-  for (auto child : _children)
+  for (Control *child : _children)
   {
     if (!child->isVisible()) continue;
 
@@ -367,7 +547,7 @@ bool Control::arrangeChildren()
         r.y = 0;
         r.width = rect.width;
         r.height = rect.height;
-        needsRearranging |= r.ensureMinimumSize(m);
+        r.ensureMinimumSize(m);
       }
       break;
 
@@ -377,23 +557,88 @@ bool Control::arrangeChildren()
 
     child->setRect(r);
   }
-
-  return needsRearranging;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void Control::tick(double time, double delta)
 {
+  ++_tickStats.visited;
+
   if (_dirty)
   {
-    if (arrangeChildren())
-      arrangeChildren();
+    ++_tickStats.arranged;
+
+    // Constraints have been measured already, a single arrangement is final
+    arrangeChildren();
 
     _dirty = false;
+
+    // Arranging might have changed any of the children
+    _subtreeDirty = true;
+  }
+
+  if (!_subtreeDirty)
+    return;
+
+  for (Control *child : _children)
+  {
+    if (child->_dirty || child->_subtreeDirty)
+      child->tick(time, delta);
+  }
+
+  // Children may have been marked again while ticking, keep them for the next frame
+  _subtreeDirty = false;
+
+  for (Control *child : _children)
+  {
+    if (child->_dirty || child->_subtreeDirty)
+    {
+      _subtreeDirty = true;
+      break;
+    }
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Control::releasePaintedArea()
+{
+  // Descendants' flags are cleared too, a stale one would stop the next invalidate() from reaching the ancestors
+  bool subtreeRepaint = _subtreeRepaint;
+  _subtreeRepaint = false;
+
+  if (!_paintedRect.isEmpty())
+  {
+    Control *top = this;
+    while (top->_parent)
+      top = top->_parent;
+
+    if (top->is(Type::Root))
+      static_cast<Root *>(top)->addDamage(_paintedRect);
+
+    _paintedRect = Rect(0, 0, 0, 0);
+    _repaint = true;
   }
+  else if (!subtreeRepaint)
+    return;
+
+  // Children are always painted inside of the parent's area, so it's enough to forget them
+  for (Control *child : _children)
+    child->releasePaintedArea();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Control::damage(const Rect &rect)
+{
+  Control *top = this;
+  while (top->_parent)
+    top = top->_parent;
+
+  if (!top->is(Type::Root))
+    return;
 
-  for (auto child : _children)
-    child->tick(time, delta);
+  // Painted area is clipped by the parents already
+  Vec2 position = getAbsolutePosition();
+  static_cast<Root *>(top)->addDamage(Rect(position.x + rect.x, position.y + rect.y, rect.width, rect.height) * _paintedRect);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -401,15 +646,11 @@ void Control::bringToFront()
 {
   if (!_parent) return;
 
-  Control::Ptr self = this;
-  size_t parentIndex = 0;
-  for (auto child : _parent->_children)
-    if (child == this) break; else ++parentIndex;
+  invalidate();
+  _parent->invalidateHitIndex();
+  ++_layoutGeneration;
 
-  for (size_t i = parentIndex, S = _parent->_children.size() - 1; i < S; ++i)
-    _parent->_children[i] = _parent->_children[i + 1];
-
-  _parent->_children.back() = self;
+  _parent->_children.moveToBack(_parent->_children.indexOf(this));
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -417,7 +658,7 @@ void Control::autoSize(bool recursive)
 {
   if (recursive)
   {
-    for (auto child : _children)
+    for (Control *child : _children)
     {
       if (!child->isVisible()) continue;
 
@@ -434,12 +675,19 @@ void Control::processEvent(Event &e, bool propagateUp, bool propagateDown)
 {
   if (propagateDown && !_children.empty())
   {
-    for (auto child : _children)
+    for (Control *child : _children)
       child->processEvent(e, false, true);
   }
 
-  if (propagateUp && _parent)
-    _parent->processEvent(e, true, false);
+  if (propagateUp)
+  {
+    Control *target = _parent;
+    while (target && !(target->_eventMask & Event::getTypeBit(e.type)))
+      target = target->_parent;
+
+    if (target)
+      target->processEvent(e, true, false);
+  }
 }
 
 }
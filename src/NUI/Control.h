@@ -2,6 +2,11 @@
 
 #include "Graphics.h"
 #include "Events.h"
+#include "HitGrid.h"
+#include "Profiler.h"
+#include "ControlPool.h"
+
+#include <memory>
 
 #if !defined(NUI_CONTROL)
 #define NUI_CONTROL(type, super) \
@@ -70,9 +75,15 @@ class Control : public Object
       TextBox,
       TreeView,
       Window,
+      ProfilerOverlay,
     };
 
     virtual Type getType() const { return Type::Unknown; }
+
+    // Controls are allocated from the ControlPool of the Root being built or ticked
+    static void *operator new(size_t size) { return ControlPool::allocate(size); }
+
+    static void operator delete(void *ptr) { ControlPool::deallocate(ptr); }
     
     bool is(Type type) const { return getType() == type; }
 
@@ -96,6 +107,9 @@ class Control : public Object
       PostDraw = Draw << 1,
       NeedsTextInput = PostDraw << 1,
       Flat = NeedsTextInput << 1,
+
+      // Content changes every frame, control is repainted by each draw and its output is never cached
+      Volatile = Flat << 1,
     };
 
     void setFlags(unsigned flags)
@@ -113,31 +127,78 @@ class Control : public Object
 
     void removeFlags(unsigned flags) { setFlags(_flags & ~flags); }
 
+    // Marks control's layout (and paint) as outdated, costs O(depth) as only ancestors are notified
     void setDirty(bool set = true)
     {
-      if (_dirty != set)
+      if (!set)
       {
-        _dirty = set;
+        _dirty = false;
+        return;
+      }
 
-        if (set)
-        {
-          if (_parent)
-            _parent->_dirty = true;
-        }
+      _dirty = true;
+      _repaint = true;
+      _drawCache.valid = false;
+      ++_layoutGeneration;
+      invalidateHitIndex();
+
+      if (_parent)
+      {
+        // Parent's measurement and arrangement depend on this control
+        _parent->_dirty = true;
+        _parent->_layoutConstraints.valid = false;
+        _parent->invalidateHitIndex();
 
-        for (auto child : _children)
-          child->setDirty(set);
+        for (Control *c = _parent; c && !c->_subtreeDirty; c = c->_parent)
+          c->_subtreeDirty = true;
+
+        for (Control *c = _parent; c && !c->_subtreeRepaint; c = c->_parent)
+          c->_subtreeRepaint = true;
       }
     }
 
     bool getDirty() const { return _dirty; }
 
+    // Makes the next Root::tick() visit this control even if its layout is up to date, has to be repeated for every
+    // frame the control wants to be ticked in
+    void scheduleTick()
+    {
+      for (Control *c = this; c && !c->_subtreeDirty; c = c->_parent)
+        c->_subtreeDirty = true;
+    }
+
+    // Some descendant has to be updated during next tick()
+    bool getSubtreeDirty() const { return _subtreeDirty; }
+
+    // Schedules repaint of the area covered by this control (and everything drawn on top of it)
+    void invalidate()
+    {
+      _repaint = true;
+      _drawCache.valid = false;
+
+      for (Control *c = _parent; c && !c->_subtreeRepaint; c = c->_parent)
+        c->_subtreeRepaint = true;
+    }
+
+    bool needsRepaint() const { return _repaint; }
+
+    // Repaints a part of the control (local coordinates) keeping its cached drawing, for things painted by postDraw()
+    void damage(const Rect &rect);
+
+    // Blinking phase of the text cursor changed, controls drawing the cursor in postDraw() damage just its area
+    virtual void invalidateCursor() { invalidate(); }
+
+    // Absolute screen area this control covered when it was painted last time
+    const Rect &getPaintedRect() const { return _paintedRect; }
+
     void setParent(Control *parent)
     {
       Control::Ptr p = _parent;
 
       if (p != parent)
       {
+        releasePaintedArea();
+
         _parent = parent;
         setDirty();
 
@@ -149,9 +210,12 @@ class Control : public Object
         if (p)
           p->removeChild(this);
 
-        Event e(Event::Type::ParentChanged, this);
-        e.parentChanged.oldParent = p;
-        processEvent(e);
+        if (hasEventHandler(Event::Type::ParentChanged))
+        {
+          Event e(Event::Type::ParentChanged, this);
+          e.parentChanged.oldParent = p;
+          processEvent(e);
+        }
       }
     }
 
@@ -173,7 +237,7 @@ class Control : public Object
 
     Control *getChild(size_t index) const { return _children[index]; }
     
-    typedef std::vector<Control::Ptr> Children;
+    typedef PtrVector<Control> Children;
 
     Children::const_iterator begin() const { return _children.begin(); }
 
@@ -211,9 +275,16 @@ class Control : public Object
       }
     }
 
-    const std::string &getText() const { return _text; }
+    virtual const std::string &getText() const { return _text; }
 
-    void setIcon(int iconID) { _icon = iconID; }
+    void setIcon(int iconID)
+    {
+      if (_icon != iconID)
+      {
+        _icon = iconID;
+        invalidate();
+      }
+    }
 
     int getIcon() const { return _icon; }
 
@@ -374,7 +445,20 @@ class Control : public Object
 
     ControlPointInfo controlAtPoint(int x, int y);
 
-    void setStyle(Graphics::Style *style) { _style = style; }
+    // Same as above, shrinks stableArea (local coordinates) to a part where the result stays the same
+    ControlPointInfo controlAtPoint(int x, int y, Rect &stableArea);
+
+    // Incremented whenever layout of any control changes
+    static unsigned getLayoutGeneration() { return _layoutGeneration; }
+
+    void setStyle(Graphics::Style *style)
+    {
+      if (_style != style)
+      {
+        _style = style;
+        invalidate();
+      }
+    }
 
     Graphics::Style *getStyle(bool recursive = false) const
     {
@@ -399,14 +483,56 @@ class Control : public Object
 
     virtual void autoSize(bool recursive = false);
 
+    // Runs autoSize(true) during the next measure pass, repeated requests within a frame are merged
+    void requestAutoSize()
+    {
+      _autoSizePending = true;
+      setDirty();
+    }
+
+    // Events bubbling up skip ancestors that are not subscribed to their type, controls overriding processEvent()
+    // have to subscribe to all event types they handle
     virtual void processEvent(Event &e, bool propagateUp = true, bool propagateDown = false);
 
+    void subscribe(Event::Type type) { _eventMask |= Event::getTypeBit(type); }
+
+    void unsubscribe(Event::Type type) { _eventMask &= ~Event::getTypeBit(type); }
+
+    bool isSubscribed(Event::Type type) const { return (_eventMask & Event::getTypeBit(type)) != 0; }
+
+    // Returns true if this control or any of its ancestors is subscribed to given event type
+    bool hasEventHandler(Event::Type type) const
+    {
+      for (const Control *c = this; c; c = c->_parent)
+        if (c->_eventMask & Event::getTypeBit(type))
+          return true;
+
+      return false;
+    }
+
   protected:
-    virtual ~Control() { }
+    virtual ~Control() { nvgDeleteRecording(_drawCache.recording); }
 
-    void addState(unsigned state) { _state |= state; }
+    // States only change how the control is painted, layout and hit testing are not affected
+    void addState(unsigned state)
+    {
+      if ((_state & state) != state)
+      {
+        _state |= state;
+        invalidate();
+      }
+    }
+
+    void removeState(unsigned state)
+    {
+      if (_state & state)
+      {
+        _state &= ~state;
+        invalidate();
+      }
+    }
 
-    void removeState(unsigned state) { _state &= ~state; }
+    void releasePaintedArea();
 
     void addChild(Control *child)
     {
@@ -416,33 +542,141 @@ class Control : public Object
 
     void removeChild(Control *child)
     {
-      for (auto iter = _children.begin(); iter != _children.end(); ++iter)
+      size_t index = _children.indexOf(child);
+
+      if (index < _children.size())
       {
-        if ((*iter) == child)
-        {
-          _children.erase(iter);
-          setDirty();
-          return;        
-        }
+        _children.erase(index);
+        setDirty();
       }
     }
 
+    Control *childAtPoint(int x, int y, Rect &stableArea, Vec2 &origin);
+
+    // Hit testing group of a child (HitIndex::Group), -1 if it's never hit
+    static int getHitGroup(const Control *child);
+
+    void invalidateHitIndex()
+    {
+      if (_hitIndex)
+        _hitIndex->valid = false;
+    }
+
+    void updateHitIndex();
+
     void clampResizeStep(int &dx, int &dy) const;
 
+    // Measure pass, bottom-up over dirty subtrees: runs pending autoSize() requests and refreshes constraints
+    void measure();
+
+    // Collects space required by children into _layoutConstraints
+    void measureChildren();
+
+    // Content rectangle and undocked offset from current size and (cached) constraints
     void updateContentSize();
 
-    bool arrangeChildren();
+    // Arrange pass of a single control, places docked children, called from tick()
+    void arrangeChildren();
 
     void resizeStep(int dx, int dy);
 
     void resizeStepChildren(int dx, int dy);
 
-    // Control has been changed and not updated yet
+    struct TickStats
+    {
+      unsigned visited = 0;
+      unsigned measured = 0;
+      unsigned arranged = 0;
+    };
+
+    // Work done by tick() since the last reset, collected by Root
+    static TickStats _tickStats;
+
+    static unsigned _layoutGeneration;
+
+    // Children are hit tested through a grid once there are this many of them
+    enum
+    {
+      HitIndexMinChildren = 16
+    };
+
+    // Visible children by hit testing order, rebuilt lazily after any of them changes
+    struct HitIndex
+    {
+      enum Group
+      {
+        Docked = 0,
+        Undocked,
+        ParentClipped,
+        Count
+      };
+
+      HitGrid groups[Count];
+      bool valid = false;
+    };
+
+    std::unique_ptr<HitIndex> _hitIndex;
+
+    // Space required by children, kept until any of them changes
+    struct LayoutConstraints
+    {
+      Borders docking;
+      Vec2 minimumDockingSize;
+      Vec2 undockedTopLeft;
+      Vec2 undockedBottomRight;
+      bool valid = false;
+    };
+
+    LayoutConstraints _layoutConstraints;
+
+    // Output of draw() replayed while nothing it depends on changes
+    struct DrawCache
+    {
+      NVGrecording *recording = nullptr;
+      bool valid = false;
+
+      Vec2 size;
+      unsigned state = 0;
+      const Graphics::Style *style = nullptr;
+      RGBColor color;
+      RGBColor secondaryColor;
+      RGBColor textColor;
+      int textSize = 0;
+      float alpha = 1.0f;
+    };
+
+    DrawCache _drawCache;
+
+    // Control's layout has been changed and not updated yet
     bool _dirty = true;
 
+    // Some descendant is dirty, clean subtrees are skipped by measure() and tick()
+    bool _subtreeDirty = false;
+
+    // autoSize() has been requested and not run yet
+    bool _autoSizePending = false;
+
+    // Control has to be repainted
+    bool _repaint = true;
+
+    // Absolute screen area covered by the last paint (clipped by parents)
+    Rect _paintedRect = Rect(0, 0, 0, 0);
+
+    // Some child has to update its painted area, clean subtrees are skipped by Root::updatePaintedRects()
+    bool _subtreeRepaint = true;
+
+    // Offsets and clipping the children got from the last Root::updatePaintedRects()
+    Vec2 _paintedContentOffset;
+    Vec2 _paintedUndockedOffset;
+    Rect _paintedControlClip = Rect(0, 0, 0, 0);
+    Rect _paintedContentClip = Rect(0, 0, 0, 0);
+
     // General control flags
     unsigned _flags = Control::Visible | Control::Enabled | Control::Draw;
 
+    // Event types handled by processEvent() (see Event::getTypeBit())
+    unsigned _eventMask = 0;
+
     // Text/title string
     std::string _text = "";
 
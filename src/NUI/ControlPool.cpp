@@ -0,0 +1,104 @@
+#include "ControlPool.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace nui {
+
+ControlPool *ControlPool::_current = nullptr;
+
+//---------------------------------------------------------------------------------------------------------------------
+void *ControlPool::allocate(size_t size)
+{
+  size_t sizeClass = (size + HeaderSize + Granularity - 1) / Granularity - 1;
+
+  if (_current && sizeClass < NumSizeClasses)
+    return _current->allocateBlock(sizeClass);
+
+  Header *header = static_cast<Header *>(::operator new(size + HeaderSize));
+  header->pool = nullptr;
+  header->sizeClass = sizeClass;
+  return reinterpret_cast<char *>(header) + HeaderSize;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ControlPool::deallocate(void *ptr)
+{
+  if (!ptr)
+    return;
+
+  Header *header = reinterpret_cast<Header *>(static_cast<char *>(ptr) - HeaderSize);
+
+  if (header->pool)
+    header->pool->deallocateBlock(header);
+  else
+    ::operator delete(header);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ControlPool::detach()
+{
+  if (_current == this)
+    _current = nullptr;
+
+  _detached = true;
+
+  if (!_numBlocks)
+    delete this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+ControlPool::~ControlPool()
+{
+  for (void *slab : _slabs)
+    std::free(slab);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void *ControlPool::allocateBlock(size_t sizeClass)
+{
+  FreeBlock *block = _freeLists[sizeClass];
+
+  if (!block)
+  {
+    // Thread a new slab into the free list so that consecutive allocations are adjacent
+    size_t blockSize = (sizeClass + 1) * Granularity;
+    size_t count = SlabSize / blockSize;
+
+    char *slab = static_cast<char *>(std::malloc(SlabSize));
+    if (!slab)
+      throw std::bad_alloc();
+
+    _slabs.push_back(slab);
+
+    for (size_t i = count; i-- > 0;)
+    {
+      FreeBlock *b = reinterpret_cast<FreeBlock *>(slab + i * blockSize);
+      b->next = block;
+      block = b;
+    }
+  }
+
+  _freeLists[sizeClass] = block->next;
+  ++_numBlocks;
+
+  Header *header = reinterpret_cast<Header *>(block);
+  header->pool = this;
+  header->sizeClass = sizeClass;
+  return reinterpret_cast<char *>(header) + HeaderSize;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ControlPool::deallocateBlock(Header *header)
+{
+  size_t sizeClass = header->sizeClass;
+
+  FreeBlock *block = reinterpret_cast<FreeBlock *>(header);
+  block->next = _freeLists[sizeClass];
+  _freeLists[sizeClass] = block;
+
+  if (!--_numBlocks && _detached)
+    delete this;
+}
+
+}
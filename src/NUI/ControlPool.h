@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Base.h"
+
+namespace nui {
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Slab allocator for controls, each Root owns one. Blocks of the same size class are carved from shared slabs so
+// that controls created together (typically siblings) end up next to each other in memory. Controls are created and
+// destroyed on the UI thread only, pools are not thread safe.
+class ControlPool
+{
+  public:
+    ControlPool() { }
+    ControlPool(const ControlPool &) = delete;
+    ControlPool &operator=(const ControlPool &) = delete;
+
+    // Allocates from the current pool, falls back to the heap if there is none or the block is too large
+    static void *allocate(size_t size);
+
+    // Returns the block to the pool it was allocated from
+    static void deallocate(void *ptr);
+
+    // Pool used by allocate(), Root makes its pool current when it's created and at the beginning of each tick
+    static ControlPool *getCurrent() { return _current; }
+
+    static void setCurrent(ControlPool *pool) { _current = pool; }
+
+    // Called by the owner instead of delete, the pool is destroyed once all of its blocks are deallocated
+    void detach();
+
+    size_t getNumBlocks() const { return _numBlocks; }
+
+    size_t getNumSlabs() const { return _slabs.size(); }
+
+  private:
+    ~ControlPool();
+
+    enum
+    {
+      // Stores owning pool and size class of a block, keeps the payload aligned
+      HeaderSize = 16,
+      Granularity = 16,
+      MaxBlockSize = 2048,
+      SlabSize = 64 * 1024,
+      NumSizeClasses = MaxBlockSize / Granularity
+    };
+
+    struct Header
+    {
+      ControlPool *pool;
+      size_t sizeClass;
+    };
+
+    struct FreeBlock
+    {
+      FreeBlock *next;
+    };
+
+    void *allocateBlock(size_t sizeClass);
+
+    void deallocateBlock(Header *header);
+
+    FreeBlock *_freeLists[NumSizeClasses] = {};
+
+    std::vector<void *> _slabs;
+
+    size_t _numBlocks = 0;
+
+    bool _detached = false;
+
+    static ControlPool *_current;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+}
@@ -87,6 +87,9 @@ struct Event
   {
     
   }
+
+  // Bit representing given event type in control's subscription mask
+  static unsigned getTypeBit(Type type) { return 1u << static_cast<unsigned>(type); }
 };
 
 }
@@ -1,6 +1,8 @@
 #include "Graphics.h"
 #include "Control.h"
 
+#include <cmath>
+
 #ifdef _MSC_VER
 #pragma warning (disable: 4244)
 #endif
@@ -69,10 +71,35 @@ float Graphics::drawText(int x, int y, const char *text, const char *end, bool s
   return nvgText(N, x, y, text, end) - x;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+void Graphics::getGlyphQuads(const char *text, const char *end, std::vector<NVGglyphQuad> &quads, HAlign halign, VAlign valign, bool monospace)
+{
+  nvgFontSize(N, state.style->textSize);
+  nvgTextAlign(N, static_cast<unsigned>(halign) | static_cast<unsigned>(valign));
+  nvgFontFaceId(N, monospace ? monospaceFontID : normalFontID);
+
+  // At most one quad per byte
+  quads.resize(end - text);
+  quads.resize(nvgTextGlyphQuads(N, text, end, quads.data(), static_cast<int>(quads.size())));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Graphics::drawGlyphRuns(const NVGglyphRun *runs, size_t numRuns)
+{
+  drawGlyphRuns(runs, numRuns, state.style->textColor);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Graphics::drawGlyphRuns(const NVGglyphRun *runs, size_t numRuns, const RGBColor &color)
+{
+  nvgFillColor(N, color.nvg());
+  nvgDrawGlyphRuns(N, runs, static_cast<int>(numRuns));
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void Graphics::drawTextCursor(int x, int y)
 {
-  float a = 1.0f - clamp(powf(static_cast<float>(cursorBlinker), 5.0f), 0.0f, 1.0f);
+  float a = getCursorAlpha(cursorBlinker);
 
   nvgBeginPath(N);
   nvgStrokeColor(N, nvgRGBAf(1.0f, 1.0f, 1.0f, a));
@@ -82,6 +109,27 @@ void Graphics::drawTextCursor(int x, int y)
   nvgStroke(N);
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+void Graphics::drawHighlights(const Rect *rects, size_t numRects)
+{
+  if (!numRects)
+    return;
+
+  nvgBeginPath(N);
+
+  for (size_t i = 0; i < numRects; ++i)
+    nvgRect(N, rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+
+  nvgFillColor(N, state.style->secondaryColor.nvgA(0.6f));
+  nvgFill(N);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+float Graphics::getCursorAlpha(double blinker)
+{
+  return 1.0f - clamp(powf(static_cast<float>(blinker), 5.0f), 0.0f, 1.0f);
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void Graphics::drawIcon(int cx, int cy, int iconID)
 {
@@ -44,6 +44,7 @@ struct Graphics
         DefaultControlHeight = 22,
         DefaultScrollBarSize = 16,
         CheckBoxSize = 18,
+        ShadowMargin = 12,
       };
 
       RGBColor color = DefaultColor;
@@ -114,8 +115,23 @@ struct Graphics
     return drawText(x, y, text, nullptr, shadow, halign, valign, monospace);
   }
 
+  // Quads of text as drawText() would draw it at (0, 0), valid while getFontAtlasGeneration() doesn't change
+  void getGlyphQuads(const char *text, const char *end, std::vector<NVGglyphQuad> &quads, HAlign halign = HAlign::Left, VAlign valign = VAlign::Middle, bool monospace = false);
+
+  // Draws runs of quads from getGlyphQuads() in one batch
+  void drawGlyphRuns(const NVGglyphRun *runs, size_t numRuns);
+
+  void drawGlyphRuns(const NVGglyphRun *runs, size_t numRuns, const RGBColor &color);
+
+  int getFontAtlasGeneration() const { return nvgFontAtlasGeneration(nvgContext); }
+
   void drawTextCursor(int x, int y);
 
+  // Fills rectangles behind text with the secondary color
+  void drawHighlights(const Rect *rects, size_t numRects);
+
+  static float getCursorAlpha(double blinker);
+
   void drawIcon(int cx, int cy, int iconID);
 
   void drawBevel(int px, int py, int width, int height, unsigned state, Bevel type);
@@ -0,0 +1,94 @@
+#include "HitGrid.h"
+
+#include <cmath>
+
+namespace nui {
+
+//---------------------------------------------------------------------------------------------------------------------
+void HitGrid::clear()
+{
+  _entries.clear();
+  _cellItems.clear();
+  _cellStart.clear();
+  _bounds = Rect();
+  _columns = _rows = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void HitGrid::add(const Rect &rect, unsigned index)
+{
+  if (rect.isEmpty())
+    return;
+
+  Entry entry;
+  entry.rect = rect;
+  entry.index = index;
+  _entries.push_back(entry);
+
+  _bounds |= rect;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void HitGrid::build()
+{
+  _cellItems.clear();
+  _cellStart.clear();
+
+  if (_entries.empty())
+  {
+    _columns = _rows = 0;
+    return;
+  }
+
+  // Roughly one cell per entry, keeping cells close to square
+  float count = static_cast<float>(_entries.size());
+  float aspect = static_cast<float>(_bounds.width) / static_cast<float>(_bounds.height);
+
+  _columns = clamp(static_cast<int>(sqrtf(count * aspect) + 0.5f), 1, static_cast<int>(MaxCells));
+  _rows = clamp(static_cast<int>(count / static_cast<float>(_columns) + 0.5f), 1, static_cast<int>(MaxCells));
+
+  _cellSize.x = (_bounds.width + _columns - 1) / _columns;
+  _cellSize.y = (_bounds.height + _rows - 1) / _rows;
+
+  // Count entries per cell first, then fill the ranges
+  _cellStart.assign(_columns * _rows + 1, 0);
+
+  for (auto &entry : _entries)
+    forEachCell(entry.rect, [this](int cell) { ++_cellStart[cell + 1]; });
+
+  for (size_t i = 1; i < _cellStart.size(); ++i)
+    _cellStart[i] += _cellStart[i - 1];
+
+  std::vector<unsigned> fill(_cellStart.begin(), _cellStart.end() - 1);
+  _cellItems.resize(_cellStart.back());
+
+  for (unsigned id = 0; id < static_cast<unsigned>(_entries.size()); ++id)
+    forEachCell(_entries[id].rect, [this, &fill, id](int cell) { _cellItems[fill[cell]++] = id; });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const unsigned *HitGrid::query(int x, int y, size_t &count, Rect *cellRect) const
+{
+  count = 0;
+
+  if (!_columns || !_bounds.isPointInside(x, y))
+  {
+    // No entry reaches outside of the bounds
+    if (cellRect)
+      *cellRect = Rect();
+
+    return nullptr;
+  }
+
+  int column = (x - _bounds.x) / _cellSize.x;
+  int row = (y - _bounds.y) / _cellSize.y;
+  int cell = row * _columns + column;
+
+  if (cellRect)
+    *cellRect = Rect(_bounds.x + column * _cellSize.x, _bounds.y + row * _cellSize.y, _cellSize.x, _cellSize.y);
+
+  count = _cellStart[cell + 1] - _cellStart[cell];
+  return count ? &_cellItems[_cellStart[cell]] : nullptr;
+}
+
+}
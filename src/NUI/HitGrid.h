@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Base.h"
+
+namespace nui {
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Uniform grid over a set of rectangles, used to find rectangles that may contain given point
+class HitGrid
+{
+  public:
+    struct Entry
+    {
+      Rect rect;
+      unsigned index;
+    };
+
+    void clear();
+
+    void add(const Rect &rect, unsigned index);
+
+    // Distributes all added entries to grid cells, has to be called before query()
+    void build();
+
+    // Returns entries overlapping the cell with given point in order they were added, cellRect receives cell's
+    // bounds or an empty rectangle if the point is outside of all entries
+    const unsigned *query(int x, int y, size_t &count, Rect *cellRect = nullptr) const;
+
+    const Entry &getEntry(unsigned id) const { return _entries[id]; }
+
+    const Rect &getBounds() const { return _bounds; }
+
+    bool isEmpty() const { return _entries.empty(); }
+
+  private:
+    enum
+    {
+      MaxCells = 64
+    };
+
+    // Calls callback(cell) for every cell the rectangle overlaps
+    template <typename Callback>
+    void forEachCell(const Rect &r, Callback &&callback) const
+    {
+      int x1 = (r.x - _bounds.x) / _cellSize.x;
+      int y1 = (r.y - _bounds.y) / _cellSize.y;
+      int x2 = minimum((r.x + r.width - 1 - _bounds.x) / _cellSize.x, _columns - 1);
+      int y2 = minimum((r.y + r.height - 1 - _bounds.y) / _cellSize.y, _rows - 1);
+
+      for (int y = y1; y <= y2; ++y)
+        for (int x = x1; x <= x2; ++x)
+          callback(y * _columns + x);
+    }
+
+    std::vector<Entry> _entries;
+
+    // Entry IDs of all cells, cell i owns range [_cellStart[i], _cellStart[i + 1])
+    std::vector<unsigned> _cellItems;
+    std::vector<unsigned> _cellStart;
+
+    Rect _bounds;
+    Vec2 _cellSize;
+    int _columns = 0;
+    int _rows = 0;
+};
+
+}
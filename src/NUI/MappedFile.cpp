@@ -0,0 +1,142 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nui {
+
+#if defined(_WIN32)
+
+//---------------------------------------------------------------------------------------------------------------------
+bool MappedFile::open(const std::string &fileName)
+{
+  close();
+
+  // Write access isn't shared so that the file can't change under the mapping
+  HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || static_cast<unsigned long long>(size.QuadPart) > static_cast<size_t>(-1))
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  _file = file;
+  _size = static_cast<size_t>(size.QuadPart);
+  _open = true;
+
+  // Empty files can't be mapped
+  if (!_size)
+    return true;
+
+  _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  _data = _mapping ? static_cast<const char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+
+  if (!_data)
+  {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void MappedFile::close()
+{
+  if (_data)
+    UnmapViewOfFile(_data);
+
+  if (_mapping)
+    CloseHandle(_mapping);
+
+  if (_file)
+    CloseHandle(_file);
+
+  _data = nullptr;
+  _mapping = nullptr;
+  _file = nullptr;
+  _size = 0;
+  _open = false;
+}
+
+#else
+
+//---------------------------------------------------------------------------------------------------------------------
+bool MappedFile::open(const std::string &fileName)
+{
+  close();
+
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+  {
+    ::close(fd);
+    return false;
+  }
+
+  _fd = fd;
+  _size = static_cast<size_t>(st.st_size);
+  _open = true;
+
+  // Empty files can't be mapped
+  if (!_size)
+    return true;
+
+  void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if (data == MAP_FAILED)
+  {
+    close();
+    return false;
+  }
+
+  _data = static_cast<const char *>(data);
+
+  // Refuses files whose size changed while they were being mapped, later truncation can't be prevented
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != _size)
+  {
+    close();
+    return false;
+  }
+
+  madvise(data, _size, MADV_SEQUENTIAL);
+
+  return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void MappedFile::close()
+{
+  if (_data)
+    munmap(const_cast<char *>(_data), _size);
+
+  if (_fd >= 0)
+    ::close(_fd);
+
+  _data = nullptr;
+  _fd = -1;
+  _size = 0;
+  _open = false;
+}
+
+#endif
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Base.h"
+
+namespace nui {
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Whole file mapped read-only into memory, pages are loaded by the OS when they are touched for the first time. On
+// Windows other processes can't write the file while it's open. POSIX has no such lock, a file truncated by another
+// process while mapped raises SIGBUS when pages past its new end are read, so only files nobody else writes should
+// be mapped.
+class MappedFile
+{
+  public:
+    MappedFile() { }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string &fileName);
+
+    void close();
+
+    bool isOpen() const { return _open; }
+
+    const char *getData() const { return _data; }
+
+    size_t getSize() const { return _size; }
+
+  private:
+    const char *_data = nullptr;
+    size_t _size = 0;
+    bool _open = false;
+
+#if defined(_WIN32)
+    void *_file = nullptr;
+    void *_mapping = nullptr;
+#else
+    int _fd = -1;
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+}
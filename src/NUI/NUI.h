@@ -6,6 +6,7 @@
 #include "controls/CheckBox.h"
 #include "controls/ListBox.h"
 #include "controls/Menu.h"
+#include "controls/ProfilerOverlay.h"
 #include "controls/Root.h"
 #include "controls/ScrollBar.h"
 #include "controls/TextBox.h"
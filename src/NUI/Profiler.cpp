@@ -0,0 +1,155 @@
+#include "Profiler.h"
+
+#if defined(NUI_PROFILER)
+
+#include "Control.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+namespace nui {
+
+//---------------------------------------------------------------------------------------------------------------------
+Profiler::Scope::Scope(Section section)
+  : _section(section)
+  , _start(0.0)
+{
+  // Only the outermost scope is measured, layout functions call each other recursively
+  if (get()._depth[static_cast<size_t>(section)]++ == 0)
+    _start = getTime();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+Profiler::Scope::~Scope()
+{
+  Profiler &profiler = get();
+
+  if (--profiler._depth[static_cast<size_t>(_section)] == 0)
+    profiler.addTime(_section, getTime() - _start);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+Profiler &Profiler::get()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+double Profiler::getTime()
+{
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration<double, std::milli>(now).count();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const char *Profiler::getSectionName(Section section)
+{
+  static const char *names[] = { "tick", "layout", "draw", "endFrame", "flush" };
+  return names[static_cast<size_t>(section)];
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const char *Profiler::getCounterName(Counter counter)
+{
+  static const char *names[] =
+  {
+    "renderCalls", "drawCalls", "paths", "vertices", "textureUploads",
+    "controlsTicked", "controlsMeasured", "controlsArranged", "controlsPainted", "controlsReplayed"
+  };
+
+  return names[static_cast<size_t>(counter)];
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Profiler::beginFrame()
+{
+  _frames[_nextFrame] = _frame;
+  _nextFrame = (_nextFrame + 1) % MaxFrames;
+  _numFrames = minimum(_numFrames + 1, static_cast<size_t>(MaxFrames));
+
+  unsigned index = _frame.index + 1;
+  _frame = Frame();
+  _frame.index = index;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Profiler::addControlCost(const Control *control, double time)
+{
+  unsigned &count = _frame.numControlCosts;
+
+  if (count == MaxControlCosts && _frame.controlCosts[count - 1].time >= time)
+    return;
+
+  // Insertion into the list sorted by time, the cheapest entry falls out when full
+  unsigned i = (count < MaxControlCosts) ? count++ : count - 1;
+
+  for (; i > 0 && _frame.controlCosts[i - 1].time < time; --i)
+    _frame.controlCosts[i] = _frame.controlCosts[i - 1];
+
+  ControlCost &cost = _frame.controlCosts[i];
+  cost.control = control;
+  cost.type = static_cast<int>(control->getType());
+  cost.time = time;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+std::string Profiler::getJSON() const
+{
+  std::string json = "{\n  \"frames\": [";
+  char buffer[128];
+
+  for (size_t f = _numFrames; f-- > 0;)
+  {
+    const Frame &frame = getFrame(f);
+
+    snprintf(buffer, sizeof(buffer), "%s\n    {\n      \"index\": %u,\n      \"times\": {", (f + 1 < _numFrames) ? "," : "", frame.index);
+    json += buffer;
+
+    for (size_t i = 0; i < static_cast<size_t>(Section::Count); ++i)
+    {
+      snprintf(buffer, sizeof(buffer), "%s \"%s\": %.4f", i ? "," : "", getSectionName(static_cast<Section>(i)), frame.times[i]);
+      json += buffer;
+    }
+
+    json += " },\n      \"counters\": {";
+
+    for (size_t i = 0; i < static_cast<size_t>(Counter::Count); ++i)
+    {
+      snprintf(buffer, sizeof(buffer), "%s \"%s\": %u", i ? "," : "", getCounterName(static_cast<Counter>(i)), frame.counters[i]);
+      json += buffer;
+    }
+
+    json += " },\n      \"controls\": [";
+
+    for (unsigned i = 0; i < frame.numControlCosts; ++i)
+    {
+      const ControlCost &cost = frame.controlCosts[i];
+
+      snprintf(buffer, sizeof(buffer), "%s { \"id\": \"%p\", \"type\": %d, \"time\": %.4f }", i ? "," : "", static_cast<const void *>(cost.control), cost.type, cost.time);
+      json += buffer;
+    }
+
+    json += " ]\n    }";
+  }
+
+  json += "\n  ]\n}\n";
+  return json;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool Profiler::saveJSON(const std::string &fileName) const
+{
+  std::ofstream ofs(fileName.c_str(), std::ios_base::binary);
+
+  if (!ofs.is_open())
+    return false;
+
+  ofs << getJSON();
+  return ofs.good();
+}
+
+}
+
+#endif
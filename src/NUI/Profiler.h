@@ -0,0 +1,165 @@
+#pragma once
+
+#include "Base.h"
+
+// Profiling is compiled in only when NUI_PROFILER is defined (Debug configuration), otherwise all NUI_PROFILE_*
+// macros expand to nothing
+#if defined(NUI_PROFILER)
+
+namespace nui {
+
+class Control;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Keeps timings and counters of the last MaxFrames frames
+class Profiler
+{
+  public:
+    // Sections may overlap, layout is mostly done inside of Root::tick()
+    enum class Section
+    {
+      Tick = 0,
+      Layout,
+      Draw,
+      EndFrame,
+      Flush,
+      Count
+    };
+
+    enum class Counter
+    {
+      RenderCalls = 0,
+      DrawCalls,
+      Paths,
+      Vertices,
+      TextureUploads,
+      ControlsTicked,
+      ControlsMeasured,
+      ControlsArranged,
+      ControlsPainted,
+      ControlsReplayed,
+      Count
+    };
+
+    enum
+    {
+      MaxFrames = 256,
+      MaxControlCosts = 8
+    };
+
+    struct ControlCost
+    {
+      // Used only to tell controls apart, may point to an already deleted control
+      const Control *control;
+      int type;
+      double time;
+    };
+
+    struct Frame
+    {
+      unsigned index = 0;
+
+      // Milliseconds
+      double times[static_cast<size_t>(Section::Count)] = {};
+
+      unsigned counters[static_cast<size_t>(Counter::Count)] = {};
+
+      // Most expensive draw() calls, sorted from the slowest one
+      ControlCost controlCosts[MaxControlCosts];
+      unsigned numControlCosts = 0;
+
+      double getTime(Section section) const { return times[static_cast<size_t>(section)]; }
+
+      unsigned getCounter(Counter counter) const { return counters[static_cast<size_t>(counter)]; }
+    };
+
+    // Measures time spent in given section, nested scopes of the same section are not counted twice
+    class Scope
+    {
+      public:
+        explicit Scope(Section section);
+
+        ~Scope();
+
+      private:
+        Section _section;
+        double _start;
+    };
+
+    // Measures time spent drawing given control
+    class ControlScope
+    {
+      public:
+        explicit ControlScope(const Control *control)
+          : _control(control)
+          , _start(getTime())
+        {
+        }
+
+        ~ControlScope() { get().addControlCost(_control, getTime() - _start); }
+
+      private:
+        const Control *_control;
+        double _start;
+    };
+
+    static Profiler &get();
+
+    // Monotonic time in milliseconds
+    static double getTime();
+
+    static const char *getSectionName(Section section);
+
+    static const char *getCounterName(Counter counter);
+
+    // Stores the frame measured so far in the ring buffer and starts a new one
+    void beginFrame();
+
+    void addTime(Section section, double time) { _frame.times[static_cast<size_t>(section)] += time; }
+
+    void setCounter(Counter counter, unsigned value) { _frame.counters[static_cast<size_t>(counter)] = value; }
+
+    void addControlCost(const Control *control, double time);
+
+    size_t getNumFrames() const { return _numFrames; }
+
+    // Returns a completed frame, index 0 is the most recent one
+    const Frame &getFrame(size_t index) const { return _frames[(_nextFrame + MaxFrames - 1 - index) % MaxFrames]; }
+
+    // All completed frames from the oldest one
+    std::string getJSON() const;
+
+    bool saveJSON(const std::string &fileName) const;
+
+  private:
+    Frame _frames[MaxFrames];
+
+    size_t _numFrames = 0;
+
+    size_t _nextFrame = 0;
+
+    // Frame being measured
+    Frame _frame;
+
+    // Nesting of active scopes per section
+    int _depth[static_cast<size_t>(Section::Count)] = {};
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace nui
+
+#define NUI_PROFILE_BEGIN_FRAME() nui::Profiler::get().beginFrame()
+#define NUI_PROFILE_SCOPE(section) nui::Profiler::Scope nuiProfileScope(nui::Profiler::Section::section)
+#define NUI_PROFILE_CONTROL(control) nui::Profiler::ControlScope nuiProfileControlScope(control)
+#define NUI_PROFILE_COUNTER(counter, value) nui::Profiler::get().setCounter(nui::Profiler::Counter::counter, value)
+
+#else
+
+#define NUI_PROFILE_BEGIN_FRAME()
+#define NUI_PROFILE_SCOPE(section)
+#define NUI_PROFILE_CONTROL(control)
+#define NUI_PROFILE_COUNTER(counter, value)
+
+#endif
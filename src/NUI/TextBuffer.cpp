@@ -0,0 +1,749 @@
+#include "TextBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#define NUI_TEXT_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NUI_TEXT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace nui {
+
+//---------------------------------------------------------------------------------------------------------------------
+static unsigned countTrailingZeros(unsigned mask)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Appends positions of all '\n' characters, 32 bytes are compared at once and only set bits of the mask are visited
+static void findLineBreaks(const char *text, size_t length, size_t base, std::vector<size_t> &breaks)
+{
+  size_t i = 0;
+
+#if defined(NUI_TEXT_AVX2)
+  const __m256i newLine = _mm256_set1_epi8('\n');
+
+  for (; i + 32 <= length; i += 32)
+  {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newLine)));
+
+    for (; mask; mask &= mask - 1)
+      breaks.push_back(base + i + countTrailingZeros(mask));
+  }
+#elif defined(NUI_TEXT_SSE2)
+  const __m128i newLine = _mm_set1_epi8('\n');
+
+  for (; i + 32 <= length; i += 32)
+  {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + 16));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, newLine))) |
+      (static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, newLine))) << 16);
+
+    for (; mask; mask &= mask - 1)
+      breaks.push_back(base + i + countTrailingZeros(mask));
+  }
+#endif
+
+  for (; i < length; ++i)
+  {
+    if (text[i] == '\n')
+      breaks.push_back(base + i);
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Indexes given range in chunks on the calling thread so that it can be cancelled. Returns false if cancelled.
+static bool indexLineBreaksSerial(const char *data, size_t begin, size_t end, std::vector<size_t> &breaks, const std::atomic<bool> *cancel, size_t chunkSize)
+{
+  for (size_t offset = begin; offset < end; offset += chunkSize)
+  {
+    if (cancel && *cancel)
+      return false;
+
+    findLineBreaks(data + offset, minimum(chunkSize, end - offset), offset, breaks);
+  }
+
+  return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Large ranges are split once between worker threads, the calling thread indexing the first part, and their results
+// are merged in order. Returns false if cancelled.
+static bool indexLineBreaks(const char *data, size_t begin, size_t end, std::vector<size_t> &breaks, const std::atomic<bool> *cancel, size_t chunkSize)
+{
+  size_t numThreads = minimum(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(TextBuffer::MaxIndexThreads));
+
+  if (numThreads <= 1 || end - begin < TextBuffer::ParallelIndexMinSize)
+    return indexLineBreaksSerial(data, begin, end, breaks, cancel, chunkSize);
+
+  size_t partSize = (end - begin + numThreads - 1) / numThreads;
+  std::vector<std::vector<size_t>> parts(numThreads - 1);
+  std::vector<std::thread> threads;
+
+  for (size_t t = 1; t < numThreads; ++t)
+  {
+    size_t partBegin = minimum(begin + t * partSize, end);
+    size_t partEnd = minimum(partBegin + partSize, end);
+    std::vector<size_t> &part = parts[t - 1];
+
+    threads.emplace_back([data, partBegin, partEnd, &part, cancel, chunkSize]()
+    {
+      indexLineBreaksSerial(data, partBegin, partEnd, part, cancel, chunkSize);
+    });
+  }
+
+  bool completed = indexLineBreaksSerial(data, begin, minimum(begin + partSize, end), breaks, cancel, chunkSize);
+
+  size_t total = breaks.size();
+  for (size_t t = 0; t < threads.size(); ++t)
+  {
+    threads[t].join();
+    total += parts[t].size();
+  }
+
+  if (!completed || (cancel && *cancel))
+    return false;
+
+  breaks.reserve(total);
+  for (auto &part : parts)
+    breaks.insert(breaks.end(), part.begin(), part.end());
+
+  return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::clear()
+{
+  stopIndexing();
+
+  _original.clear();
+  _originalFile.close();
+  _originalData = _original.data();
+  _originalBreaks.clear();
+  _added.clear();
+  _addedBreaks.clear();
+
+  _nodes.assign(1, Node());
+  _freeNodes.clear();
+  _root = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::setText(const char *text, size_t length)
+{
+  std::string original(text, length);
+  setOriginal(original);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::compact()
+{
+  waitForIndex();
+
+  std::string text = getText();
+  setOriginal(text);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::setOriginal(std::string &text)
+{
+  clear();
+
+  size_t length = text.length();
+  _original.swap(text);
+  _originalData = _original.data();
+  indexLineBreaks(_originalData, 0, length, _originalBreaks, nullptr, length);
+
+  if (length)
+    _root = createNode(Original, 0, length);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextBuffer::loadFile(const std::string &fileName)
+{
+  clear();
+
+  if (!_originalFile.open(fileName))
+    return false;
+
+  const char *data = _originalData = _originalFile.getData();
+  size_t size = _originalFile.getSize();
+  size_t head = 0;
+
+  while (head < size && _originalBreaks.size() < HeadLines)
+  {
+    const char *p = static_cast<const char *>(memchr(data + head, '\n', size - head));
+    if (!p)
+    {
+      head = size;
+      break;
+    }
+
+    head = p - data + 1;
+    _originalBreaks.push_back(head - 1);
+  }
+
+  if (size)
+    _root = createNode(Original, 0, size);
+
+  if (head < size)
+  {
+    Indexer *indexer = new Indexer();
+    indexer->done = false;
+    indexer->cancel = false;
+    indexer->breaks = _originalBreaks;
+
+    indexer->thread = std::thread([indexer, data, head, size]()
+    {
+      indexLineBreaks(data, head, size, indexer->breaks, &indexer->cancel, IndexChunkSize);
+
+      indexer->done = true;
+    });
+
+    _indexer.reset(indexer);
+  }
+
+  return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextBuffer::updateIndex()
+{
+  if (!_indexer || !_indexer->done)
+    return false;
+
+  finishIndexing();
+  return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::waitForIndex()
+{
+  if (_indexer)
+    finishIndexing();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::finishIndexing()
+{
+  _indexer->thread.join();
+  _originalBreaks.swap(_indexer->breaks);
+  _indexer.reset();
+
+  // Pieces of the original text were counted with the breaks found so far
+  recountBreaks(_root);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBuffer::getIndexedLength() const
+{
+  if (!_indexer)
+    return getLength();
+
+  // Original text is never reordered, text before the last known break is either indexed or inserted
+  return getLineOffset(_nodes[_root].totalBreaks);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::recountBreaks(unsigned t)
+{
+  if (!t)
+    return;
+
+  recountBreaks(_nodes[t].left);
+  recountBreaks(_nodes[t].right);
+
+  Node &n = _nodes[t];
+  if (n.source == Original)
+    n.breaks = countBreaks(n.source, n.start, n.length);
+
+  update(t);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::stopIndexing()
+{
+  if (!_indexer)
+    return;
+
+  _indexer->cancel = true;
+  _indexer->thread.join();
+  _indexer.reset();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+std::string TextBuffer::getText() const
+{
+  std::string result;
+  result.reserve(getLength());
+  collect(_root, 0, getLength(), result);
+  return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::getText(size_t offset, size_t length, std::string &result) const
+{
+  if (offset < getLength())
+    collect(_root, offset, minimum(length, getLength() - offset), result);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const char *TextBuffer::getData(size_t offset, size_t length, std::string &scratch) const
+{
+  size_t position = offset;
+  unsigned t = _root;
+
+  while (t)
+  {
+    const Node &n = _nodes[t];
+    size_t leftLength = _nodes[n.left].totalLength;
+
+    if (position < leftLength)
+    {
+      t = n.left;
+    }
+    else if (position - leftLength < n.length)
+    {
+      size_t begin = position - leftLength;
+
+      if (begin + length <= n.length)
+        return getSourceData(n.source) + n.start + begin;
+
+      break;
+    }
+    else
+    {
+      position -= leftLength + n.length;
+      t = n.right;
+    }
+  }
+
+  scratch.clear();
+  getText(offset, length, scratch);
+  return scratch.c_str();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+char TextBuffer::getChar(size_t offset) const
+{
+  unsigned t = _root;
+
+  while (t)
+  {
+    const Node &n = _nodes[t];
+    size_t leftLength = _nodes[n.left].totalLength;
+
+    if (offset < leftLength)
+    {
+      t = n.left;
+    }
+    else if (offset - leftLength < n.length)
+    {
+      return getSourceData(n.source)[n.start + offset - leftLength];
+    }
+    else
+    {
+      offset -= leftLength + n.length;
+      t = n.right;
+    }
+  }
+
+  return 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextBuffer::isEqual(const char *text, size_t length) const
+{
+  return length == getLength() && compare(_root, text);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBuffer::getLineOffset(size_t line) const
+{
+  if (!line)
+    return 0;
+
+  // Line starts right after its preceding line break
+  size_t k = line;
+  size_t base = 0;
+  unsigned t = _root;
+
+  while (t)
+  {
+    const Node &n = _nodes[t];
+    const Node &left = _nodes[n.left];
+
+    if (k <= left.totalBreaks)
+    {
+      t = n.left;
+      continue;
+    }
+
+    k -= left.totalBreaks;
+    base += left.totalLength;
+
+    if (k <= n.breaks)
+      return base + getSourceBreaks(n.source)[findBreak(n.source, n.start) + k - 1] - n.start + 1;
+
+    k -= n.breaks;
+    base += n.length;
+    t = n.right;
+  }
+
+  return getLength();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBuffer::getLineLength(size_t line) const
+{
+  size_t offset = getLineOffset(line);
+
+  if (line < _nodes[_root].totalBreaks)
+    return getLineOffset(line + 1) - 1 - offset;
+
+  return getLength() - offset;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBuffer::getLineAt(size_t offset) const
+{
+  size_t line = 0;
+  unsigned t = _root;
+
+  while (t)
+  {
+    const Node &n = _nodes[t];
+    const Node &left = _nodes[n.left];
+
+    if (offset < left.totalLength)
+    {
+      t = n.left;
+      continue;
+    }
+
+    offset -= left.totalLength;
+    line += left.totalBreaks;
+
+    if (offset < n.length)
+      return line + countBreaks(n.source, n.start, offset);
+
+    offset -= n.length;
+    line += n.breaks;
+    t = n.right;
+  }
+
+  return line;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::insert(size_t offset, const char *text, size_t length)
+{
+  if (!length)
+    return;
+
+  offset = minimum(offset, getLength());
+
+  if (offset > getIndexedLength())
+    waitForIndex();
+
+  size_t start = _added.length();
+  size_t firstBreak = _addedBreaks.size();
+
+  _added.append(text, length);
+  findLineBreaks(text, length, start, _addedBreaks);
+
+  size_t breaks = _addedBreaks.size() - firstBreak;
+
+  unsigned left, right;
+  split(_root, offset, left, right);
+
+  // Typing usually continues right where the last inserted piece ends, such piece is extended instead of adding
+  // another one
+  unsigned last = left;
+  while (last && _nodes[last].right)
+    last = _nodes[last].right;
+
+  if (last && _nodes[last].source == Added && _nodes[last].start + _nodes[last].length == start)
+  {
+    for (unsigned t = left; t; t = _nodes[t].right)
+    {
+      _nodes[t].totalLength += length;
+      _nodes[t].totalBreaks += breaks;
+    }
+
+    _nodes[last].length += length;
+    _nodes[last].breaks += breaks;
+
+    _root = merge(left, right);
+  }
+  else
+  {
+    _root = merge(merge(left, createNode(Added, start, length)), right);
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::erase(size_t offset, size_t length)
+{
+  if (offset >= getLength() || !length)
+    return;
+
+  if (offset + minimum(length, getLength() - offset) > getIndexedLength())
+    waitForIndex();
+
+  unsigned left, middle, right;
+  split(_root, offset, left, right);
+  split(right, length, middle, right);
+
+  destroyTree(middle);
+
+  _root = merge(left, right);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBuffer::getLongestLine() const
+{
+  size_t longest = 0, longestLength = 0;
+  size_t line = 0, lineStart = 0, offset = 0;
+
+  // Line lengths are differences of consecutive break positions
+  forEachPiece([&](const Node &n)
+  {
+    const std::vector<size_t> &breaks = getSourceBreaks(n.source);
+    size_t first = findBreak(n.source, n.start);
+
+    for (size_t i = first; i < first + n.breaks; ++i)
+    {
+      size_t end = offset + breaks[i] - n.start;
+
+      if (end - lineStart > longestLength)
+      {
+        longest = line;
+        longestLength = end - lineStart;
+      }
+
+      lineStart = end + 1;
+      ++line;
+    }
+
+    offset += n.length;
+  });
+
+  // Last line is complete only when everything is indexed
+  if (isIndexed() && offset - lineStart > longestLength)
+    longest = line;
+
+  return longest;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::getParts(std::vector<Part> &parts, std::string &storage) const
+{
+  parts.clear();
+  storage.clear();
+
+  // Pieces never share inserted text, so it all fits without reallocating
+  storage.reserve(_added.size());
+
+  forEachPiece([&](const Node &n)
+  {
+    const char *data = getSourceData(n.source) + n.start;
+
+    if (n.source == Added)
+    {
+      storage.append(data, n.length);
+      data = storage.data() + storage.size() - n.length;
+    }
+
+    parts.push_back({ data, n.length });
+  });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBuffer::findBreak(Source source, size_t position) const
+{
+  const std::vector<size_t> &breaks = getSourceBreaks(source);
+  return std::lower_bound(breaks.begin(), breaks.end(), position) - breaks.begin();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+unsigned TextBuffer::createNode(Source source, size_t start, size_t length)
+{
+  unsigned t;
+
+  if (!_freeNodes.empty())
+  {
+    t = _freeNodes.back();
+    _freeNodes.pop_back();
+  }
+  else
+  {
+    t = static_cast<unsigned>(_nodes.size());
+    _nodes.emplace_back();
+  }
+
+  // xorshift32
+  _seed ^= _seed << 13;
+  _seed ^= _seed >> 17;
+  _seed ^= _seed << 5;
+
+  Node &n = _nodes[t];
+  n.left = n.right = 0;
+  n.priority = _seed;
+  n.source = source;
+  n.start = start;
+  n.length = length;
+  n.breaks = countBreaks(source, start, length);
+  update(t);
+
+  return t;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::destroyTree(unsigned t)
+{
+  if (!t)
+    return;
+
+  destroyTree(_nodes[t].left);
+  destroyTree(_nodes[t].right);
+
+  _freeNodes.push_back(t);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::split(unsigned t, size_t offset, unsigned &left, unsigned &right)
+{
+  if (!t)
+  {
+    left = right = 0;
+    return;
+  }
+
+  size_t leftLength = _nodes[_nodes[t].left].totalLength;
+  size_t pieceLength = _nodes[t].length;
+
+  if (offset <= leftLength)
+  {
+    unsigned l, r;
+    split(_nodes[t].left, offset, l, r);
+    _nodes[t].left = r;
+    update(t);
+
+    left = l;
+    right = t;
+  }
+  else if (offset >= leftLength + pieceLength)
+  {
+    unsigned l, r;
+    split(_nodes[t].right, offset - leftLength - pieceLength, l, r);
+    _nodes[t].right = l;
+    update(t);
+
+    left = t;
+    right = r;
+  }
+  else
+  {
+    // Cut the piece, the tail takes over right subtree and the same priority to keep the heap order
+    size_t cut = offset - leftLength;
+    unsigned tail = createNode(_nodes[t].source, _nodes[t].start + cut, pieceLength - cut);
+
+    Node &n = _nodes[t];
+    Node &tn = _nodes[tail];
+
+    tn.priority = n.priority;
+    tn.right = n.right;
+    n.right = 0;
+    n.length = cut;
+    n.breaks -= tn.breaks;
+
+    update(tail);
+    update(t);
+
+    left = t;
+    right = tail;
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+unsigned TextBuffer::merge(unsigned left, unsigned right)
+{
+  if (!left || !right)
+    return left ? left : right;
+
+  if (_nodes[left].priority > _nodes[right].priority)
+  {
+    _nodes[left].right = merge(_nodes[left].right, right);
+    update(left);
+    return left;
+  }
+
+  _nodes[right].left = merge(left, _nodes[right].left);
+  update(right);
+  return right;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBuffer::collect(unsigned t, size_t offset, size_t length, std::string &result) const
+{
+  if (!t || !length)
+    return;
+
+  const Node &n = _nodes[t];
+  size_t leftLength = _nodes[n.left].totalLength;
+
+  if (offset < leftLength)
+  {
+    size_t part = minimum(length, leftLength - offset);
+    collect(n.left, offset, part, result);
+    offset += part;
+    length -= part;
+  }
+
+  if (length && offset < leftLength + n.length)
+  {
+    size_t begin = offset - leftLength;
+    size_t part = minimum(length, n.length - begin);
+    result.append(getSourceData(n.source) + n.start + begin, part);
+    offset += part;
+    length -= part;
+  }
+
+  if (length)
+    collect(n.right, offset - leftLength - n.length, length, result);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextBuffer::compare(unsigned t, const char *&text) const
+{
+  if (!t)
+    return true;
+
+  const Node &n = _nodes[t];
+
+  if (!compare(n.left, text) || memcmp(getSourceData(n.source) + n.start, text, n.length) != 0)
+    return false;
+
+  text += n.length;
+  return compare(n.right, text);
+}
+
+}
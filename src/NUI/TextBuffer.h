@@ -0,0 +1,246 @@
+#pragma once
+
+#include "Base.h"
+#include "MappedFile.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace nui {
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Piece table stored in a treap ordered by position in the document. Pieces reference either the original text or
+// the append-only buffer of inserted text, every node keeps byte and line break totals of its subtree so that edits,
+// line lookups and offset <-> line conversions are all O(log n). Lines are separated by '\n', the separator is not
+// counted in line's length.
+class TextBuffer
+{
+  public:
+    enum
+    {
+      // Ranges at least this long are indexed by several threads, each scanning its own part
+      ParallelIndexMinSize = 8 << 20,
+
+      MaxIndexThreads = 16
+    };
+
+    TextBuffer() { clear(); }
+    TextBuffer(const TextBuffer &) = delete;
+    TextBuffer &operator=(const TextBuffer &) = delete;
+    ~TextBuffer() { stopIndexing(); }
+
+    void clear();
+
+    // Replaces the whole content, the text becomes the original buffer of the piece table
+    void setText(const char *text, size_t length);
+
+    void setText(const std::string &text) { setText(text.data(), text.length()); }
+
+    // Maps the file and uses it as the original text without copying it, edits are kept in the insert buffer. Lines
+    // needed for the first screen are indexed right away, the rest by a background thread. Edits before the end of
+    // the lines found so far don't wait for the thread.
+    bool loadFile(const std::string &fileName);
+
+    // Until the background indexing finishes only lines found so far are reported
+    bool isIndexed() const { return !_indexer; }
+
+    // Takes over the line index if the background thread has finished, returns true if it has
+    bool updateIndex();
+
+    void waitForIndex();
+
+    std::string getText() const;
+
+    // Appends part of the content to the string
+    void getText(size_t offset, size_t length, std::string &result) const;
+
+    // Returns pointer to length bytes starting at offset, points directly into the buffer if they are stored in a
+    // single piece, otherwise they are copied to scratch
+    const char *getData(size_t offset, size_t length, std::string &scratch) const;
+
+    char getChar(size_t offset) const;
+
+    bool isEqual(const char *text, size_t length) const;
+
+    bool isEqual(const std::string &text) const { return isEqual(text.data(), text.length()); }
+
+    size_t getLength() const { return _nodes[_root].totalLength; }
+
+    bool isEmpty() const { return getLength() == 0; }
+
+    size_t getNumLines() const
+    {
+      return isIndexed() ? _nodes[_root].totalBreaks + 1 : maximum(_nodes[_root].totalBreaks, static_cast<size_t>(1));
+    }
+
+    // Offset of line's first character, getLength() for lines past the end
+    size_t getLineOffset(size_t line) const;
+
+    size_t getLineLength(size_t line) const;
+
+    // Line containing given offset
+    size_t getLineAt(size_t offset) const;
+
+    // Line with the most bytes, found from the line index without touching the text. While indexing only the lines
+    // found so far are considered.
+    size_t getLongestLine() const;
+
+    void insert(size_t offset, const char *text, size_t length);
+
+    void insert(size_t offset, const std::string &text) { insert(offset, text.data(), text.length()); }
+
+    void erase(size_t offset, size_t length);
+
+    // Bytes of text held in memory, erased text stays in the insert buffer until the buffer is compacted. Mapped files
+    // are not counted.
+    size_t getStorageSize() const { return _original.length() + _added.length(); }
+
+    // Replaces the pieces with a single copy of the content, dropping erased text. Invalidates parts returned by
+    // getParts().
+    void compact();
+
+    size_t getNumPieces() const { return _nodes.size() - 1 - _freeNodes.size(); }
+
+    struct Part
+    {
+      const char *data;
+      size_t length;
+    };
+
+    // Content as contiguous parts in document order which can be read by other threads while the buffer is edited.
+    // Parts of the original text point into it and stay valid until the content is replaced, inserted text is copied
+    // to storage.
+    void getParts(std::vector<Part> &parts, std::string &storage) const;
+
+  private:
+    enum
+    {
+      // Line breaks indexed before loadFile() returns
+      HeadLines = 1024,
+
+      // Bytes scanned by the indexing thread between checks for cancellation
+      IndexChunkSize = 1 << 20
+    };
+
+    // Line breaks of the original text found by a background thread
+    struct Indexer
+    {
+      std::thread thread;
+      std::atomic<bool> done;
+      std::atomic<bool> cancel;
+      std::vector<size_t> breaks;
+    };
+
+    // Takes over the text as the original buffer and indexes its line breaks
+    void setOriginal(std::string &text);
+
+    void finishIndexing();
+
+    // Length of the text before the end of the last line found so far, everything while not indexing
+    size_t getIndexedLength() const;
+
+    // Recounts line breaks of the original text pieces after the whole text has been indexed
+    void recountBreaks(unsigned t);
+
+    void stopIndexing();
+
+    enum Source
+    {
+      Original = 0,
+      Added
+    };
+
+    struct Node
+    {
+      unsigned left;
+      unsigned right;
+      unsigned priority;
+      Source source;
+
+      // Piece
+      size_t start;
+      size_t length;
+      size_t breaks;
+
+      // Whole subtree
+      size_t totalLength;
+      size_t totalBreaks;
+    };
+
+    const char *getSourceData(Source source) const { return source == Original ? _originalData : _added.data(); }
+
+    const std::vector<size_t> &getSourceBreaks(Source source) const { return source == Original ? _originalBreaks : _addedBreaks; }
+
+    // Index of the first line break at or after given position of the source
+    size_t findBreak(Source source, size_t position) const;
+
+    size_t countBreaks(Source source, size_t start, size_t length) const
+    {
+      return findBreak(source, start + length) - findBreak(source, start);
+    }
+
+    unsigned createNode(Source source, size_t start, size_t length);
+
+    void destroyTree(unsigned t);
+
+    void update(unsigned t)
+    {
+      Node &n = _nodes[t];
+      n.totalLength = _nodes[n.left].totalLength + n.length + _nodes[n.right].totalLength;
+      n.totalBreaks = _nodes[n.left].totalBreaks + n.breaks + _nodes[n.right].totalBreaks;
+    }
+
+    // Splits tree so that the left part contains first offset bytes, piece containing the offset is cut in two
+    void split(unsigned t, size_t offset, unsigned &left, unsigned &right);
+
+    unsigned merge(unsigned left, unsigned right);
+
+    // Calls callback(const Node &) for all pieces in document order
+    template <typename Callback> void forEachPiece(Callback callback) const
+    {
+      std::vector<unsigned> stack;
+      unsigned t = _root;
+
+      while (t || !stack.empty())
+      {
+        for (; t; t = _nodes[t].left)
+          stack.push_back(t);
+
+        t = stack.back();
+        stack.pop_back();
+
+        callback(_nodes[t]);
+        t = _nodes[t].right;
+      }
+    }
+
+    void collect(unsigned t, size_t offset, size_t length, std::string &result) const;
+
+    // Compares pieces of the subtree with the text, advances text past them
+    bool compare(unsigned t, const char *&text) const;
+
+    // Source text, points either to _original or into _originalFile
+    const char *_originalData = nullptr;
+    std::string _original;
+    MappedFile _originalFile;
+    std::vector<size_t> _originalBreaks;
+
+    std::unique_ptr<Indexer> _indexer;
+
+    // Inserted text, never modified, only appended to
+    std::string _added;
+    std::vector<size_t> _addedBreaks;
+
+    // Node 0 is an empty sentinel used instead of null children
+    std::vector<Node> _nodes;
+    std::vector<unsigned> _freeNodes;
+    unsigned _root = 0;
+
+    unsigned _seed = 0x2545f491;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+}
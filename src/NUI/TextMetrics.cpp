@@ -0,0 +1,282 @@
+#include "TextMetrics.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace nui {
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t GlyphRun::getGlyphAt(size_t offset) const
+{
+  if (_offsets.empty())
+    return 0;
+
+  // Last glyph starting at or before the offset, the entry for the end of the text is one past the last glyph
+  size_t glyph = std::upper_bound(_offsets.begin(), _offsets.end(), offset) - _offsets.begin();
+  return glyph ? glyph - 1 : 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t GlyphRun::getNextOffset(size_t offset) const
+{
+  size_t glyph = getGlyphAt(offset);
+  return glyph < getNumGlyphs() ? _offsets[glyph + 1] : getLength();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t GlyphRun::getPreviousOffset(size_t offset) const
+{
+  size_t glyph = getGlyphAt(offset);
+  return glyph ? _offsets[glyph - 1] : 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t GlyphRun::getOffsetAt(int x, int *charX) const
+{
+  size_t numGlyphs = getNumGlyphs();
+  size_t low = 0, high = numGlyphs;
+
+  // Middles grow with glyph index
+  while (low < high)
+  {
+    size_t middle = (low + high) / 2;
+
+    if (x <= (_minX[middle] + _maxX[middle]) / 2)
+      high = middle;
+    else
+      low = middle + 1;
+  }
+
+  if (charX)
+    *charX = low < numGlyphs ? _x[low] : (numGlyphs ? _maxX[numGlyphs - 1] : 0);
+
+  return numGlyphs ? _offsets[low] : 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static bool isAscii(const char *text, const char *end)
+{
+  unsigned char bits = 0;
+
+  for (const char *c = text; c < end; ++c)
+    bits |= static_cast<unsigned char>(*c);
+
+  return bits < 0x80;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static uint64_t hashText(int fontID, int fontSize, const char *text, const char *end)
+{
+  int font[2] = { fontID, fontSize };
+  return hashBytes(text, end - text, hashBytes(font, sizeof(font)));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int TextMetrics::measure(int fontID, int fontSize, const char *text, const char *end)
+{
+  if (!end)
+    end = text + strlen(text);
+
+  if (text == end)
+    return 0;
+
+  if (isAscii(text, end))
+  {
+    const Table &table = getTable(fontID, fontSize);
+    size_t length = end - text;
+
+    if (table.monospaceAdvance)
+      return static_cast<int>(length - 1) * table.monospaceAdvance;
+
+    // Kerning of a glyph is added after its x is taken, so the last glyph's kerning doesn't count
+    const unsigned char *c = reinterpret_cast<const unsigned char *>(text);
+    int x = table.advance[c[0]];
+
+    for (size_t i = 1; i + 1 < length; ++i)
+      x += table.advance[c[i]] + table.getKerning(c[i - 1], c[i]);
+
+    return length > 1 ? x : 0;
+  }
+
+  uint64_t key = hashText(fontID, fontSize, text, end);
+  auto cached = _widthIndex.find(key);
+
+  if (cached != _widthIndex.end())
+  {
+    _widths.splice(_widths.begin(), _widths, cached->second);
+    return cached->second->width;
+  }
+
+  int num = measureGlyphs(fontID, fontSize, text, end);
+  int width = num ? static_cast<int>(_positions[num - 1].x) : 0;
+
+  if (_widths.size() >= WidthCacheSize)
+  {
+    _widthIndex.erase(_widths.back().key);
+    _widths.pop_back();
+  }
+
+  _widths.push_front({ key, width });
+  _widthIndex[key] = _widths.begin();
+  return width;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextMetrics::layout(int fontID, int fontSize, const char *text, const char *end, GlyphRun &run)
+{
+  if (!end)
+    end = text + strlen(text);
+
+  run.clear();
+  run._offsets.push_back(0);
+  run._x.push_back(0);
+
+  if (text == end)
+    return;
+
+  size_t length = end - text;
+
+  if (isAscii(text, end))
+  {
+    const Table &table = getTable(fontID, fontSize);
+    const unsigned char *c = reinterpret_cast<const unsigned char *>(text);
+
+    run._offsets.resize(length + 1);
+    run._x.resize(length + 1);
+    run._minX.resize(length);
+    run._maxX.resize(length);
+
+    for (size_t i = 0; i < length; ++i)
+    {
+      // Exact for glyphs without kerning, kerned glyphs have their extent shifted by the kerning
+      int x = run._x[i];
+      int kerning = i ? table.getKerning(c[i - 1], c[i]) : 0;
+
+      run._offsets[i + 1] = i + 1;
+      run._x[i + 1] = x + table.advance[c[i]] + kerning;
+      run._minX[i] = x + minimum(0, kerning + table.minX[c[i]]);
+      run._maxX[i] = x + kerning + table.maxX[c[i]];
+    }
+
+    return;
+  }
+
+  // Space appended to get the position after the last glyph
+  _scratch.assign(text, length);
+  _scratch += ' ';
+
+  int num = measureGlyphs(fontID, fontSize, _scratch.data(), _scratch.data() + _scratch.length());
+
+  run._offsets.clear();
+  run._x.clear();
+
+  for (int i = 0; i < num; ++i)
+  {
+    run._offsets.push_back(_positions[i].str - _scratch.data());
+    run._x.push_back(static_cast<int>(_positions[i].x));
+
+    if (i + 1 < num)
+    {
+      run._minX.push_back(static_cast<int>(_positions[i].minx));
+      run._maxX.push_back(static_cast<int>(_positions[i].maxx));
+    }
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const TextMetrics::Table &TextMetrics::getTable(int fontID, int fontSize)
+{
+  if (_lastTable && _lastTable->fontID == fontID && _lastTable->fontSize == fontSize)
+    return *_lastTable;
+
+  for (auto &table : _tables)
+  {
+    if (table->fontID == fontID && table->fontSize == fontSize)
+    {
+      _lastTable = table.get();
+      return *table;
+    }
+  }
+
+  std::unique_ptr<Table> table(new Table());
+  table->fontID = fontID;
+  table->fontSize = fontSize;
+
+  // Advance is the x of a following glyph, extent is measured on the character alone
+  for (int c = 0; c < NumTableChars; ++c)
+  {
+    char text[2] = { static_cast<char>(c), 'x' };
+    int num = measureGlyphs(fontID, fontSize, text, text + 2);
+
+    table->advance[c] = num > 1 ? static_cast<int>(_positions[1].x) : 0;
+    table->minX[c] = num ? static_cast<int>(_positions[0].minx) : 0;
+    table->maxX[c] = num ? static_cast<int>(_positions[0].maxx) : 0;
+  }
+
+  // All pairs measured at once, difference of glyph's and next glyph's x is its advance plus kerning with the
+  // previous glyph
+  std::string pairs;
+  pairs.reserve(NumTableChars * NumTableChars * 2 + 1);
+
+  for (int first = 0; first < NumTableChars; ++first)
+  {
+    for (int second = 0; second < NumTableChars; ++second)
+    {
+      pairs += static_cast<char>(first);
+      pairs += static_cast<char>(second);
+    }
+  }
+
+  pairs += 'x';
+
+  int num = measureGlyphs(fontID, fontSize, pairs.data(), pairs.data() + pairs.length());
+  bool hasKerning = false;
+
+  table->kerning.assign(NumTableChars * NumTableChars, 0);
+
+  for (int i = 1; i + 1 < num; ++i)
+  {
+    unsigned char previous = static_cast<unsigned char>(pairs[i - 1]);
+    unsigned char current = static_cast<unsigned char>(pairs[i]);
+    int kerning = static_cast<int>(_positions[i + 1].x - _positions[i].x) - table->advance[current];
+
+    table->kerning[previous * NumTableChars + current] = static_cast<short>(kerning);
+    hasKerning |= kerning != 0;
+  }
+
+  if (!hasKerning)
+    table->kerning.clear();
+
+  table->monospaceAdvance = hasKerning ? 0 : table->advance[0];
+
+  for (int c = 1; c < NumTableChars; ++c)
+  {
+    if (table->advance[c] != table->monospaceAdvance)
+      table->monospaceAdvance = 0;
+  }
+
+  _lastTable = table.get();
+  _tables.push_back(std::move(table));
+  return *_lastTable;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int TextMetrics::measureGlyphs(int fontID, int fontSize, const char *text, const char *end)
+{
+  if (text == end)
+    return 0;
+
+  // Measured in default state, alignment and transform left from drawing would shift the positions
+  nvgSave(_context);
+  nvgReset(_context);
+  nvgFontFaceId(_context, fontID);
+  nvgFontSize(_context, static_cast<float>(fontSize));
+
+  _positions.resize(end - text);
+  int num = nvgTextGlyphPositions(_context, 0, 0, text, end, _positions.data(), static_cast<int>(_positions.size()));
+
+  nvgRestore(_context);
+  return num;
+}
+
+}
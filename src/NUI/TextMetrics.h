@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Base.h"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace nui {
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Positions of all glyphs of a text, x of each glyph is the sum of previous advances and kerning. Lookups by byte
+// offset and by x are binary searches so cursor positioning doesn't depend on line length.
+class GlyphRun
+{
+  public:
+    void clear()
+    {
+      _offsets.clear();
+      _x.clear();
+      _minX.clear();
+      _maxX.clear();
+    }
+
+    size_t getNumGlyphs() const { return _minX.size(); }
+
+    // Byte length of the measured text
+    size_t getLength() const { return _offsets.empty() ? 0 : _offsets.back(); }
+
+    // First byte and x of a glyph, the glyph count gives the end of the text
+    size_t getGlyphOffset(size_t glyph) const { return _offsets[glyph]; }
+
+    int getGlyphX(size_t glyph) const { return _x[glyph]; }
+
+    // Glyph containing given byte, offsets at or past the end give the glyph count
+    size_t getGlyphAt(size_t offset) const;
+
+    // x of the glyph containing given byte, offsets at or past the end give the position after the last glyph
+    int getX(size_t offset) const { return _x.empty() ? 0 : _x[getGlyphAt(offset)]; }
+
+    // First byte of the glyph following the one containing given byte, the end of the text after the last glyph
+    size_t getNextOffset(size_t offset) const;
+
+    // First byte of the glyph preceding the one containing given byte, 0 for the first glyph
+    size_t getPreviousOffset(size_t offset) const;
+
+    // Byte offset of the first glyph whose middle is at or right of x, charX receives the glyph's x or the right
+    // edge of the last glyph if x is past all of them
+    size_t getOffsetAt(int x, int *charX) const;
+
+  private:
+    friend class TextMetrics;
+
+    // Per glyph, _offsets and _x have one more entry for the end of the text
+    std::vector<size_t> _offsets;
+    std::vector<int> _x;
+    std::vector<int> _minX;
+    std::vector<int> _maxX;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Text measurement giving the same results as nvgTextGlyphPositions without calling it for every measurement. ASCII
+// text is measured using per font and size tables of advances and kerning built on first use, texts with other
+// characters are measured by nanovg and their widths are kept in an LRU cache keyed by content hash.
+class TextMetrics
+{
+  public:
+    explicit TextMetrics(NVGcontext *context) : _context(context) { }
+    TextMetrics(const TextMetrics &) = delete;
+    TextMetrics &operator=(const TextMetrics &) = delete;
+
+    // x of the last glyph of the text, 0 for empty text
+    int measure(int fontID, int fontSize, const char *text, const char *end);
+
+    void layout(int fontID, int fontSize, const char *text, const char *end, GlyphRun &run);
+
+  private:
+    enum
+    {
+      NumTableChars = 128,
+
+      WidthCacheSize = 4096
+    };
+
+    struct Table
+    {
+      int fontID;
+      int fontSize;
+
+      // Non-zero if all characters have this advance and there's no kerning
+      int monospaceAdvance;
+
+      int advance[NumTableChars];
+
+      // Extent of the glyph relative to its x
+      int minX[NumTableChars];
+      int maxX[NumTableChars];
+
+      // Added to x of the second character of a pair, NumTableChars * NumTableChars entries or empty if the font has
+      // no kerning for ASCII characters
+      std::vector<short> kerning;
+
+      int getKerning(unsigned char first, unsigned char second) const
+      {
+        return kerning.empty() ? 0 : kerning[first * NumTableChars + second];
+      }
+    };
+
+    struct CachedWidth
+    {
+      uint64_t key;
+      int width;
+    };
+
+    const Table &getTable(int fontID, int fontSize);
+
+    // Fills _positions using nanovg, returns number of glyphs
+    int measureGlyphs(int fontID, int fontSize, const char *text, const char *end);
+
+    NVGcontext *_context;
+
+    std::vector<std::unique_ptr<Table>> _tables;
+    const Table *_lastTable = nullptr;
+
+    // Most recently used first
+    std::list<CachedWidth> _widths;
+    std::unordered_map<uint64_t, std::list<CachedWidth>::iterator> _widthIndex;
+
+    std::vector<NVGglyphPosition> _positions;
+    std::string _scratch;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+}
@@ -0,0 +1,412 @@
+#include "TextSearch.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace nui {
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::start(const TextBuffer &buffer, const std::string &pattern)
+{
+  clear();
+
+  if (pattern.empty() || pattern.length() > 255)
+    return;
+
+  _pattern = pattern;
+  _chunks.push_back({ buffer.getLength(), {} });
+  buildTree();
+
+  _worker.reset(new Worker());
+  _worker->done = false;
+  _worker->cancel = false;
+  buffer.getParts(_worker->parts, _worker->storage);
+  _worker->thread = std::thread(run, _worker.get(), pattern);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::clear()
+{
+  stopWorker();
+
+  _pattern.clear();
+  _chunks.clear();
+  _tree.clear();
+  _numMatches = 0;
+  _edits.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextSearch::update()
+{
+  if (!_worker)
+    return false;
+
+  bool done = _worker->done;
+
+  {
+    std::lock_guard<std::mutex> lock(_worker->mutex);
+    _newMatches.swap(_worker->found);
+  }
+
+  for (const Edit &edit : _edits)
+    applyEdit(_newMatches, edit);
+
+  bool added = !_newMatches.empty();
+  addMatches(_newMatches);
+  _newMatches.clear();
+
+  if (done)
+  {
+    _worker->thread.join();
+    _worker.reset();
+    _edits.clear();
+  }
+
+  return added;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::textEdited(const TextBuffer &buffer, size_t offset, size_t erased, size_t inserted)
+{
+  if (!isActive())
+    return;
+
+  Edit edit = { offset, offset + erased, offset + inserted };
+  applyEdit(edit);
+
+  if (_worker)
+    _edits.push_back(edit);
+
+  // Matches touching the edit start at most pattern length before it, whole lines around it are searched again
+  size_t margin = _pattern.length() - 1;
+  size_t length = buffer.getLength();
+  size_t from = buffer.getLineOffset(buffer.getLineAt(offset > margin ? offset - margin : 0));
+  size_t lastLine = buffer.getLineAt(minimum(edit.newEnd + margin, length));
+  size_t to = minimum(buffer.getLineOffset(lastLine) + buffer.getLineLength(lastLine), length);
+
+  const char *text = buffer.getData(from, to - from, _scratch);
+  find(text, to - from, _pattern, from, _newMatches);
+  addMatches(_newMatches);
+  _newMatches.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextSearch::findMatch(size_t offset, size_t &match) const
+{
+  if (_chunks.empty())
+    return false;
+
+  size_t position = offset;
+  size_t chunk = findChunk(position);
+
+  for (size_t start = offset - position; chunk < _chunks.size(); start += _chunks[chunk++].length)
+  {
+    const std::vector<size_t> &matches = _chunks[chunk].matches;
+    auto i = std::lower_bound(matches.begin(), matches.end(), position);
+
+    if (i != matches.end())
+    {
+      match = start + *i;
+      return true;
+    }
+
+    position = 0;
+  }
+
+  return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::find(const char *text, size_t length, const std::string &pattern, size_t base, std::vector<size_t> &matches)
+{
+  size_t patternLength = pattern.length();
+
+  if (!patternLength || patternLength > length)
+    return;
+
+  const unsigned char *data = reinterpret_cast<const unsigned char *>(text);
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(pattern.data());
+
+  // Single bytes are found by memchr which compares many bytes at once
+  if (patternLength == 1)
+  {
+    const char *end = text + length;
+
+    for (const char *c = text; (c = static_cast<const char *>(memchr(c, p[0], end - c))); ++c)
+      matches.push_back(base + (c - text));
+
+    return;
+  }
+
+  // Window is moved by distance of its last byte from the end of the pattern
+  unsigned char shift[256];
+  memset(shift, static_cast<unsigned char>(patternLength), sizeof(shift));
+
+  for (size_t i = 0; i + 1 < patternLength; ++i)
+    shift[p[i]] = static_cast<unsigned char>(patternLength - 1 - i);
+
+  unsigned char last = p[patternLength - 1];
+
+  for (size_t position = 0; position + patternLength <= length;)
+  {
+    unsigned char c = data[position + patternLength - 1];
+
+    if (c == last && memcmp(data + position, p, patternLength - 1) == 0)
+      matches.push_back(base + position);
+
+    position += shift[c];
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::run(Worker *worker, std::string pattern)
+{
+  size_t margin = pattern.length() - 1;
+  size_t offset = 0;
+  std::vector<size_t> found;
+
+  // Last bytes of previous parts and the beginning of the current one, for matches crossing part boundaries
+  std::string seam;
+  std::string tail;
+
+  for (const TextBuffer::Part &part : worker->parts)
+  {
+    if (worker->cancel)
+      break;
+
+    if (!tail.empty())
+    {
+      seam = tail;
+      seam.append(part.data, minimum(margin, part.length));
+      find(seam.data(), seam.length(), pattern, offset - tail.length(), found);
+
+      // Matches starting in the part are found below
+      while (!found.empty() && found.back() >= offset)
+        found.pop_back();
+    }
+
+    for (size_t chunk = 0; chunk < part.length && !worker->cancel; chunk += ChunkSize)
+    {
+      size_t chunkEnd = minimum(chunk + ChunkSize, part.length);
+
+      // Overlaps the next chunk so that matches starting in this one are complete
+      find(part.data + chunk, minimum(chunkEnd + margin, part.length) - chunk, pattern, offset + chunk, found);
+
+      while (!found.empty() && found.back() >= offset + chunkEnd)
+        found.pop_back();
+
+      if (!found.empty())
+      {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->found.insert(worker->found.end(), found.begin(), found.end());
+        found.clear();
+      }
+    }
+
+    if (part.length >= margin)
+    {
+      tail.assign(part.data + part.length - margin, margin);
+    }
+    else
+    {
+      tail.append(part.data, part.length);
+      tail.erase(0, tail.length() > margin ? tail.length() - margin : 0);
+    }
+
+    offset += part.length;
+  }
+
+  worker->done = true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::stopWorker()
+{
+  if (_worker)
+  {
+    _worker->cancel = true;
+    _worker->thread.join();
+    _worker.reset();
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::applyEdit(std::vector<size_t> &matches, const Edit &edit) const
+{
+  size_t patternLength = _pattern.length();
+
+  // Matches ending before the edit stay where they are
+  auto first = std::lower_bound(matches.begin(), matches.end(), edit.start >= patternLength ? edit.start - patternLength + 1 : 0);
+  auto out = first;
+
+  for (auto i = first; i != matches.end(); ++i)
+  {
+    if (*i + patternLength <= edit.start)
+      *out++ = *i;
+    else if (*i >= edit.oldEnd)
+      *out++ = *i - edit.oldEnd + edit.newEnd;
+  }
+
+  matches.erase(out, matches.end());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::applyEdit(const Edit &edit)
+{
+  size_t patternLength = _pattern.length();
+  size_t first = edit.start >= patternLength ? edit.start - patternLength + 1 : 0;
+
+  size_t position = edit.start;
+  size_t chunk = findChunk(position);
+  size_t start = edit.start - position;
+
+  // Matches reaching into the edit from before the chunk are at the ends of preceding chunks
+  for (size_t i = chunk, chunkStart = start; i && chunkStart > first;)
+  {
+    MatchChunk &previous = _chunks[--i];
+    chunkStart -= previous.length;
+
+    for (; !previous.matches.empty() && chunkStart + previous.matches.back() >= first; --_numMatches)
+      previous.matches.pop_back();
+  }
+
+  // Edit reaching past the chunk joins the chunks it covers
+  size_t next = chunk + 1;
+  size_t length = _chunks[chunk].length;
+
+  for (; next < _chunks.size() && start + length < edit.oldEnd; ++next)
+  {
+    for (size_t match : _chunks[next].matches)
+      _chunks[chunk].matches.push_back(length + match);
+
+    length += _chunks[next].length;
+  }
+
+  if (next > chunk + 1)
+  {
+    _chunks[chunk].length = length;
+    _chunks.erase(_chunks.begin() + chunk + 1, _chunks.begin() + next);
+    buildTree();
+  }
+
+  std::vector<size_t> &matches = _chunks[chunk].matches;
+  auto from = std::lower_bound(matches.begin(), matches.end(), first > start ? first - start : 0);
+  auto to = std::lower_bound(from, matches.end(), edit.oldEnd - start);
+
+  for (auto i = to; i != matches.end(); ++i)
+    *i = *i - edit.oldEnd + edit.newEnd;
+
+  _numMatches -= to - from;
+  matches.erase(from, to);
+
+  _chunks[chunk].length += edit.newEnd - edit.oldEnd;
+  addLength(chunk, edit.newEnd - edit.oldEnd);
+
+  if (matches.size() >= 2 * MatchChunkSize)
+    splitChunk(chunk);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::addMatches(const std::vector<size_t> &matches)
+{
+  for (size_t i = 0; i < matches.size();)
+  {
+    size_t position = matches[i];
+    size_t chunk = findChunk(position);
+    size_t start = matches[i] - position;
+    size_t end = start + _chunks[chunk].length;
+
+    std::vector<size_t> &known = _chunks[chunk].matches;
+    size_t middle = known.size();
+
+    for (; i < matches.size() && (matches[i] < end || chunk + 1 == _chunks.size()); ++i)
+      known.push_back(matches[i] - start);
+
+    if (middle && known[middle - 1] >= known[middle])
+    {
+      std::inplace_merge(known.begin(), known.begin() + middle, known.end());
+      known.erase(std::unique(known.begin(), known.end()), known.end());
+    }
+
+    _numMatches += known.size() - middle;
+
+    if (known.size() >= 2 * MatchChunkSize)
+      splitChunk(chunk);
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextSearch::findChunk(size_t &offset) const
+{
+  // Descends the tree to the last chunk starting at or before the offset
+  size_t chunk = 0;
+  size_t mask = 1;
+
+  while (mask * 2 <= _chunks.size())
+    mask *= 2;
+
+  for (; mask; mask /= 2)
+  {
+    if (chunk + mask <= _chunks.size() && _tree[chunk + mask] <= offset)
+    {
+      chunk += mask;
+      offset -= _tree[chunk];
+    }
+  }
+
+  // Offsets past the end belong to the last chunk
+  if (chunk == _chunks.size())
+    offset += _chunks[--chunk].length;
+
+  return chunk;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::splitChunk(size_t chunk)
+{
+  MatchChunk &large = _chunks[chunk];
+  std::vector<MatchChunk> pieces;
+
+  // Pieces after the first one start at their first match
+  for (size_t i = 0; i < large.matches.size(); i += MatchChunkSize)
+  {
+    size_t start = i ? large.matches[i] : 0;
+    size_t end = i + MatchChunkSize < large.matches.size() ? large.matches[i + MatchChunkSize] : large.length;
+
+    pieces.push_back({ end - start, {} });
+
+    for (size_t j = i; j < minimum(i + MatchChunkSize, large.matches.size()); ++j)
+      pieces.back().matches.push_back(large.matches[j] - start);
+  }
+
+  _chunks.erase(_chunks.begin() + chunk);
+  _chunks.insert(_chunks.begin() + chunk, std::make_move_iterator(pieces.begin()), std::make_move_iterator(pieces.end()));
+  buildTree();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::buildTree()
+{
+  size_t numChunks = _chunks.size();
+
+  _tree.assign(numChunks + 1, 0);
+
+  for (size_t i = 1; i <= numChunks; ++i)
+  {
+    _tree[i] += _chunks[i - 1].length;
+
+    size_t parent = i + (i & (0 - i));
+    if (parent <= numChunks)
+      _tree[parent] += _tree[i];
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextSearch::addLength(size_t chunk, size_t delta)
+{
+  for (size_t i = chunk + 1; i < _tree.size(); i += i & (0 - i))
+    _tree[i] += delta;
+}
+
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "TextBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace nui {
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Finds all occurrences of a pattern in a TextBuffer. The buffer is scanned by a worker thread over a snapshot of its
+// content and update() takes over matches as they are found. Edits made in the meantime are applied to the matches
+// and only lines around an edit are searched again. Matches are kept in chunks with offsets relative to the chunk and
+// chunk lengths are summed in a Fenwick tree, an edit moves only the matches of its chunk.
+class TextSearch
+{
+  public:
+    TextSearch() { }
+    TextSearch(const TextSearch &) = delete;
+    TextSearch &operator=(const TextSearch &) = delete;
+    ~TextSearch() { stopWorker(); }
+
+    void start(const TextBuffer &buffer, const std::string &pattern);
+
+    // Stops searching and forgets all matches, has to be called before content of the buffer is replaced
+    void clear();
+
+    bool isActive() const { return !_pattern.empty(); }
+
+    bool isRunning() const { return _worker != nullptr; }
+
+    // Takes over matches found by the worker, returns true if any were added
+    bool update();
+
+    // Has to be called after each edit of the searched buffer
+    void textEdited(const TextBuffer &buffer, size_t offset, size_t erased, size_t inserted);
+
+    const std::string &getPattern() const { return _pattern; }
+
+    size_t getNumMatches() const { return _numMatches; }
+
+    // Offset of the first match at or after offset, returns false if there's none
+    bool findMatch(size_t offset, size_t &match) const;
+
+    // Calls callback(size_t) with offsets of matches starting in [from, to) in ascending order
+    template <typename Callback> void forEachMatch(size_t from, size_t to, Callback callback) const
+    {
+      if (_chunks.empty() || from >= to)
+        return;
+
+      size_t offset = from;
+      size_t chunk = findChunk(offset);
+
+      for (size_t start = from - offset; chunk < _chunks.size() && start < to; start += _chunks[chunk++].length)
+      {
+        const std::vector<size_t> &matches = _chunks[chunk].matches;
+
+        for (auto i = std::lower_bound(matches.begin(), matches.end(), offset); i != matches.end() && start + *i < to; ++i)
+          callback(start + *i);
+
+        offset = 0;
+      }
+    }
+
+    // Boyer-Moore-Horspool search, appends offsets of matches increased by base. Pattern is at most 255 bytes.
+    static void find(const char *text, size_t length, const std::string &pattern, size_t base, std::vector<size_t> &matches);
+
+  private:
+    enum
+    {
+      // Bytes scanned by the worker between publishing matches and checks for cancellation
+      ChunkSize = 1 << 20,
+
+      // Chunks of matches are split into this many when they grow twice as large
+      MatchChunkSize = 256
+    };
+
+    struct MatchChunk
+    {
+      // Bytes from the start of the chunk to the start of the next one, the last one reaches the end of the text
+      size_t length;
+
+      // Offsets relative to the start of the chunk in ascending order
+      std::vector<size_t> matches;
+    };
+
+    struct Edit
+    {
+      size_t start;
+      size_t oldEnd;
+      size_t newEnd;
+    };
+
+    struct Worker
+    {
+      std::thread thread;
+      std::atomic<bool> done;
+      std::atomic<bool> cancel;
+
+      // Snapshot of the buffer
+      std::vector<TextBuffer::Part> parts;
+      std::string storage;
+
+      std::mutex mutex;
+      std::vector<size_t> found;
+    };
+
+    static void run(Worker *worker, std::string pattern);
+
+    void stopWorker();
+
+    // Moves matches behind the edit, drops the ones it has changed
+    void applyEdit(std::vector<size_t> &matches, const Edit &edit) const;
+
+    // Same for the found matches, only the chunk containing the edit is walked
+    void applyEdit(const Edit &edit);
+
+    // Adds sorted matches, skipping already known ones
+    void addMatches(const std::vector<size_t> &matches);
+
+    // Chunk containing the offset, offset receives the position within the chunk
+    size_t findChunk(size_t &offset) const;
+
+    // Replaces the chunk by chunks of MatchChunkSize matches
+    void splitChunk(size_t chunk);
+
+    void buildTree();
+
+    // Adds the difference to the length of the chunk, wrapping around for removed text
+    void addLength(size_t chunk, size_t delta);
+
+    std::string _pattern;
+
+    std::vector<MatchChunk> _chunks;
+
+    // One-based, entry i holds the length of chunks (i - lowest set bit of i, i]
+    std::vector<size_t> _tree;
+
+    size_t _numMatches = 0;
+
+    std::unique_ptr<Worker> _worker;
+
+    // Edits made since the worker has started, its matches are relative to the snapshot
+    std::vector<Edit> _edits;
+
+    std::vector<size_t> _newMatches;
+
+    std::string _scratch;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+}
@@ -0,0 +1,206 @@
+#include "TextWrap.h"
+#include "TextBuffer.h"
+
+namespace nui {
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextWrap::clear()
+{
+  _lines.clear();
+  _tree.assign(1, 0);
+  _numRows = 0;
+  _pending = 0;
+  _numPending = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextWrap::reset(const TextBuffer &buffer, int width, int charWidth)
+{
+  clear();
+
+  _width = width;
+  _charWidth = maximum(charWidth, 1);
+
+  size_t numLines = buffer.getNumLines();
+  _lines.resize(numLines);
+
+  for (size_t i = 0; i < numLines; ++i)
+  {
+    Line &line = _lines[i];
+    line.length = buffer.getLineLength(i);
+    line.numRows = estimateRows(line.length);
+    line.width = 0;
+  }
+
+  _numPending = numLines;
+  buildTree();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextWrap::setWidth(int width, int charWidth)
+{
+  if (_width == width && _charWidth == charWidth)
+    return;
+
+  _width = width;
+  _charWidth = maximum(charWidth, 1);
+  _pending = 0;
+
+  // Rows stay allocated so that wrapping the lines again reuses them
+  for (Line &line : _lines)
+  {
+    line.numRows = estimateRows(line.length);
+    line.width = 0;
+  }
+
+  _numPending = _lines.size();
+  buildTree();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextWrap::linesChanged(const TextBuffer &buffer, size_t line, size_t removed, size_t added)
+{
+  if (line >= _lines.size())
+    return;
+
+  removed = minimum(removed, _lines.size() - 1 - line);
+
+  size_t common = minimum(removed, added) + 1;
+
+  for (size_t i = line; i <= line + removed; ++i)
+    _numPending -= _lines[i].width != _width;
+
+  if (removed > added)
+    _lines.erase(_lines.begin() + line + common, _lines.begin() + line + removed + 1);
+  else if (added > removed)
+    _lines.insert(_lines.begin() + line + common, added - removed, Line());
+
+  for (size_t i = line; i <= line + added; ++i)
+  {
+    Line &changed = _lines[i];
+    changed.length = buffer.getLineLength(i);
+    changed.width = 0;
+    changed.rows.clear();
+
+    if (removed == added)
+      addRows(i, estimateRows(changed.length));
+    else
+      changed.numRows = estimateRows(changed.length);
+  }
+
+  // Positions of the following lines have moved
+  if (removed != added)
+    buildTree();
+
+  _pending = minimum(_pending, line);
+  _numPending += added + 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextWrap::setRows(size_t line, const std::vector<Row> &rows)
+{
+  Line &wrapped = _lines[line];
+  _numPending -= wrapped.width != _width;
+  wrapped.rows = rows;
+  wrapped.width = _width;
+  addRows(line, rows.size() + 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextWrap::getFirstRow(size_t line) const
+{
+  size_t row = 0;
+
+  for (size_t i = minimum(line, _lines.size()); i; i &= i - 1)
+    row += _tree[i];
+
+  return row;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextWrap::getLineAt(size_t row, size_t *rowInLine) const
+{
+  if (_lines.empty() || row >= _numRows)
+  {
+    if (rowInLine)
+      *rowInLine = _lines.empty() ? 0 : _lines.back().numRows - 1;
+
+    return _lines.empty() ? 0 : _lines.size() - 1;
+  }
+
+  // Descends the tree to the last line whose first row is at or before the row
+  size_t line = 0;
+  size_t mask = 1;
+
+  while (mask * 2 <= _lines.size())
+    mask *= 2;
+
+  for (; mask; mask /= 2)
+  {
+    if (line + mask <= _lines.size() && _tree[line + mask] <= row)
+    {
+      line += mask;
+      row -= _tree[line];
+    }
+  }
+
+  if (rowInLine)
+    *rowInLine = row;
+
+  return line;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextWrap::findPending()
+{
+  // Edited lines are usually wrapped when they're drawn, the rest of the lines doesn't have to be walked then
+  if (!_numPending)
+    _pending = _lines.size();
+
+  while (_pending < _lines.size() && _lines[_pending].width == _width)
+    ++_pending;
+
+  return _pending;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextWrap::estimateRows(size_t length) const
+{
+  if (_width <= 0)
+    return 1;
+
+  return maximum(static_cast<size_t>(1), (length * _charWidth + _width - 1) / _width);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextWrap::buildTree()
+{
+  size_t numLines = _lines.size();
+
+  _tree.assign(numLines + 1, 0);
+  _numRows = 0;
+
+  for (size_t i = 1; i <= numLines; ++i)
+  {
+    _tree[i] += _lines[i - 1].numRows;
+    _numRows += _lines[i - 1].numRows;
+
+    size_t parent = i + (i & (0 - i));
+    if (parent <= numLines)
+      _tree[parent] += _tree[i];
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextWrap::addRows(size_t line, size_t numRows)
+{
+  // Differences wrap around when rows are removed, sums still come out right
+  size_t delta = numRows - _lines[line].numRows;
+  _lines[line].numRows = numRows;
+  _numRows += delta;
+
+  for (size_t i = line + 1; i < _tree.size(); i += i & (0 - i))
+    _tree[i] += delta;
+}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Base.h"
+
+namespace nui {
+
+class TextBuffer;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Visual rows of word wrapped lines. Each line keeps its rows together with the width they were made for, lines not
+// wrapped for the current width count with rows estimated from their length. Row counts are summed in a Fenwick
+// tree so that conversions between rows and lines are O(log n) and the total is known without wrapping everything.
+class TextWrap
+{
+  public:
+    struct Row
+    {
+      // First byte of the row in the line and index of its first glyph quad, there's one quad per code point
+      size_t offset;
+      size_t quad;
+
+      // x of the first glyph in the line
+      int x;
+    };
+
+    void clear();
+
+    // Lines of the buffer are estimated for the width, charWidth is the average advance
+    void reset(const TextBuffer &buffer, int width, int charWidth);
+
+    // Existing rows are kept but become estimates until lines are wrapped again
+    void setWidth(int width, int charWidth);
+
+    int getWidth() const { return _width; }
+
+    // Lines from line to line + removed have been replaced by lines from line to line + added
+    void linesChanged(const TextBuffer &buffer, size_t line, size_t removed, size_t added);
+
+    size_t getNumLines() const { return _lines.size(); }
+
+    bool isWrapped(size_t line) const { return _lines[line].width == _width; }
+
+    // Stores rows of the line made for the current width, the first row starting at the beginning is implicit
+    void setRows(size_t line, const std::vector<Row> &rows);
+
+    // Rows after the first one, valid if the line is wrapped
+    const std::vector<Row> &getRows(size_t line) const { return _lines[line].rows; }
+
+    size_t getNumRows(size_t line) const { return _lines[line].numRows; }
+
+    // Total including estimates
+    size_t getNumRows() const { return _numRows; }
+
+    size_t getFirstRow(size_t line) const;
+
+    // Line containing the row, rowInLine receives index of the row within it
+    size_t getLineAt(size_t row, size_t *rowInLine) const;
+
+    // Number of lines with estimated rows
+    size_t getNumPending() const { return _numPending; }
+
+    // First line that needs wrapping or number of lines if there's none
+    size_t findPending();
+
+  private:
+    struct Line
+    {
+      size_t length;
+      size_t numRows;
+
+      // Width the rows were made for, 0 if they're estimated
+      int width;
+
+      std::vector<Row> rows;
+    };
+
+    size_t estimateRows(size_t length) const;
+
+    void buildTree();
+
+    void addRows(size_t line, size_t numRows);
+
+    std::vector<Line> _lines;
+
+    // One-based, entry i holds the sum of rows of lines (i - lowest set bit of i, i]
+    std::vector<size_t> _tree;
+
+    size_t _numRows = 0;
+
+    // Lines before this one are wrapped for the current width
+    size_t _pending = 0;
+
+    size_t _numPending = 0;
+
+    int _width = 0;
+
+    int _charWidth = 1;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+}
@@ -0,0 +1,409 @@
+#include "Tokenizer.h"
+#include "TextBuffer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace nui {
+
+//---------------------------------------------------------------------------------------------------------------------
+static bool isIdentifierChar(char c)
+{
+  return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int CppTokenizer::tokenize(const char *text, size_t length, int state, std::vector<Token> &tokens)
+{
+  size_t lineTokens = tokens.size();
+
+  // Neighbouring tokens of the same color are merged
+  auto add = [&](size_t offset, const RGBColor &color)
+  {
+    if (tokens.size() == lineTokens || tokens.back().color != color)
+      tokens.push_back({ offset, color });
+  };
+
+  bool continued = length && text[length - 1] == '\\';
+  size_t i = 0;
+
+  if (state == BlockComment)
+  {
+    add(0, commentColor);
+
+    for (; i + 1 < length; ++i)
+    {
+      if (text[i] == '*' && text[i + 1] == '/')
+        break;
+    }
+
+    if (i + 1 >= length)
+      return BlockComment;
+
+    i += 2;
+  }
+  else if (state == ContinuedPreprocessor)
+  {
+    add(0, preprocessorColor);
+    return continued ? ContinuedPreprocessor : Code;
+  }
+  else if (state == ContinuedString)
+  {
+    add(0, stringColor);
+
+    for (; i < length && text[i] != '"'; ++i)
+    {
+      if (text[i] == '\\')
+        ++i;
+    }
+
+    if (i >= length)
+      return continued ? ContinuedString : Code;
+
+    ++i;
+  }
+
+  // Only whitespace may precede a preprocessor directive
+  bool lineStart = i == 0;
+
+  while (i < length)
+  {
+    char c = text[i];
+    size_t start = i;
+
+    if (c == ' ' || c == '\t' || c == '\r')
+    {
+      ++i;
+      continue;
+    }
+
+    if (c == '#' && lineStart)
+    {
+      add(start, preprocessorColor);
+      return continued ? ContinuedPreprocessor : Code;
+    }
+
+    lineStart = false;
+
+    if (c == '/' && i + 1 < length && text[i + 1] == '/')
+    {
+      add(start, commentColor);
+      return Code;
+    }
+
+    if (c == '/' && i + 1 < length && text[i + 1] == '*')
+    {
+      add(start, commentColor);
+
+      for (i += 2; i + 1 < length; ++i)
+      {
+        if (text[i] == '*' && text[i + 1] == '/')
+          break;
+      }
+
+      if (i + 1 >= length)
+        return BlockComment;
+
+      i += 2;
+    }
+    else if (c == '"' || c == '\'')
+    {
+      add(start, stringColor);
+
+      for (++i; i < length && text[i] != c; ++i)
+      {
+        if (text[i] == '\\')
+          ++i;
+      }
+
+      if (i >= length)
+        return c == '"' && continued ? ContinuedString : Code;
+
+      ++i;
+    }
+    else if (isdigit(static_cast<unsigned char>(c)) || (c == '.' && i + 1 < length && isdigit(static_cast<unsigned char>(text[i + 1]))))
+    {
+      add(start, numberColor);
+
+      // Digit separators, hexadecimal digits, exponents and suffixes
+      while (i < length && (isIdentifierChar(text[i]) || text[i] == '.' || text[i] == '\''))
+        ++i;
+    }
+    else if (isIdentifierChar(c))
+    {
+      while (i < length && isIdentifierChar(text[i]))
+        ++i;
+
+      add(start, isKeyword(text + start, i - start) ? keywordColor : textColor);
+    }
+    else
+    {
+      add(start, textColor);
+      ++i;
+    }
+  }
+
+  return Code;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool CppTokenizer::isKeyword(const char *word, size_t length)
+{
+  // Sorted for binary search
+  static const char *keywords[] =
+  {
+    "alignas", "alignof", "asm", "auto", "bool", "break", "case", "catch", "char", "char16_t", "char32_t", "class",
+    "const", "const_cast", "constexpr", "continue", "decltype", "default", "delete", "do", "double", "dynamic_cast",
+    "else", "enum", "explicit", "export", "extern", "false", "final", "float", "for", "friend", "goto", "if", "inline",
+    "int", "long", "mutable", "namespace", "new", "noexcept", "nullptr", "operator", "override", "private",
+    "protected", "public", "register", "reinterpret_cast", "return", "short", "signed", "sizeof", "static",
+    "static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true", "try",
+    "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while"
+  };
+
+  auto less = [](const char *keyword, const std::string &word) { return word.compare(keyword) > 0; };
+
+  std::string key(word, length);
+  const char **end = keywords + sizeof(keywords) / sizeof(keywords[0]);
+  const char **found = std::lower_bound(keywords, end, key, less);
+
+  return found != end && key == *found;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void LexerStates::linesChanged(size_t line, size_t removed, size_t added)
+{
+  if (line >= _numLines)
+    return;
+
+  // Edit reaches past the lexed lines, the rest is lexed from scratch when needed
+  if (line + removed >= _numLines)
+  {
+    truncate(line);
+    _dirty.erase(std::lower_bound(_dirty.begin(), _dirty.end(), line), _dirty.end());
+    return;
+  }
+
+  size_t common = minimum(removed, added) + 1;
+
+  for (size_t i = line; i < line + common; ++i)
+    getEndState(i) = Unknown;
+
+  if (removed > added)
+    eraseStates(line + common, removed - added);
+  else if (added > removed)
+    insertStates(line + common, added - removed);
+
+  // Ranges starting inside the edit are joined with it, only the ones after it are moved
+  auto inside = std::upper_bound(_dirty.begin(), _dirty.end(), line);
+  auto after = std::upper_bound(inside, _dirty.end(), line + removed);
+
+  for (auto i = after; i != _dirty.end(); ++i)
+    *i = *i - removed + added;
+
+  auto next = _dirty.erase(inside, after);
+  if (next == _dirty.begin() || *std::prev(next) != line)
+    _dirty.insert(next, line);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int LexerStates::getState(const TextBuffer &buffer, Tokenizer *tokenizer, size_t line)
+{
+  if (!line)
+    return 0;
+
+  size_t last = line - 1;
+
+  auto lex = [&](size_t i)
+  {
+    size_t length = buffer.getLineLength(i);
+    const char *text = buffer.getData(buffer.getLineOffset(i), length, _lineText);
+
+    _tokens.clear();
+    return tokenizer->tokenize(text, length, i ? getEndState(i - 1) : 0, _tokens);
+  };
+
+  // Lines before the first edited range are valid
+  while (!_dirty.empty() && _dirty.front() <= last)
+  {
+    size_t i = _dirty.front();
+    bool converged = false;
+
+    for (; i < _numLines; ++i)
+    {
+      int &state = getEndState(i);
+      int previous = state;
+      state = lex(i);
+      converged = state == previous;
+
+      if (converged || i == last)
+        break;
+    }
+
+    // Ranges passed over are valid now
+    _dirty.erase(_dirty.begin(), std::upper_bound(_dirty.begin(), _dirty.end(), i));
+
+    // Following lines may still change, they're lexed when asked for
+    if (!converged && i == last && i + 1 < _numLines && (_dirty.empty() || _dirty.front() != i + 1))
+      _dirty.insert(_dirty.begin(), i + 1);
+  }
+
+  while (_numLines <= last)
+    pushState(lex(_numLines));
+
+  return getEndState(last);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t LexerStates::findChunk(size_t &line) const
+{
+  // Descends the tree to the last chunk starting at or before the line
+  size_t chunk = 0;
+  size_t mask = 1;
+
+  while (mask * 2 <= _chunks.size())
+    mask *= 2;
+
+  for (; mask; mask /= 2)
+  {
+    if (chunk + mask <= _chunks.size() && _tree[chunk + mask] <= line)
+    {
+      chunk += mask;
+      line -= _tree[chunk];
+    }
+  }
+
+  return chunk;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void LexerStates::pushState(int state)
+{
+  if (_chunks.empty() || _chunks.back().size() >= ChunkSize)
+  {
+    _chunks.emplace_back();
+    _chunks.back().reserve(ChunkSize);
+
+    // Entry of the new chunk covers the lines of the chunks before it in its range
+    size_t i = _chunks.size();
+    size_t first = 0;
+
+    for (size_t j = i - (i & (0 - i)); j; j &= j - 1)
+      first += _tree[j];
+
+    _tree.resize(i + 1);
+    _tree[i] = _numLines - first;
+  }
+
+  _chunks.back().push_back(state);
+  ++_numLines;
+  addLines(_chunks.size() - 1, 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void LexerStates::insertStates(size_t line, size_t count)
+{
+  if (line == _numLines)
+  {
+    while (count--)
+      pushState(Unknown);
+
+    return;
+  }
+
+  size_t chunk = findChunk(line);
+  std::vector<int> &states = _chunks[chunk];
+  states.insert(states.begin() + line, count, static_cast<int>(Unknown));
+  _numLines += count;
+
+  if (states.size() < 2 * ChunkSize)
+  {
+    addLines(chunk, count);
+    return;
+  }
+
+  // Large chunk is split into full ones
+  std::vector<std::vector<int>> pieces;
+  for (size_t i = 0; i < states.size(); i += ChunkSize)
+    pieces.emplace_back(states.begin() + i, states.begin() + minimum(i + ChunkSize, states.size()));
+
+  _chunks.erase(_chunks.begin() + chunk);
+  _chunks.insert(_chunks.begin() + chunk, std::make_move_iterator(pieces.begin()), std::make_move_iterator(pieces.end()));
+  buildTree();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void LexerStates::eraseStates(size_t line, size_t count)
+{
+  size_t first = findChunk(line);
+  size_t chunk = first;
+  size_t erased = count;
+
+  for (; count; ++chunk)
+  {
+    std::vector<int> &states = _chunks[chunk];
+    size_t n = minimum(count, states.size() - line);
+
+    states.erase(states.begin() + line, states.begin() + line + n);
+    count -= n;
+    line = 0;
+  }
+
+  _numLines -= erased;
+
+  if (chunk == first + 1 && !_chunks[first].empty())
+  {
+    addLines(first, 0 - erased);
+    return;
+  }
+
+  _chunks.erase(std::remove_if(_chunks.begin() + first, _chunks.begin() + chunk,
+    [](const std::vector<int> &states) { return states.empty(); }), _chunks.begin() + chunk);
+  buildTree();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void LexerStates::truncate(size_t numLines)
+{
+  if (numLines >= _numLines)
+    return;
+
+  size_t line = numLines;
+  size_t chunk = numLines ? findChunk(line) : 0;
+
+  _chunks.resize(chunk + 1);
+  _chunks[chunk].resize(line);
+
+  if (_chunks[chunk].empty())
+    _chunks.pop_back();
+
+  _numLines = numLines;
+  buildTree();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void LexerStates::buildTree()
+{
+  size_t numChunks = _chunks.size();
+
+  _tree.assign(numChunks + 1, 0);
+
+  for (size_t i = 1; i <= numChunks; ++i)
+  {
+    _tree[i] += _chunks[i - 1].size();
+
+    size_t parent = i + (i & (0 - i));
+    if (parent <= numChunks)
+      _tree[parent] += _tree[i];
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void LexerStates::addLines(size_t chunk, size_t delta)
+{
+  for (size_t i = chunk + 1; i < _tree.size(); i += i & (0 - i))
+    _tree[i] += delta;
+}
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "Base.h"
+
+namespace nui {
+
+class TextBuffer;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Splits lines into colored tokens for syntax highlighting. Lexer state carries constructs spanning several lines
+// such as block comments to the next line, state at the beginning of the text is 0 and negative states are reserved.
+class Tokenizer : public Object
+{
+  public:
+    typedef nui::Ptr<Tokenizer> Ptr;
+
+    struct Token
+    {
+      // First byte of the token in the line, the token ends where the next one starts
+      size_t offset;
+      RGBColor color;
+    };
+
+    // Appends tokens of a line starting in given state, returns state at the end of the line. Text before the first
+    // token has the style's text color.
+    virtual int tokenize(const char *text, size_t length, int state, std::vector<Token> &tokens) = 0;
+
+  protected:
+    Tokenizer() : Object() { }
+    virtual ~Tokenizer() { }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Comments, strings, numbers, keywords and preprocessor lines of C and C++
+class CppTokenizer : public Tokenizer
+{
+  public:
+    typedef nui::Ptr<CppTokenizer> Ptr;
+
+    enum Values
+    {
+      DefaultTextColor = 0xD8D8D8,
+      DefaultKeywordColor = 0x60A0FF,
+      DefaultCommentColor = 0x60A060,
+      DefaultStringColor = 0xE0A070,
+      DefaultNumberColor = 0xB0D0A0,
+      DefaultPreprocessorColor = 0xB080D0
+    };
+
+    RGBColor textColor = DefaultTextColor;
+    RGBColor keywordColor = DefaultKeywordColor;
+    RGBColor commentColor = DefaultCommentColor;
+    RGBColor stringColor = DefaultStringColor;
+    RGBColor numberColor = DefaultNumberColor;
+    RGBColor preprocessorColor = DefaultPreprocessorColor;
+
+    CppTokenizer() : Tokenizer() { }
+
+    int tokenize(const char *text, size_t length, int state, std::vector<Token> &tokens) override;
+
+  private:
+    enum State
+    {
+      Code = 0,
+      BlockComment,
+
+      // Line ended with a backslash
+      ContinuedString,
+      ContinuedPreprocessor
+    };
+
+    static bool isKeyword(const char *word, size_t length);
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Lexer states at the end of each line of a document. Edited lines are marked and lexed again on demand together with
+// lines following them until a line ends in the same state as before, so the cost of an edit doesn't depend on the
+// document size. Lines are only lexed up to the last one asked for. States are kept in chunks of lines indexed by a
+// Fenwick tree, inserting or removing lines only moves the states of the chunk they're in.
+class LexerStates
+{
+  public:
+    void clear()
+    {
+      _chunks.clear();
+      _tree.clear();
+      _numLines = 0;
+      _dirty.clear();
+    }
+
+    // Lines from line to line + removed have been replaced by lines from line to line + added
+    void linesChanged(size_t line, size_t removed, size_t added);
+
+    // State at the beginning of the line, lines before it are lexed if needed
+    int getState(const TextBuffer &buffer, Tokenizer *tokenizer, size_t line);
+
+  private:
+    enum
+    {
+      // Never returned by tokenizers, lines with this end state are lexed again regardless of the result
+      Unknown = -1,
+
+      // Chunks are filled up to this many lines and split when insertions make them twice as large
+      ChunkSize = 256
+    };
+
+    // Chunk containing the line, line receives its index within the chunk
+    size_t findChunk(size_t &line) const;
+
+    int &getEndState(size_t line)
+    {
+      size_t chunk = findChunk(line);
+      return _chunks[chunk][line];
+    }
+
+    void pushState(int state);
+
+    // Unknown states are inserted before the line, it may be the one after the last line
+    void insertStates(size_t line, size_t count);
+
+    void eraseStates(size_t line, size_t count);
+
+    void truncate(size_t numLines);
+
+    void buildTree();
+
+    // Adds the difference to the line count of the chunk, wrapping around for removed lines
+    void addLines(size_t chunk, size_t delta);
+
+    // End states of lines lexed so far
+    std::vector<std::vector<int>> _chunks;
+
+    // One-based, entry i holds the number of lines in chunks (i - lowest set bit of i, i]
+    std::vector<size_t> _tree;
+
+    size_t _numLines = 0;
+
+    // First lines of edited ranges in ascending order
+    std::vector<size_t> _dirty;
+
+    std::vector<Tokenizer::Token> _tokens;
+    std::string _lineText;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+}
@@ -7,6 +7,7 @@ CheckBox::CheckBox(Control *parent, const std::string &text, Docking docking)
   : Control(parent, text, docking)
 {
   addFlags(CanFocus);
+  subscribe(Event::Type::Click);
   setMinimumSize(Graphics::Style::CheckBoxSize, Graphics::Style::CheckBoxSize);
 }
 
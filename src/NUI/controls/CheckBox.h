@@ -20,7 +20,7 @@ class CheckBox : public Control
       if (_checked != set)
       {
         _checked = set;
-        setDirty();
+        invalidate();
       }
     }
 
@@ -13,6 +13,7 @@ MenuItem::MenuItem(bool inMenuBar, Control *parent, const std::string &text, int
 
   setMargins(0);
   addFlags(CanFocus);
+  subscribe(Event::Type::ExclusivityChanged);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
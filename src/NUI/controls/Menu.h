@@ -68,7 +68,7 @@ class Menu : public Control
 
       _rect.width = 0;
       _rect.height = 0;
-      autoSize(true);
+      requestAutoSize();
 
       return item;
     }
@@ -87,6 +87,9 @@ class MenuBar : public Control
       : Control(parent, std::string(), Docking::Top)
     {
       setPadding(0);
+      subscribe(Event::Type::MouseButton);
+      subscribe(Event::Type::ExclusivityChanged);
+      subscribe(Event::Type::HotChanged);
     }
 
     void draw(Graphics *graphics) override;
@@ -98,7 +101,7 @@ class MenuBar : public Control
 
       _rect.width = 0;
       _rect.height = 0;
-      autoSize(true);
+      requestAutoSize();
 
       Menu *menu = new Menu(item);
       item->setSubMenu(menu);
@@ -0,0 +1,112 @@
+#include "ProfilerOverlay.h"
+
+#if defined(NUI_PROFILER)
+
+#include <cstdio>
+
+namespace nui {
+
+//---------------------------------------------------------------------------------------------------------------------
+ProfilerOverlay::ProfilerOverlay(Control *parent)
+  : Control(parent)
+{
+  addFlags(Volatile | AlwaysBringToFront);
+  setSize(Profiler::MaxFrames + Graphics::Style::DefaultPadding * 2, 160);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ProfilerOverlay::draw(Graphics *graphics)
+{
+  static const NVGcolor sectionColors[] =
+  {
+    nvgRGB(0x40, 0xA0, 0xF0), // Tick
+    nvgRGB(0xF0, 0xC0, 0x40), // Layout
+    nvgRGB(0x60, 0xD0, 0x60), // Draw
+    nvgRGB(0xE0, 0x60, 0x40), // EndFrame
+    nvgRGB(0xC0, 0x60, 0xE0), // Flush
+  };
+
+  // Frame graph covers 0..2x 60 FPS budget
+  const float budget = 1000.0f / 60.0f;
+  const int padding = Graphics::Style::DefaultPadding;
+  const int graphHeight = 64;
+
+  NVGcontext *vg = graphics->nvgContext;
+  const Profiler &profiler = Profiler::get();
+
+  graphics->drawBevel(0, 0, _rect.width, _rect.height, 0, Graphics::Bevel::Menu);
+
+  float scale = static_cast<float>(graphHeight) / (budget * 2.0f);
+  float bottom = static_cast<float>(padding + graphHeight);
+
+  for (size_t i = 0; i < profiler.getNumFrames(); ++i)
+  {
+    const Profiler::Frame &frame = profiler.getFrame(i);
+    float x = static_cast<float>(_rect.width - padding - 1 - static_cast<int>(i));
+    float y = bottom;
+
+    for (size_t s = 0; s < static_cast<size_t>(Profiler::Section::Count) && y > padding; ++s)
+    {
+      // Layout is measured inside of tick, it's shown as the bottom part of its bar
+      if (s == static_cast<size_t>(Profiler::Section::Layout))
+        continue;
+
+      float h = minimum(static_cast<float>(frame.times[s]) * scale, y - padding);
+
+      nvgBeginPath(vg);
+      nvgRect(vg, x, y - h, 1.0f, h);
+      nvgFillColor(vg, sectionColors[s]);
+      nvgFill(vg);
+
+      if (s == static_cast<size_t>(Profiler::Section::Tick))
+      {
+        float layoutHeight = minimum(static_cast<float>(frame.getTime(Profiler::Section::Layout)) * scale, h);
+
+        nvgBeginPath(vg);
+        nvgRect(vg, x, y - layoutHeight, 1.0f, layoutHeight);
+        nvgFillColor(vg, sectionColors[static_cast<size_t>(Profiler::Section::Layout)]);
+        nvgFill(vg);
+      }
+
+      y -= h;
+    }
+  }
+
+  nvgBeginPath(vg);
+  nvgMoveTo(vg, static_cast<float>(padding), bottom - budget * scale);
+  nvgLineTo(vg, static_cast<float>(_rect.width - padding), bottom - budget * scale);
+  nvgStrokeColor(vg, nvgRGBA(0xFF, 0xFF, 0xFF, 0x80));
+  nvgStrokeWidth(vg, 1.0f);
+  nvgStroke(vg);
+
+  if (!profiler.getNumFrames())
+    return;
+
+  const Profiler::Frame &frame = profiler.getFrame(0);
+  char line[128];
+  int y = padding + graphHeight + 14;
+
+  for (size_t s = 0; s < static_cast<size_t>(Profiler::Section::Count); ++s)
+  {
+    snprintf(line, sizeof(line), "%s %.2f ms", Profiler::getSectionName(static_cast<Profiler::Section>(s)), frame.times[s]);
+
+    int x = padding + static_cast<int>(s % 2) * (_rect.width / 2);
+    graphics->drawText(x, y + static_cast<int>(s / 2) * 14, line, false, Graphics::HAlign::Left);
+  }
+
+  y += 3 * 14;
+
+  snprintf(line, sizeof(line), "calls %u  paths %u  verts %u  uploads %u",
+    frame.getCounter(Profiler::Counter::RenderCalls), frame.getCounter(Profiler::Counter::Paths),
+    frame.getCounter(Profiler::Counter::Vertices), frame.getCounter(Profiler::Counter::TextureUploads));
+  graphics->drawText(padding, y, line, false, Graphics::HAlign::Left);
+
+  snprintf(line, sizeof(line), "painted %u  replayed %u  arranged %u",
+    frame.getCounter(Profiler::Counter::ControlsPainted), frame.getCounter(Profiler::Counter::ControlsReplayed),
+    frame.getCounter(Profiler::Counter::ControlsArranged));
+  graphics->drawText(padding, y + 14, line, false, Graphics::HAlign::Left);
+}
+
+}
+
+#endif
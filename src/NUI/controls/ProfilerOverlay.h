@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../Control.h"
+
+#if defined(NUI_PROFILER)
+
+namespace nui {
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Graph of recent frame times and counters of the last frame measured by Profiler
+class ProfilerOverlay : public Control
+{
+  public:
+    NUI_CONTROL(ProfilerOverlay, Control);
+
+    explicit ProfilerOverlay(Control *parent = nullptr);
+
+    void draw(Graphics *graphics) override;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace nui
+
+#endif
@@ -1,4 +1,7 @@
 #include "Root.h"
+#include "../MappedFile.h"
+
+#include <climits>
 
 namespace nui {
 
@@ -6,8 +9,11 @@ namespace nui {
 Root::Root(NVGcontext *nvgCtx)
   : Control()
   , _nvgContext(nvgCtx)
-  , _nvgGlyphPositionBuffer(new NVGglyphPosition[1024])
+  , _controlPool(new ControlPool())
+  , _textMetrics(nvgCtx)
 {
+  ControlPool::setCurrent(_controlPool);
+
   setFlags(getFlags() | CanDockChildren);
   setMargins(0);
   setPadding(0);
@@ -28,17 +34,173 @@ Root::Root(NVGcontext *nvgCtx)
 //---------------------------------------------------------------------------------------------------------------------
 void Root::tick(double time, double delta)
 {
+  NUI_PROFILE_BEGIN_FRAME();
+  NUI_PROFILE_SCOPE(Tick);
+
+  // Controls created by event handlers belong to this root
+  ControlPool::setCurrent(_controlPool);
+
+  dispatchInput();
+
   _cursorBlinker += 2.0 * delta;
 
   while (_cursorBlinker >= 2.0)
     _cursorBlinker -= 2.0;
 
+  // Blinking text cursor is the only thing that changes without any event
+  float cursorAlpha = Graphics::getCursorAlpha(_cursorBlinker);
+  if (_cursorAlpha != cursorAlpha)
+  {
+    _cursorAlpha = cursorAlpha;
+
+    if (_focusedControl && (_focusedControl->_flags & NeedsTextInput))
+      _focusedControl->invalidateCursor();
+  }
+
+  _tickStats = TickStats();
+
+  // Sizes requested by children are known before any parent arranges them
+  measure();
+
   Super::tick(time, delta);
+
+  _frameStats.ticked = _tickStats.visited;
+  _frameStats.measured = _tickStats.measured;
+  _frameStats.arranged = _tickStats.arranged;
+
+  NUI_PROFILE_COUNTER(ControlsTicked, _frameStats.ticked);
+  NUI_PROFILE_COUNTER(ControlsMeasured, _frameStats.measured);
+  NUI_PROFILE_COUNTER(ControlsArranged, _frameStats.arranged);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Root::addDamage(const Rect &rect)
+{
+  Rect r = rect * _rect;
+
+  if (r.isEmpty())
+    return;
+
+  // Merge with overlapping areas so that nothing gets painted twice
+  for (size_t i = 0; i < _damage.size();)
+  {
+    if (_damage[i].contains(r))
+      return;
+
+    if (_damage[i].intersects(r))
+    {
+      r |= _damage[i];
+      _damage[i] = _damage.back();
+      _damage.pop_back();
+      i = 0;
+    }
+    else
+      ++i;
+  }
+
+  if (_damage.size() >= MaxDamageRects)
+  {
+    for (auto &d : _damage)
+      r |= d;
+
+    _damage.clear();
+  }
+
+  _damage.push_back(r);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Root::updatePaintedRects(Control *control, const Vec2 &offset, const Rect &clip)
+{
+  const Rect &r = control->_rect;
+  const Borders &padding = control->_padding;
+
+  Rect controlRect = Rect(offset.x + r.x, offset.y + r.y, r.width, r.height);
+  Rect controlClip = controlRect * clip;
+
+  // Shadows are painted by preDraw() outside of the control's rectangle
+  Rect bounds = controlRect;
+  if (control->_flags & PreDraw)
+    bounds.inflate(Graphics::Style::ShadowMargin);
+
+  bounds *= clip;
+
+  // Repainted control may have moved its children without marking them
+  bool relayout = control->_repaint;
+
+  if (control->_repaint || (control->_flags & Volatile) || bounds != control->_paintedRect)
+  {
+    addDamage(control->_paintedRect);
+    addDamage(bounds);
+
+    control->_paintedRect = bounds;
+    control->_repaint = false;
+  }
+
+  Vec2 contentOffset = Vec2(controlRect.x + padding.left, controlRect.y + padding.top + control->_titleHeight);
+  Vec2 undockedOffset = contentOffset + control->_undockedOffset;
+  Rect contentClip = Rect(contentOffset.x, contentOffset.y, r.width - padding.getHorizontal(), r.height - padding.getVertical() - control->_titleHeight) * controlClip;
+
+  if (control->_paintedContentOffset.set(contentOffset) | control->_paintedUndockedOffset.set(undockedOffset))
+    relayout = true;
+
+  if (control->_paintedControlClip != controlClip || control->_paintedContentClip != contentClip)
+  {
+    control->_paintedControlClip = controlClip;
+    control->_paintedContentClip = contentClip;
+    relayout = true;
+  }
+
+  // Volatile children keep the flag set, so they are reached by every pass
+  bool subtreeRepaint = false;
+
+  // Same order and clipping as in traverseControl()
+  for (Control *child : control->_children)
+  {
+    if (!relayout && !child->_repaint && !child->_subtreeRepaint && !(child->_flags & Volatile))
+      continue;
+
+    if (!child->isVisible())
+    {
+      child->releasePaintedArea();
+      continue;
+    }
+
+    bool parentClip = (child->_flags & ParentClip) != 0;
+
+    switch (child->_docking)
+    {
+      case Docking::None:
+        if (parentClip)
+          updatePaintedRects(child, contentOffset, controlClip);
+        else
+          updatePaintedRects(child, undockedOffset, contentClip);
+        break;
+
+      case Docking::Client:
+        updatePaintedRects(child, undockedOffset, contentClip);
+        break;
+
+      default:
+        if (parentClip)
+          child->releasePaintedArea();
+        else
+          updatePaintedRects(child, contentOffset, contentClip);
+        break;
+    }
+
+    if (child->_subtreeRepaint || (child->_flags & Volatile))
+      subtreeRepaint = true;
+  }
+
+  control->_subtreeRepaint = subtreeRepaint;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void Root::traverseControl(Graphics *graphics, Control *control)
 {
+  ++_frameStats.painted;
+
   Graphics::State oldState = graphics->state;
 
   const Rect &r = control->getRect();
@@ -63,7 +225,7 @@ void Root::traverseControl(Graphics *graphics, Control *control)
   nvgIntersectScissor(_nvgContext, 0, 0, static_cast<float>(r.width), static_cast<float>(r.height));
 
   if (control->_flags & Flags::Draw)
-    control->draw(graphics);
+    drawControl(graphics, control);
 
   // Pad & clip & draw child control area
   const Borders &padding = control->getPadding();
@@ -74,9 +236,9 @@ void Root::traverseControl(Graphics *graphics, Control *control)
   nvgIntersectScissor(_nvgContext, 0, 0, static_cast<float>(r.width - padding.getHorizontal()), static_cast<float>(r.height - padding.getVertical() - titleHeight));
 
   // Draw all docked children first
-  for (auto child : (*control))
+  for (Control *child : (*control))
   {
-    if (!child->isVisible()) continue;
+    if (!child->isVisible() || !child->_paintedRect.intersects(_drawArea)) continue;
 
     if (child->_docking != Docking::None && child->_docking != Docking::Client && !((child->_flags & ParentClip)))
       traverseControl(graphics, child);
@@ -85,9 +247,9 @@ void Root::traverseControl(Graphics *graphics, Control *control)
   nvgTranslate(_nvgContext, static_cast<float>(control->_undockedOffset.x), static_cast<float>(control->_undockedOffset.y));
 
   // Draw remaining undocked children with standard clipping
-  for (auto child : (*control))
+  for (Control *child : (*control))
   {
-    if (!child->isVisible()) continue;
+    if (!child->isVisible() || !child->_paintedRect.intersects(_drawArea)) continue;
 
     if (child->_docking == Docking::None && (child->_flags & ParentClip))
       continue;
@@ -101,9 +263,9 @@ void Root::traverseControl(Graphics *graphics, Control *control)
   nvgTranslate(_nvgContext, static_cast<float>(padding.left), static_cast<float>(padding.top + titleHeight));
 
   // Draw children with parent clipping
-  for (auto child : (*control))
+  for (Control *child : (*control))
   {
-    if (!child->isVisible()) continue;
+    if (!child->isVisible() || !child->_paintedRect.intersects(_drawArea)) continue;
 
     if (child->_docking == Docking::None && (child->_flags & ParentClip))
       traverseControl(graphics, child);
@@ -117,8 +279,80 @@ void Root::traverseControl(Graphics *graphics, Control *control)
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void Root::draw()
+void Root::drawControl(Graphics *graphics, Control *control)
 {
+  NUI_PROFILE_CONTROL(control);
+
+  // Recording would be thrown away every frame
+  if (control->_flags & Volatile)
+  {
+    control->draw(graphics);
+    return;
+  }
+
+  DrawCache &cache = control->_drawCache;
+  const Graphics::Style *style = graphics->state.style;
+
+  bool matches = cache.valid &&
+    cache.size.x == control->_rect.width && cache.size.y == control->_rect.height &&
+    cache.state == control->_state &&
+    cache.style == style &&
+    cache.color == style->color && cache.secondaryColor == style->secondaryColor &&
+    cache.textColor == style->textColor && cache.textSize == style->textSize &&
+    cache.alpha == graphics->state.alpha;
+
+  // Replaying fails if the transformation or clipping has changed in an incompatible way
+  if (matches && nvgReplayRecording(_nvgContext, cache.recording))
+  {
+    ++_frameStats.replayed;
+    return;
+  }
+
+  if (!cache.recording)
+    cache.recording = nvgCreateRecording();
+
+  if (!cache.recording)
+  {
+    control->draw(graphics);
+    return;
+  }
+
+  nvgBeginRecording(_nvgContext, cache.recording);
+  control->draw(graphics);
+  nvgEndRecording(_nvgContext);
+
+  cache.valid = true;
+  cache.size = control->_rect.getSize();
+  cache.state = control->_state;
+  cache.style = style;
+  cache.color = style->color;
+  cache.secondaryColor = style->secondaryColor;
+  cache.textColor = style->textColor;
+  cache.textSize = style->textSize;
+  cache.alpha = graphics->state.alpha;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool Root::draw()
+{
+  NUI_PROFILE_SCOPE(Draw);
+
+  updatePaintedRects(this, Vec2(), _rect);
+
+  int fontAsyncGeneration = nvgFontAsyncGeneration(_nvgContext);
+  if (_fontAsyncGeneration != fontAsyncGeneration)
+  {
+    _fontAsyncGeneration = fontAsyncGeneration;
+    addDamage(_paintedRect);
+  }
+
+  _repaintedArea = Rect(0, 0, 0, 0);
+  _frameStats.painted = 0;
+  _frameStats.replayed = 0;
+
+  if (_damage.empty())
+    return false;
+
   Graphics graphics;
   graphics.nvgContext = _nvgContext;
   graphics.normalFontID = _normalFontID;
@@ -128,27 +362,48 @@ void Root::draw()
 
   graphics.state.style = getStyle();
   graphics.state.alpha = 1.0f;
-  
-  traverseControl(&graphics, this);
+
+  // Everything outside of the damaged areas is preserved from previous frames
+  for (auto &damage : _damage)
+  {
+    _drawArea = damage;
+    _repaintedArea |= damage;
+
+    nvgSave(_nvgContext);
+    nvgScissor(_nvgContext, static_cast<float>(damage.x), static_cast<float>(damage.y), static_cast<float>(damage.width), static_cast<float>(damage.height));
+
+    nvgBeginPath(_nvgContext);
+    nvgRect(_nvgContext, static_cast<float>(damage.x - 1), static_cast<float>(damage.y - 1), static_cast<float>(damage.width + 2), static_cast<float>(damage.height + 2));
+    nvgFillColor(_nvgContext, _backgroundColor.nvg());
+    nvgFill(_nvgContext);
+
+    traverseControl(&graphics, this);
+
+    nvgRestore(_nvgContext);
+  }
+
+  _damage.clear();
+
+#if defined(NUI_PROFILER)
+  NVGframeStats stats;
+  nvgFrameStats(_nvgContext, &stats);
+
+  NUI_PROFILE_COUNTER(RenderCalls, stats.renderCalls);
+  NUI_PROFILE_COUNTER(DrawCalls, stats.drawCalls);
+  NUI_PROFILE_COUNTER(Paths, stats.paths);
+  NUI_PROFILE_COUNTER(Vertices, stats.vertices);
+  NUI_PROFILE_COUNTER(TextureUploads, stats.textureUploads);
+  NUI_PROFILE_COUNTER(ControlsPainted, _frameStats.painted);
+  NUI_PROFILE_COUNTER(ControlsReplayed, _frameStats.replayed);
+#endif
+
+  return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 Vec2 Root::measureText(int fontSize, const char *text, const char *endText, bool monospace) const
 {
-  Vec2 result;
-  result.y = fontSize;
-
-  nvgFontFaceId(_nvgContext, monospace ? _monospaceFontID : _normalFontID);
-  nvgFontSize(_nvgContext, static_cast<float>(fontSize));
-  
-  int num = nvgTextGlyphPositions(_nvgContext, 0, 0, text, endText, _nvgGlyphPositionBuffer, 1024);
-
-  if (num)
-  {
-    result.x = static_cast<int>(_nvgGlyphPositionBuffer[num - 1].x);
-  }
-    
-  return result;
+  return Vec2(_textMetrics.measure(monospace ? _monospaceFontID : _normalFontID, fontSize, text, endText), fontSize);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -157,31 +412,48 @@ int Root::measureIndex(int fontSize, const char *text, int x, int *charX, bool m
   if (x <= 0 || !text)
     return 0;
 
-  int result = 0;
-  int lastPos = 0;
+  layoutText(fontSize, text, nullptr, _glyphRun, monospace);
+  return static_cast<int>(_glyphRun.getOffsetAt(x, charX));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Root::layoutText(int fontSize, const char *text, const char *endText, GlyphRun &run, bool monospace) const
+{
+  _textMetrics.layout(monospace ? _monospaceFontID : _normalFontID, fontSize, text, endText, run);
+}
 
-  nvgFontFaceId(_nvgContext, monospace ? _monospaceFontID : _normalFontID);
+//---------------------------------------------------------------------------------------------------------------------
+void Root::prefetchGlyphs(int fontSize, unsigned first, unsigned last)
+{
+  nvgSave(_nvgContext);
   nvgFontSize(_nvgContext, static_cast<float>(fontSize));
-  nvgTextGlyphPositions(_nvgContext, 0, 0, text, nullptr, _nvgGlyphPositionBuffer, 1024);
 
-  NVGglyphPosition *gp = _nvgGlyphPositionBuffer;
-  while (text[result] && result < 1024)
-  {
-    float middle = (gp->minx + gp->maxx) * 0.5f;
-    lastPos = static_cast<int>(gp->x);
-    if (x <= static_cast<int>(middle))
-      break;
+  nvgFontFaceId(_nvgContext, _normalFontID);
+  nvgPrefetchGlyphs(_nvgContext, first, last);
 
-    lastPos = static_cast<int>(gp->maxx);
+  nvgFontFaceId(_nvgContext, _monospaceFontID);
+  nvgPrefetchGlyphs(_nvgContext, first, last);
 
-    ++result;
-    ++gp;
-  }
+  nvgRestore(_nvgContext);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool Root::loadFontCache(const std::string &fileName)
+{
+  // Atlas is copied out of the mapping, it's not needed after loading
+  MappedFile file;
 
-  if (charX)
-    *charX = lastPos;
+  if (!file.open(fileName) || file.getSize() > static_cast<size_t>(INT_MAX))
+    return false;
 
-  return result;
+  return nvgLoadFontCache(_nvgContext, reinterpret_cast<const unsigned char *>(file.getData()),
+    static_cast<int>(file.getSize())) != 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool Root::saveFontCache(const std::string &fileName) const
+{
+  return nvgSaveFontCache(_nvgContext, fileName.c_str()) != 0;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -202,7 +474,7 @@ void Root::setExclusiveControl(Control *control)
 
     _exclusiveControl = control;
 
-    if (oldExclusiveControl)
+    if (oldExclusiveControl && oldExclusiveControl->hasEventHandler(Event::Type::ExclusivityChanged))
     {
       Event e(Event::Type::ExclusivityChanged, oldExclusiveControl);
       oldExclusiveControl->processEvent(e);
@@ -219,17 +491,38 @@ void Root::setExclusiveControl(Control *control)
       _exclusiveControl->addFlags(Flags::ParentClip);
       _exclusiveControl->setParent(this);
 
-      Event e(Event::Type::ExclusivityChanged, _exclusiveControl);
-      _exclusiveControl->processEvent(e);
+      if (_exclusiveControl->hasEventHandler(Event::Type::ExclusivityChanged))
+      {
+        Event e(Event::Type::ExclusivityChanged, _exclusiveControl);
+        _exclusiveControl->processEvent(e);
+      }
     }
   }
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+Control::ControlPointInfo Root::hitTest(int x, int y)
+{
+  if (_hitCache.layoutGeneration == getLayoutGeneration() && _hitCache.stableArea.isPointInside(x, y))
+    return _hitCache.result;
+
+  Rect stableArea = Rect(0, 0, _rect.width, _rect.height);
+
+  if (!stableArea.isPointInside(x, y))
+    stableArea = Rect(x, y, 1, 1);
+
+  _hitCache.result = controlAtPoint(x, y, stableArea);
+  _hitCache.stableArea = stableArea;
+  _hitCache.layoutGeneration = getLayoutGeneration();
+
+  return _hitCache.result;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 bool Root::eventMouseMotion(int x, int y)
 {
   Vec2 delta = Vec2(x - _mouseState.position.x, y - _mouseState.position.y);
-  ControlPointInfo hot = controlAtPoint(x, y);
+  ControlPointInfo hot = hitTest(x, y);
 
   switch (_mouseState.mode)
   {
@@ -275,12 +568,10 @@ bool Root::eventMouseMotion(int x, int y)
         if (hot.control != _grabbedControl && (_grabbedControl->_state & State::Down))
         {
           _grabbedControl->removeState(State::Down);
-          _grabbedControl->setDirty();
         }
         else if (hot.control == _grabbedControl && !(_grabbedControl->_state & State::Down))
         {
           _grabbedControl->addState(State::Down);
-          _grabbedControl->setDirty();
         }
       }
     }
@@ -293,10 +584,13 @@ bool Root::eventMouseMotion(int x, int y)
         _grabbedControl->setPosition(_grabbedControl->getX() + delta.x, _grabbedControl->getY() + delta.y);
         _mouseState.cursor = MouseCursor::Move;
 
-        Event e(Event::Type::Moving, _grabbedControl);
-        e.moving.deltaX = delta.x;
-        e.moving.deltaY = delta.y;
-        _grabbedControl->processEvent(e);
+        if (_grabbedControl->hasEventHandler(Event::Type::Moving))
+        {
+          Event e(Event::Type::Moving, _grabbedControl);
+          e.moving.deltaX = delta.x;
+          e.moving.deltaY = delta.y;
+          _grabbedControl->processEvent(e);
+        }
       }
     }
     break;
@@ -332,11 +626,14 @@ bool Root::eventMouseMotion(int x, int y)
           delta *= -1;
         }
 
-        Event e(Event::Type::Resizing, _grabbedControl);
-        e.resizing.deltaX = delta.x;
-        e.resizing.deltaY = delta.y;
-        e.resizing.edges = _grabbedEdges;
-        _grabbedControl->processEvent(e);
+        if (_grabbedControl->hasEventHandler(Event::Type::Resizing))
+        {
+          Event e(Event::Type::Resizing, _grabbedControl);
+          e.resizing.deltaX = delta.x;
+          e.resizing.deltaY = delta.y;
+          e.resizing.edges = _grabbedEdges;
+          _grabbedControl->processEvent(e);
+        }
       }
     }
     break;
@@ -346,7 +643,7 @@ bool Root::eventMouseMotion(int x, int y)
   }
 
   Control *eventSender = _grabbedControl ? _grabbedControl : _hotControl;
-  if (eventSender)
+  if (eventSender && eventSender->hasEventHandler(Event::Type::MouseMotion))
   {
     Vec2 absPos = eventSender->getAbsolutePosition();
 
@@ -415,7 +712,7 @@ bool Root::eventMouseButtonDown(MouseButton button)
   }
 
   Control *eventSender = _grabbedControl ? _grabbedControl : _hotControl;
-  if (eventSender)
+  if (eventSender && eventSender->hasEventHandler(Event::Type::MouseButton))
   {
     Vec2 absPos = eventSender->getAbsolutePosition();
 
@@ -445,7 +742,7 @@ bool Root::eventMouseButtonUp(MouseButton button)
         bool clicked = (_hotControl == _grabbedControl) && (_grabbedControl->_state & State::Down);
         _grabbedControl->removeState(State::Down);
 
-        if (clicked)
+        if (clicked && _grabbedControl->hasEventHandler(Event::Type::Click))
         {
           Event e(Event::Type::Click, _grabbedControl);
           _grabbedControl->processEvent(e);
@@ -459,7 +756,7 @@ bool Root::eventMouseButtonUp(MouseButton button)
   }
 
   Control *eventSender = _grabbedControl ? _grabbedControl : _hotControl;
-  if (eventSender)
+  if (eventSender && eventSender->hasEventHandler(Event::Type::MouseButton))
   {
     Vec2 absPos = eventSender->getAbsolutePosition();
 
@@ -495,7 +792,7 @@ bool Root::eventKeyDown(Key key, int character)
   }
 
   Control *eventSender = _focusedControl;
-  if (eventSender)
+  if (eventSender && eventSender->hasEventHandler(Event::Type::Key))
   {
     Event e(Event::Type::Key, eventSender);
     e.key.down = true;
@@ -522,7 +819,7 @@ bool Root::eventKeyUp(Key key, int character)
   }
 
   Control *eventSender = _focusedControl;
-  if (eventSender)
+  if (eventSender && eventSender->hasEventHandler(Event::Type::Key))
   {
     Event e(Event::Type::Key, eventSender);
     e.key.down = false;
@@ -535,6 +832,73 @@ bool Root::eventKeyUp(Key key, int character)
   return false;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+void Root::queueMouseMotion(int x, int y)
+{
+  queueInput(InputEvent::Type::MouseMotion, true).position.set(x, y);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Root::queueKeyDown(Key key, int character)
+{
+  InputEvent &e = queueInput(InputEvent::Type::KeyDown);
+  e.key = key;
+  e.character = character;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Root::queueKeyUp(Key key, int character)
+{
+  InputEvent &e = queueInput(InputEvent::Type::KeyUp);
+  e.key = key;
+  e.character = character;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Root::queueResize(int width, int height)
+{
+  queueInput(InputEvent::Type::Resize, true).position.set(width, height);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Root::dispatchInput()
+{
+  // Event handlers may queue more input, that gets dispatched next time
+  _dispatchedInput.swap(_inputQueue);
+
+  for (auto &e : _dispatchedInput)
+  {
+    switch (e.type)
+    {
+      case InputEvent::Type::MouseMotion:
+        eventMouseMotion(e.position.x, e.position.y);
+        break;
+
+      case InputEvent::Type::MouseButtonDown:
+        eventMouseButtonDown(e.button);
+        break;
+
+      case InputEvent::Type::MouseButtonUp:
+        eventMouseButtonUp(e.button);
+        break;
+
+      case InputEvent::Type::KeyDown:
+        eventKeyDown(e.key, e.character);
+        break;
+
+      case InputEvent::Type::KeyUp:
+        eventKeyUp(e.key, e.character);
+        break;
+
+      case InputEvent::Type::Resize:
+        eventResize(e.position.x, e.position.y);
+        break;
+    }
+  }
+
+  _dispatchedInput.clear();
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 bool Root::isTextInputRequired() const
 {
@@ -549,7 +913,6 @@ void Root::setGrabbedControl(Control *control, unsigned edges)
     if (_grabbedControl)
     {
       _grabbedControl->removeState(State::Moving | State::Resizing | State::Down | State::Grabbed);
-      _grabbedControl->setDirty();
     }
 
     _grabbedControl = control;
@@ -566,7 +929,6 @@ void Root::setGrabbedControl(Control *control, unsigned edges)
       _grabbedPosition = _mouseState.position;
 
       _grabbedControl->addState(State::Grabbed);
-      _grabbedControl->setDirty();
 
       Control *c = _grabbedControl;
       while (c)
@@ -588,10 +950,12 @@ void Root::setHotControl(Control *control, unsigned edges)
     if (_hotControl)
     {
       _hotControl->removeState(State::Hot);
-      _hotControl->setDirty();
 
-      Event e(Event::Type::HotChanged, _hotControl);
-      _hotControl->processEvent(e);
+      if (_hotControl->hasEventHandler(Event::Type::HotChanged))
+      {
+        Event e(Event::Type::HotChanged, _hotControl);
+        _hotControl->processEvent(e);
+      }
     }
 
     _hotControl = control;
@@ -599,10 +963,12 @@ void Root::setHotControl(Control *control, unsigned edges)
     if (_hotControl)
     {
       _hotControl->addState(State::Hot);
-      _hotControl->setDirty();
 
-      Event e(Event::Type::HotChanged, _hotControl);
-      _hotControl->processEvent(e);
+      if (_hotControl->hasEventHandler(Event::Type::HotChanged))
+      {
+        Event e(Event::Type::HotChanged, _hotControl);
+        _hotControl->processEvent(e);
+      }
     }
   }
   
@@ -626,10 +992,12 @@ void Root::setFocusedControl(Control *control)
     if (_focusedControl)
     {
       _focusedControl->removeState(State::Focused);
-      _focusedControl->setDirty();
 
-      Event e(Event::Type::FocusChanged, _focusedControl);
-      _focusedControl->processEvent(e);
+      if (_focusedControl->hasEventHandler(Event::Type::FocusChanged))
+      {
+        Event e(Event::Type::FocusChanged, _focusedControl);
+        _focusedControl->processEvent(e);
+      }
 
       Control *c = _focusedControl->_parent;
       while (c)
@@ -637,7 +1005,6 @@ void Root::setFocusedControl(Control *control)
         if (c->_state & State::DeepFocused)
         {
           c->removeState(State::DeepFocused);
-          c->setDirty();
         }
 
         c = c->_parent;
@@ -649,10 +1016,12 @@ void Root::setFocusedControl(Control *control)
     if (_focusedControl)
     {
       _focusedControl->addState(State::Focused);
-      _focusedControl->setDirty();
 
-      Event e(Event::Type::FocusChanged, _focusedControl);
-      _focusedControl->processEvent(e);
+      if (_focusedControl->hasEventHandler(Event::Type::FocusChanged))
+      {
+        Event e(Event::Type::FocusChanged, _focusedControl);
+        _focusedControl->processEvent(e);
+      }
 
       Control *c = _focusedControl->_parent;
       while (c)
@@ -660,7 +1029,6 @@ void Root::setFocusedControl(Control *control)
         if (!(c->_state & State::DeepFocused))
         {
           c->addState(State::DeepFocused);
-          c->setDirty();
         }
 
         c = c->_parent;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Control.h"
+#include "../TextMetrics.h"
 
 namespace nui {
 
@@ -82,7 +83,37 @@ class Root : public Control
 
     Control *getExclusiveControl() const { return _exclusiveControl; }
 
-    void draw();
+    // Repaints damaged areas only, returns false if nothing had to be painted
+    bool draw();
+
+    // Marks absolute screen area to be repainted during next draw()
+    void addDamage(const Rect &rect);
+
+    // Bounding rectangle of everything painted by the last draw()
+    const Rect &getRepaintedArea() const { return _repaintedArea; }
+
+    // Number of controls processed during the last tick() and draw()
+    struct FrameStats
+    {
+      unsigned ticked = 0;
+      unsigned measured = 0;
+      unsigned arranged = 0;
+      unsigned painted = 0;
+      unsigned replayed = 0;
+    };
+
+    const FrameStats &getFrameStats() const { return _frameStats; }
+
+    void setBackgroundColor(const RGBColor &color)
+    {
+      if (_backgroundColor != color)
+      {
+        _backgroundColor = color;
+        invalidate();
+      }
+    }
+
+    const RGBColor &getBackgroundColor() const { return _backgroundColor; }
 
     bool eventMouseMotion(int x, int y);
 
@@ -94,6 +125,25 @@ class Root : public Control
 
     bool eventKeyUp(Key key, int character = 0);
 
+    void eventResize(int width, int height) { setSize(width, height); }
+
+    // Input queued by these is dispatched at the beginning of next tick(), consecutive mouse motion and resize
+    // events are merged into one
+    void queueMouseMotion(int x, int y);
+
+    void queueMouseButtonDown(MouseButton button) { queueInput(InputEvent::Type::MouseButtonDown).button = button; }
+
+    void queueMouseButtonUp(MouseButton button) { queueInput(InputEvent::Type::MouseButtonUp).button = button; }
+
+    void queueKeyDown(Key key, int character = 0);
+
+    void queueKeyUp(Key key, int character = 0);
+
+    void queueResize(int width, int height);
+
+    // Sends all queued input to event*() methods
+    void dispatchInput();
+
     bool isTextInputRequired() const;
 
     const Graphics::IconAtlasInfo &getIconAtlasInfo() const { return _iconAtlasInfo; }
@@ -107,15 +157,71 @@ class Root : public Control
 
     int measureIndex(int fontSize, const char *text, int x, int *charX, bool monospace = false) const;
 
+    // Positions of all glyphs for cursor placement and hit testing
+    void layoutText(int fontSize, const char *text, const char *endText, GlyphRun &run, bool monospace = false) const;
+
+    // Creates glyphs of a code point range in both fonts ahead of use, in the background if nanovg has font threads
+    void prefetchGlyphs(int fontSize, unsigned first, unsigned last);
+
+    // Glyphs rasterized in an earlier run, the file is only used if it was saved with the same fonts and settings
+    bool loadFontCache(const std::string &fileName);
+
+    bool saveFontCache(const std::string &fileName) const;
+
   protected:
     virtual ~Root()
     {
-      delete [] _nvgGlyphPositionBuffer;
+      // Controls still referenced from outside keep the pool alive
+      _controlPool->detach();
     }
 
   private:
+    enum
+    {
+      MaxDamageRects = 8
+    };
+
+    struct InputEvent
+    {
+      enum class Type
+      {
+        MouseMotion,
+        MouseButtonDown,
+        MouseButtonUp,
+        KeyDown,
+        KeyUp,
+        Resize
+      };
+
+      Type type;
+      Vec2 position;
+      MouseButton button;
+      Key key;
+      int character;
+    };
+
+    // Returns the last queued event if it has given type and can be merged, appends a new one otherwise
+    InputEvent &queueInput(InputEvent::Type type, bool merge = false)
+    {
+      if (!merge || _inputQueue.empty() || _inputQueue.back().type != type)
+      {
+        _inputQueue.emplace_back();
+        _inputQueue.back().type = type;
+      }
+
+      return _inputQueue.back();
+    }
+
+    void updatePaintedRects(Control *control, const Vec2 &offset, const Rect &clip);
+
+    // controlAtPoint() reusing the last result while the mouse stays in its stable area
+    ControlPointInfo hitTest(int x, int y);
+
     void traverseControl(Graphics *graphics, Control *control);
 
+    // Replays cached output of control's draw() if possible, draws and records it otherwise
+    void drawControl(Graphics *graphics, Control *control);
+
     void setGrabbedControl(Control *control, unsigned edges);
 
     void setHotControl(Control *control, unsigned edges);
@@ -124,7 +230,13 @@ class Root : public Control
 
     NVGcontext *_nvgContext;
 
-    NVGglyphPosition *_nvgGlyphPositionBuffer;
+    // Controls created while this root is current are allocated here
+    ControlPool *_controlPool;
+
+    mutable TextMetrics _textMetrics;
+
+    // Scratch for measureIndex()
+    mutable GlyphRun _glyphRun;
 
     MouseState _mouseState;
 
@@ -157,6 +269,37 @@ class Root : public Control
     Vec2 _exclusiveOldPosition;
 
     double _cursorBlinker = 0.0;
+
+    float _cursorAlpha = 1.0f;
+
+    RGBColor _backgroundColor = RGBColor(0.2f, 0.3f, 0.4f);
+
+    // Damaged areas waiting to be repainted (absolute coordinates, non-overlapping)
+    std::vector<Rect> _damage;
+
+    // Damaged area currently being repainted
+    Rect _drawArea;
+
+    Rect _repaintedArea;
+
+    // Changes when glyphs rasterized in the background arrive, text painted before is missing them
+    int _fontAsyncGeneration = 0;
+
+    FrameStats _frameStats;
+
+    std::vector<InputEvent> _inputQueue;
+
+    // Queue being dispatched, kept to reuse its storage
+    std::vector<InputEvent> _dispatchedInput;
+
+    struct HitCache
+    {
+      ControlPointInfo result;
+      Rect stableArea;
+      unsigned layoutGeneration = 0;
+    };
+
+    HitCache _hitCache;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,8 @@ ScrollBar::ScrollBar(Control *parent, Docking docking)
   : Control(parent, std::string(), docking, -1)
 {
   addFlags(CanFocus);
+  subscribe(Event::Type::MouseMotion);
+  subscribe(Event::Type::MouseButton);
   setSize(Graphics::Style::DefaultScrollBarSize, Graphics::Style::DefaultScrollBarSize);
   setMinimumSize(Graphics::Style::DefaultScrollBarSize, Graphics::Style::DefaultScrollBarSize);
 }
@@ -123,6 +125,8 @@ void ScrollBar::processEvent(Event &e, bool propagateUp, bool propagateDown)
           _handleOffset = clamp(_handleOffset, 0, _rect.height - _handleSize);
         else
           _handleOffset = clamp(_handleOffset, 0, _rect.width - _handleSize);
+
+        invalidate();
       }
     }
     break;
@@ -157,6 +161,8 @@ void ScrollBar::setHandleOffset(int offset)
       _value = _minimum + (static_cast<double>(_handleOffset) / static_cast<double>(scrollArea - _handleSize)) * range;
     }
 
+    invalidate();
+
     if (_value != oldValue)
     {
       Event e(Event::Type::ValueChanged, this);
@@ -2,16 +2,20 @@
 #include "Root.h"
 #include "ScrollBar.h"
 
-#include <fstream>
-
 namespace nui {
 
 //---------------------------------------------------------------------------------------------------------------------
 TextBox::TextBox(Control *parent, const std::string &text, Docking docking)
-  : Control(parent, text, docking)
+  : Control(parent, std::string(), docking)
 {
-  addFlags(CanFocus | NeedsTextInput);
-  rebuildLineInfos();
+  addFlags(CanFocus | NeedsTextInput | PostDraw);
+  subscribe(Event::Type::ValueChanged);
+  subscribe(Event::Type::SizeChanged);
+  subscribe(Event::Type::Key);
+  subscribe(Event::Type::MouseButton);
+
+  _buffer.setText(text);
+  updateLongestLine();
 
   _hScroll = new ScrollBar(this);
   _hScroll->show(false);
@@ -30,6 +34,42 @@ TextBox::TextBox(Control *parent, const std::string &text, Docking docking)
   updateScrollArea();
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::tick(double time, double delta)
+{
+  Super::tick(time, delta);
+
+  if (!_buffer.isIndexed())
+  {
+    if (_buffer.updateIndex())
+    {
+      updateLongestLine();
+      updateWrapWidth();
+      updateScrollArea();
+      invalidate();
+    }
+    else
+    {
+      scheduleTick();
+    }
+  }
+
+  if (!_pendingText.empty())
+    appendPendingText();
+
+  if (isWrapping() && _wrap.getNumPending())
+    updateWrap();
+
+  if (_search.isRunning())
+  {
+    if (_search.update())
+      invalidate();
+
+    if (_search.isRunning())
+      scheduleTick();
+  }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void TextBox::draw(Graphics *graphics)
 {
@@ -41,46 +81,354 @@ void TextBox::draw(Graphics *graphics)
   if (!_lineHeight)
   {
     _lineHeight = static_cast<int>(graphics->state.style->textSize);
+    updateWrapWidth();
     updateScrollArea();
   }
 
   graphics->pushState();
   graphics->intersectScissor(_padding.left, _padding.top, _rect.width - reducedWidth - _padding.getHorizontal(), _rect.height - reducedHeight - _padding.getVertical());
 
+  _cursorShown = false;
+
   if (_multiline)
   {
-    int visibleLines = 1 + (_rect.height - _padding.getVertical() / _lineHeight);
+    // Lines are drawn closer than the line height used for scrolling, one more may be partially visible
+    int visibleRows = 2 + (_rect.height - _padding.getVertical()) / LineSpacing;
+    updateVisibleRows(_scroll.y / _lineHeight, visibleRows);
 
-    size_t startLine = _scroll.y / _lineHeight;
-    size_t endLine = startLine + visibleLines;
     size_t focusLine = (_state & (State::Focused | State::DeepFocused)) != 0 ? _cursor.y : static_cast<size_t>(-1);
+    size_t cursor = static_cast<size_t>(_cursor.x);
 
     int y = _padding.top + 6 - _scroll.y % _lineHeight;
-    for (size_t i = startLine, S = _lineInfos.size(); i < endLine && i < S; ++i)
-    {
-      const LineInfo &l = _lineInfos[i];
-      const char *text = _text.c_str() + l.offset;
-      const char *end = text + l.length;
-
-      graphics->drawText(_padding.left, y, text, end, false, Graphics::HAlign::Left, Graphics::VAlign::Middle, _monospace);
+    drawMatches(graphics, _padding.left, y, LineSpacing);
+    drawLines(graphics, _padding.left, y, LineSpacing);
 
-      if (i == focusLine)
-        graphics->drawTextCursor(_padding.left + _cursorDrawPos.x, y);
+    for (size_t i = 0; i < _visibleRows.size(); ++i)
+    {
+      const VisibleRow &row = _visibleRows[i];
 
-      y += 13;
+      // Cursor at the end of a wrapped row is drawn at the beginning of the next one
+      if (row.line == focusLine && cursor >= row.offset && (cursor < row.end || row.endQuad == static_cast<size_t>(-1)))
+      {
+        _cursorShown = true;
+        _cursorPaintPos.set(_padding.left + _cursorDrawPos.x - row.x, y + static_cast<int>(i) * LineSpacing);
+      }
     }
   }
   else
   {
-    graphics->drawText(_padding.left, _rect.height / 2, _text.c_str(), false, Graphics::HAlign::Left, Graphics::VAlign::Middle, _monospace);
+    updateVisibleRows(0, 1);
+    drawMatches(graphics, _padding.left, _rect.height / 2, 0);
+    drawLines(graphics, _padding.left, _rect.height / 2, 0);
 
     if (_state & State::Focused)
-      graphics->drawTextCursor(_padding.left + _cursorDrawPos.x, _rect.height / 2);
+    {
+      _cursorShown = true;
+      _cursorPaintPos.set(_padding.left + _cursorDrawPos.x, _rect.height / 2);
+    }
   }
 
   graphics->popState();
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::postDraw(Graphics *graphics)
+{
+  if (!_cursorShown)
+    return;
+
+  int reducedWidth = _vScroll->isVisible() ? _vScroll->getWidth() + 1 : 0;
+  int reducedHeight = _hScroll->isVisible() ? _hScroll->getHeight() + 1 : 0;
+
+  // Origin is at the padding here, the cursor blinks over the cached drawing of the text
+  graphics->pushState();
+  graphics->intersectScissor(0, 0, _rect.width - reducedWidth - _padding.getHorizontal(), _rect.height - reducedHeight - _padding.getVertical());
+  graphics->drawTextCursor(_cursorPaintPos.x - _padding.left, _cursorPaintPos.y - _padding.top);
+  graphics->popState();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::invalidateCursor()
+{
+  if (!_cursorShown)
+    return;
+
+  // Antialiased line reaches a pixel beyond its ends and sides
+  int height = static_cast<int>(getStyle(true)->textSize) + 1;
+  damage(Rect(_cursorPaintPos.x - 1, _cursorPaintPos.y - height / 2 - 2, 4, height + 4));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::updateVisibleRows(size_t firstRow, size_t numRows)
+{
+  _visibleRows.clear();
+
+  if (!isWrapping())
+  {
+    for (size_t line = firstRow; line < minimum(firstRow + numRows, getNumLines()); ++line)
+      _visibleRows.push_back({ line, 0, getLineLength(line), 0, static_cast<size_t>(-1), 0 });
+
+    return;
+  }
+
+  Root::Ptr root = getRoot();
+  Graphics::Style::Ptr style = getStyle(true);
+
+  if (!root || !style || firstRow >= _wrap.getNumRows())
+    return;
+
+  size_t totalRows = _wrap.getNumRows();
+  size_t rowInLine = 0;
+
+  // Rows of the lines above don't change when visible lines are wrapped
+  for (size_t line = _wrap.getLineAt(firstRow, &rowInLine); line < _wrap.getNumLines() && _visibleRows.size() < numRows; ++line)
+  {
+    if (!_wrap.isWrapped(line))
+      wrapLine(root, style->textSize, line);
+
+    const std::vector<TextWrap::Row> &rows = _wrap.getRows(line);
+    size_t length = getLineLength(line);
+
+    for (size_t i = rowInLine; i <= rows.size() && _visibleRows.size() < numRows; ++i)
+    {
+      VisibleRow row;
+      row.line = line;
+      row.offset = i ? rows[i - 1].offset : 0;
+      row.end = i < rows.size() ? rows[i].offset : length;
+      row.quad = i ? rows[i - 1].quad : 0;
+      row.endQuad = i < rows.size() ? rows[i].quad : static_cast<size_t>(-1);
+      row.x = i ? rows[i - 1].x : 0;
+      _visibleRows.push_back(row);
+    }
+
+    rowInLine = 0;
+  }
+
+  if (_wrap.getNumRows() != totalRows)
+    updateScrollArea();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::drawMatches(Graphics *graphics, int x, int y, int rowStep)
+{
+  const Root *root = getRoot();
+
+  if (!_search.getNumMatches() || !root)
+    return;
+
+  size_t patternLength = _search.getPattern().length();
+  size_t line = static_cast<size_t>(-1);
+  int height = graphics->state.style->textSize;
+
+  _matchRects.clear();
+
+  for (size_t r = 0; r < _visibleRows.size(); ++r)
+  {
+    const VisibleRow &row = _visibleRows[r];
+    size_t lineOffset = getLineOffset(row.line);
+    size_t start = lineOffset + row.offset;
+    size_t end = lineOffset + row.end;
+
+    // Matches starting on a previous row may reach into this one
+    _search.forEachMatch(start >= patternLength ? start - patternLength + 1 : 0, end, [&](size_t match)
+    {
+      if (row.line != line)
+      {
+        const char *text = _buffer.getData(lineOffset, getLineLength(row.line), _lineText);
+        root->layoutText(height, text, text + getLineLength(row.line), _matchRun, _monospace);
+        line = row.line;
+      }
+
+      // Only the part on the row is highlighted when the pattern spans rows
+      size_t from = maximum(match, start) - lineOffset;
+      size_t to = minimum(match + patternLength, end) - lineOffset;
+      int left = _matchRun.getX(from);
+      int rowY = y + static_cast<int>(r) * rowStep;
+
+      _matchRects.push_back(Rect(x + left - row.x, rowY - height / 2, _matchRun.getX(to) - left, height));
+    });
+  }
+
+  graphics->drawHighlights(_matchRects.data(), _matchRects.size());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::drawLines(Graphics *graphics, int x, int y, int rowStep)
+{
+  int fontSize = graphics->state.style->textSize;
+
+  if (_lineQuadsFontSize != fontSize || _lineQuadsMonospace != _monospace)
+  {
+    _lineQuads.clear();
+    _lineQuadsFontSize = fontSize;
+    _lineQuadsMonospace = _monospace;
+  }
+
+  // Quads made before the font atlas is reset are lost, that can also happen while new lines are added
+  for (int attempt = 0; attempt < 2; ++attempt)
+  {
+    int atlasGeneration = graphics->getFontAtlasGeneration();
+
+    if (_lineQuadsAtlasGeneration != atlasGeneration)
+    {
+      _lineQuads.clear();
+      _lineQuadsAtlasGeneration = atlasGeneration;
+    }
+
+    ++_drawFrame;
+
+    for (ColorRuns &colorRuns : _colorRuns)
+      colorRuns.runs.clear();
+
+    bool tokenize = _tokenizer && _multiline;
+    size_t line = static_cast<size_t>(-1);
+    int lexerState = 0;
+
+    for (size_t i = 0; i < _visibleRows.size(); ++i)
+    {
+      const VisibleRow &row = _visibleRows[i];
+
+      if (tokenize && row.line != line)
+        lexerState = _lexerStates.getState(_buffer, _tokenizer, row.line);
+
+      line = row.line;
+
+      const LineQuads &entry = getLineQuads(graphics, row.line, lexerState);
+      int first = static_cast<int>(minimum(row.quad, entry.quads.size()));
+      int end = static_cast<int>(minimum(row.endQuad, entry.quads.size()));
+      float runX = static_cast<float>(x - row.x);
+      float runY = static_cast<float>(y + static_cast<int>(i) * rowStep);
+
+      // Row is split into runs of its tokens, text before the first one has the text color
+      for (size_t token = entry.tokens.size(); token-- > 0 && end > first;)
+      {
+        int start = maximum(first, static_cast<int>(entry.tokens[token].offset));
+        NVGglyphRun tokenRun = { runX, runY, entry.quads.data() + start, end - start };
+
+        if (tokenRun.nquads > 0)
+          addGlyphRun(entry.tokens[token].color, tokenRun);
+
+        end = minimum(end, start);
+      }
+
+      NVGglyphRun run = { runX, runY, entry.quads.data() + first, end - first };
+
+      if (run.nquads > 0)
+        addGlyphRun(graphics->state.style->textColor, run);
+    }
+
+    if (graphics->getFontAtlasGeneration() == atlasGeneration)
+      break;
+  }
+
+  // One batch per color
+  for (const ColorRuns &colorRuns : _colorRuns)
+  {
+    if (!colorRuns.runs.empty())
+      graphics->drawGlyphRuns(colorRuns.runs.data(), colorRuns.runs.size(), colorRuns.color);
+  }
+
+  // Lines scrolled away are kept for a while so that scrolling back doesn't rebuild them
+  if (_lineQuads.size() > 2 * _visibleRows.size() + MinCachedLines)
+  {
+    for (auto i = _lineQuads.begin(); i != _lineQuads.end();)
+    {
+      if (i->second.frame != _drawFrame)
+        i = _lineQuads.erase(i);
+      else
+        ++i;
+    }
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const TextBox::LineQuads &TextBox::getLineQuads(Graphics *graphics, size_t line, int lexerState)
+{
+  size_t length = getLineLength(line);
+  const char *text = _buffer.getData(getLineOffset(line), length, _lineText);
+
+  // Keyed by content and lexer state so that lines moved by edits above them are reused
+  LineQuads &entry = _lineQuads[hashBytes(&lexerState, sizeof(lexerState), hashBytes(text, length))];
+
+  if (entry.length != length)
+  {
+    graphics->getGlyphQuads(text, text + length, entry.quads, Graphics::HAlign::Left, Graphics::VAlign::Middle, _monospace);
+    entry.length = length;
+    entry.tokens.clear();
+
+    if (_tokenizer && _multiline)
+    {
+      _tokenizer->tokenize(text, length, lexerState, entry.tokens);
+
+      // nanovg makes a quad for each code point
+      size_t byte = 0, quad = 0;
+
+      for (Tokenizer::Token &token : entry.tokens)
+      {
+        for (; byte < token.offset && byte < length; ++byte)
+          quad += (text[byte] & 0xC0) != 0x80;
+
+        token.offset = minimum(quad, entry.quads.size());
+      }
+    }
+  }
+
+  entry.frame = _drawFrame;
+  return entry;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::addGlyphRun(const RGBColor &color, const NVGglyphRun &run)
+{
+  // Few colors are used, recently used ones are likely to be used again
+  for (ColorRuns &colorRuns : _colorRuns)
+  {
+    if (colorRuns.color == color)
+    {
+      colorRuns.runs.push_back(run);
+      return;
+    }
+  }
+
+  _colorRuns.push_back(ColorRuns());
+  _colorRuns.back().color = color;
+  _colorRuns.back().runs.push_back(run);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::setTokenizer(Tokenizer *tokenizer)
+{
+  if (_tokenizer != tokenizer)
+  {
+    _tokenizer = tokenizer;
+    _lexerStates.clear();
+    _lineQuads.clear();
+    invalidate();
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::textEdited(size_t offset, size_t erased, size_t inserted, size_t erasedBreaks)
+{
+  textChanged();
+  _search.textEdited(_buffer, offset, erased, inserted);
+
+  if (!_tokenizer && !isWrapping())
+    return;
+
+  size_t line = _buffer.getLineAt(offset);
+  size_t added = _buffer.getLineAt(offset + inserted) - line;
+
+  if (_tokenizer)
+    _lexerStates.linesChanged(line, erasedBreaks, added);
+
+  if (isWrapping())
+  {
+    _wrap.linesChanged(_buffer, line, erasedBreaks, added);
+    scheduleTick();
+  }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void TextBox::processEvent(Event &e, bool propagateUp, bool propagateDown)
 {
@@ -92,13 +440,18 @@ void TextBox::processEvent(Event &e, bool propagateUp, bool propagateDown)
         _scroll.y = static_cast<int>(_vScroll->getValue());
       else if (e.sender == _hScroll)
         _scroll.x = static_cast<int>(_hScroll->getValue());
+
+      invalidate();
     }
     break;
 
     case Event::Type::SizeChanged:
     {
       if (e.sender == this)
+      {
+        updateWrapWidth();
         updateScrollArea();
+      }
     }
     break;
 
@@ -115,13 +468,13 @@ void TextBox::processEvent(Event &e, bool propagateUp, bool propagateDown)
 
             if (_cursor.x > 0)
             {
-              --_cursor.x;
+              _cursor.x = static_cast<int>(getPreviousOffset(_cursor.x));
               moved = true;
             }
             else if (_cursor.y > 0)
             {
               --_cursor.y;
-              _cursor.x = _lineInfos[_cursor.y].length;
+              _cursor.x = static_cast<int>(getLineLength(_cursor.y));
               moved = true;
             }
 
@@ -132,9 +485,9 @@ void TextBox::processEvent(Event &e, bool propagateUp, bool propagateDown)
 
           case Key::Right:
           {
-            if (_cursor.x < static_cast<int>(_lineInfos[_cursor.y].length))
-              ++_cursor.x;
-            else if (_cursor.y < static_cast<int>(_lineInfos.size()) - 1)
+            if (_cursor.x < static_cast<int>(getLineLength(_cursor.y)))
+              _cursor.x = static_cast<int>(getNextOffset(_cursor.x));
+            else if (_cursor.y < static_cast<int>(getNumLines()) - 1)
             {
               ++_cursor.y;
               _cursor.x = 0;
@@ -145,20 +498,14 @@ void TextBox::processEvent(Event &e, bool propagateUp, bool propagateDown)
           case Key::Up:
           {
             if (_cursor.y > 0)
-            {
-              --_cursor.y;
-              _cursor.x = minimum(_cursor.x, static_cast<int>(_lineInfos[_cursor.y].length));
-            }
+              moveToLine(_cursor.y - 1);
           }
           break;
 
           case Key::Down:
           {
-            if (_cursor.y < static_cast<int>(_lineInfos.size()) - 1)
-            {
-              ++_cursor.y;
-              _cursor.x = minimum(_cursor.x, static_cast<int>(_lineInfos[_cursor.y].length));
-            }
+            if (_cursor.y < static_cast<int>(getNumLines()) - 1)
+              moveToLine(_cursor.y + 1);
           }
           break;
 
@@ -170,7 +517,7 @@ void TextBox::processEvent(Event &e, bool propagateUp, bool propagateDown)
 
           case Key::End:
           {
-            _cursor.x = static_cast<int>(_lineInfos[_cursor.y].length);
+            _cursor.x = static_cast<int>(getLineLength(_cursor.y));
           }
           break;
 
@@ -199,23 +546,28 @@ void TextBox::processEvent(Event &e, bool propagateUp, bool propagateDown)
 
       updatePositions();
       updateScrollArea();
+      invalidate();
     }
     break;
 
     case Event::Type::MouseButton:
     {
       const Root *root = getRoot();
-      if (root && e.mouseButton.down && (e.mouseButton.button == MouseButton::Left || e.mouseButton.button == MouseButton::Right))
+      if (root && e.sender == this && e.mouseButton.down && (e.mouseButton.button == MouseButton::Left || e.mouseButton.button == MouseButton::Right))
       {
         if (_multiline)
         {
-          _cursor.y = 0;
+          placeCursor(root, e.mouseButton.x - _padding.left, e.mouseButton.y);
         }
         else
         {
-          _cursor.x = root->measureIndex(_lineHeight, _text.c_str(), e.mouseButton.x - _padding.left, &_cursorDrawPos.x, _monospace);
+          int x = e.mouseButton.x - _padding.left;
+          const GlyphRun *run = x > 0 ? getLineRun(root, 0) : nullptr;
+          _cursor.x = run ? static_cast<int>(run->getOffsetAt(x, &_cursorDrawPos.x)) : 0;
           _cursor.y = 0;
         }
+
+        invalidate();
       }
     }
     break;
@@ -230,38 +582,132 @@ void TextBox::processEvent(Event &e, bool propagateUp, bool propagateDown)
 //---------------------------------------------------------------------------------------------------------------------
 void TextBox::setText(const std::string &text)
 {
-  bool rebuild = (_text != text);
-  Super::setText(text);
+  if (_buffer.isEqual(text))
+    return;
+
+  _search.clear();
+  _buffer.setText(text);
+  textReplaced();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::textReplaced()
+{
+  textChanged();
+  _pendingText.clear();
+  _lexerStates.clear();
+  _wrap.clear();
+  setDirty();
+
+  _cursor.y = minimum(_cursor.y, static_cast<int>(getNumLines()) - 1);
+  _cursor.x = minimum(_cursor.x, static_cast<int>(getLineLength(_cursor.y)));
 
-  if (rebuild)
+  updateLongestLine();
+  updateWrapWidth();
+  updateScrollArea();
+
+  if (!_buffer.isIndexed())
+    scheduleTick();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const std::string &TextBox::getText() const
+{
+  if (!_textCacheValid)
   {
-    rebuildLineInfos();
-    updateScrollArea();
+    _textCache = _buffer.getText();
+    _textCacheValid = true;
   }
+
+  return _textCache;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void TextBox::loadTextFromFile(const std::string &fileName)
 {
-  std::ifstream ifs(fileName.c_str(), std::ios_base::binary);
-  
-  if (!ifs.is_open() || ifs.bad())
-  {
-    setText("");
+  // Content is empty if the file can't be opened
+  _search.clear();
+  _buffer.loadFile(fileName);
+  textReplaced();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::appendText(const char *text, size_t length)
+{
+  if (!length)
     return;
+
+  _pendingText.append(text, length);
+  scheduleTick();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::appendPendingText()
+{
+  size_t numLines = getNumLines();
+  size_t numRows = getNumRows();
+  bool follow = _scroll.y >= static_cast<int>(numRows - minimum(numRows, static_cast<size_t>(getVisibleLines()))) * _lineHeight;
+
+  size_t rowInLine = 0;
+  size_t topLine = getTopLine(&rowInLine);
+
+  size_t offset = _buffer.getLength();
+  _buffer.insert(offset, _pendingText);
+  textEdited(offset, 0, _pendingText.length(), 0);
+  _pendingText.clear();
+
+  size_t dropped = dropOldestLines();
+
+  if (_longestLine != static_cast<size_t>(-1))
+    _longestLine = _longestLine >= dropped ? _longestLine - dropped : static_cast<size_t>(-1);
+
+  // Last line may have been extended, only it and the new ones are measured
+  updateLongestLine(numLines - minimum(numLines, dropped + 1));
+
+  if (dropped)
+  {
+    _cursor.y -= minimum(static_cast<int>(dropped), _cursor.y);
+    _cursor.x = minimum(_cursor.x, static_cast<int>(getLineLength(_cursor.y)));
+    updatePositions();
   }
 
-  ifs.seekg(0, std::ios_base::end);
-  size_t size = static_cast<size_t>(ifs.tellg());
-  ifs.seekg(0, std::ios_base::beg);
+  updateScrollArea();
+
+  if (follow)
+    scrollTo(static_cast<int>(getNumRows() - minimum(getNumRows(), static_cast<size_t>(getVisibleLines()))) * _lineHeight);
+  else if (dropped && topLine >= dropped)
+    scrollToLine(topLine - dropped, rowInLine);
+  else if (dropped)
+    scrollTo(0);
+
+  invalidate();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBox::dropOldestLines()
+{
+  size_t length = _buffer.getLength();
 
-  char *buff = new char[size + 1];
-  buff[size] = 0;
-  ifs.read(buff, size);
+  if (!_logCapacity || length <= _logCapacity)
+    return 0;
 
-  setText(std::string(buff));
+  // Content is cut at the beginning of the line containing the first byte to keep or of the line after it
+  size_t excess = length - _logCapacity;
+  size_t dropped = _buffer.getLineAt(excess);
+  size_t cut = _buffer.getLineOffset(dropped);
 
-  delete[] buff;
+  if (cut < excess)
+    cut = _buffer.getLineOffset(++dropped);
+
+  _buffer.erase(0, cut);
+  textEdited(0, cut, 0, dropped);
+
+  // Erased text is still stored, it's released once it takes more space than the content. Worker of a running search
+  // may read the stored text so it has to finish first.
+  if (_buffer.getStorageSize() > 2 * _buffer.getLength() && !_search.isRunning())
+    _buffer.compact();
+
+  return dropped;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -270,57 +716,104 @@ void TextBox::setMultiline(bool set)
   if (_multiline != set)
   {
     _multiline = set;
-    rebuildLineInfos();
+    _lineRunLine = -1;
+    updateLongestLine();
+    _wrap.clear();
+    updateWrapWidth();
     updateScrollArea();
   }
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::setWordWrap(bool set)
+{
+  if (_wordWrap != set)
+  {
+    _wordWrap = set;
+    updateWrapWidth();
+    updateScrollArea();
+    invalidate();
+  }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 size_t TextBox::getCursorOffset() const
 {
-  return _lineInfos[_cursor.y].offset + _cursor.x;
+  return getLineOffset(_cursor.y) + _cursor.x;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void TextBox::insertChar(int ch)
+void TextBox::setCursorOffset(size_t offset)
 {
-  if (ch == '\n')
+  offset = minimum(offset, _buffer.getLength());
+
+  _cursor.y = _multiline ? static_cast<int>(_buffer.getLineAt(offset)) : 0;
+  _cursor.x = static_cast<int>(offset - getLineOffset(_cursor.y));
+
+  // Scrolled so that the cursor's line is visible
+  if (_multiline && _lineHeight && _vScroll->isVisible())
   {
-    if (!_multiline)
-      return;
+    int top = static_cast<int>(getLineRow(_cursor.y)) * _lineHeight;
+    int visibleHeight = _rect.height - _padding.getVertical() - _lineHeight;
 
-    size_t off = getCursorOffset();
-    _text.insert(_text.begin() + off, ch);
+    if (top < _scroll.y || top > _scroll.y + visibleHeight)
+      scrollTo(top - visibleHeight / 2);
+  }
 
-    _lineInfos.insert(_lineInfos.begin() + _cursor.y + 1, LineInfo());
+  updatePositions();
+  invalidate();
+}
 
-    LineInfo &li = _lineInfos[_cursor.y];
-    LineInfo &nextLI = _lineInfos[_cursor.y + 1];
-    
-    nextLI.offset = off;
-    nextLI.length = li.length - static_cast<size_t>(_cursor.x);
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::findAll(const std::string &pattern)
+{
+  _search.clear();
 
-    li.length = _cursor.x;
+  // Search doesn't need the line index, it scans the content as it is
+  if (!pattern.empty())
+    _search.start(_buffer, pattern);
 
-    for (size_t i = _cursor.y + 1, S = _lineInfos.size(); i < S; ++i)
-    {
-      _lineInfos[i].index = i;
-      ++_lineInfos[i].offset;
-    }
+  scheduleTick();
+  invalidate();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextBox::findNext()
+{
+  size_t next;
 
+  if (!_search.findMatch(getCursorOffset() + 1, next))
+  {
+    // Wraps around to the first match once everything has been searched
+    if (_search.isRunning() || !_search.findMatch(0, next))
+      return false;
+  }
+
+  setCursorOffset(next);
+  return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::insertChar(int ch)
+{
+  if (ch == '\n' && !_multiline)
+    return;
+
+  // Characters are code points
+  char bytes[4];
+  size_t length = encodeUtf8(ch, bytes);
+  size_t offset = getCursorOffset();
+  _buffer.insert(offset, bytes, length);
+  textEdited(offset, 0, length, 0);
+
+  if (ch == '\n')
+  {
     _cursor.x = 0;
     ++_cursor.y;
   }
   else
   {
-    size_t off = getCursorOffset();
-    _text.insert(_text.begin() + off, ch);
-
-    ++_lineInfos[_cursor.y].length;
-    for (size_t i = _cursor.y + 1, S = _lineInfos.size(); i < S; ++i)
-      ++_lineInfos[i].offset;
-
-    ++_cursor.x;
+    _cursor.x += static_cast<int>(length);
   }
 }
 
@@ -328,62 +821,31 @@ void TextBox::insertChar(int ch)
 void TextBox::deleteChar()
 {
   size_t off = getCursorOffset();
-  size_t charsToDelete = 1;
+  size_t erased = 0;
+  size_t erasedBreaks = 0;
 
-  if (_cursor.x < static_cast<int>(_lineInfos[_cursor.y].length))
+  if (_cursor.x < static_cast<int>(getLineLength(_cursor.y)))
   {
-    _text.erase(_text.begin() + off);
-    --_lineInfos[_cursor.y].length;
+    // Whole glyph so that no partial UTF-8 sequence is left
+    erased = getNextOffset(_cursor.x) - _cursor.x;
   }
-  else if (_cursor.y < (static_cast<int>(_lineInfos.size()) - 1))
+  else if (_cursor.y < static_cast<int>(getNumLines()) - 1)
   {
-    if (_text[off] == '\r')
-      ++charsToDelete;
-    
-    for (size_t i = 0; i < charsToDelete; ++i)
-      _text.erase(_text.begin() + off);
-
-    _lineInfos[_cursor.y].length += _lineInfos[_cursor.y + 1].length;
-    _lineInfos.erase(_lineInfos.begin() + _cursor.y + 1);
+    // Joins with the next line
+    erased = _buffer.getChar(off) == '\r' ? 2 : 1;
+    erasedBreaks = 1;
   }
 
-  for (size_t i = _cursor.y + 1, S = _lineInfos.size(); i < S; ++i)
-    --_lineInfos[i].offset;
+  _buffer.erase(off, erased);
+  textEdited(off, erased, 0, erasedBreaks);
 
   updatePositions();
   updateScrollArea();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void TextBox::rebuildLineInfos()
+void TextBox::updateLongestLine()
 {
-  _lineInfos.clear();
-
-  if (_multiline)
-  {
-    splitString(_text, "\n", [&](const std::string &str, size_t index, size_t offset, size_t length)
-    {
-      LineInfo li;
-      li.index = index;
-      li.offset = offset;
-      li.length = length;
-
-      _lineInfos.push_back(li);
-    });
-  }
-  else
-  {
-    LineInfo li;
-    li.offset = 0;
-    li.length = _text.length();
-    li.index = 0;
-
-    _lineInfos.push_back(li);
-  }
-
-  if (_lineInfos.empty())
-    _lineInfos.push_back(LineInfo());
-
   _longestLine = static_cast<size_t>(-1);
   _longestLineWidth = -1;
 
@@ -392,31 +854,190 @@ void TextBox::rebuildLineInfos()
 
   if (style && root)
   {
-    for (auto &li : _lineInfos)
+    size_t numLines = getNumLines();
+
+    // With monospace font the line with most bytes is the widest one, large texts use it as an estimate too so that
+    // only one line has to be measured instead of the whole document
+    if (_monospace || numLines > ExactLongestLineLimit)
     {
-      int lineWidth = root->measureText(style->textSize, _text.c_str() + li.offset, _text.c_str() + li.offset + li.length, _monospace).x;
+      size_t line = _multiline ? _buffer.getLongestLine() : 0;
+      size_t length = getLineLength(line);
+      const char *text = _buffer.getData(getLineOffset(line), length, _lineText);
+
+      _longestLine = line;
+      _longestLineWidth = root->measureText(style->textSize, text, text + length, _monospace).x;
+      return;
+    }
+
+    for (size_t i = 0; i < numLines; ++i)
+    {
+      size_t length = getLineLength(i);
+      const char *text = _buffer.getData(getLineOffset(i), length, _lineText);
+
+      int lineWidth = root->measureText(style->textSize, text, text + length, _monospace).x;
       if (lineWidth > _longestLineWidth)
       {
-        _longestLine = li.index;
+        _longestLine = i;
         _longestLineWidth = lineWidth;
       }
     }
   }
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::updateLongestLine(size_t first)
+{
+  Root::Ptr root = getRoot();
+  Graphics::Style::Ptr style = getStyle(true);
+
+  if (!style || !root)
+    return;
+
+  size_t numLines = getNumLines();
+
+  for (size_t i = first; i < numLines; ++i)
+  {
+    size_t length = getLineLength(i);
+    const char *text = _buffer.getData(getLineOffset(i), length, _lineText);
+
+    int lineWidth = root->measureText(style->textSize, text, text + length, _monospace).x;
+    if (lineWidth > _longestLineWidth)
+    {
+      _longestLine = i;
+      _longestLineWidth = lineWidth;
+    }
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int TextBox::getVisibleLines() const
+{
+  int height = _rect.height - _padding.getVertical() - (_hScroll->isVisible() ? _hScroll->getHeight() + 1 : 0);
+  return maximum(1, height / LineSpacing);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::scrollTo(int y)
+{
+  // Scroll bar doesn't send ValueChanged for values set by code
+  _vScroll->setValue(y);
+  _scroll.y = static_cast<int>(_vScroll->getValue());
+  invalidate();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBox::getTopLine(size_t *rowInLine) const
+{
+  size_t row = _lineHeight ? _scroll.y / _lineHeight : 0;
+
+  if (isWrapping())
+    return _wrap.getLineAt(row, rowInLine);
+
+  *rowInLine = 0;
+  return minimum(row, getNumLines() - 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::scrollToLine(size_t line, size_t rowInLine)
+{
+  if (!_lineHeight)
+    return;
+
+  size_t numRows = isWrapping() ? _wrap.getNumRows(line) : 1;
+  size_t row = getLineRow(line) + minimum(rowInLine, numRows - 1);
+
+  scrollTo(static_cast<int>(row) * _lineHeight + _scroll.y % _lineHeight);
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void TextBox::updatePositions()
 {
   const Root *root = getRoot();
+  const GlyphRun *run = root ? getLineRun(root, _cursor.y) : nullptr;
+
+  if (run)
+    _cursorDrawPos.x = run->getX(_cursor.x);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const GlyphRun *TextBox::getLineRun(const Root *root, int line)
+{
+  const Graphics::Style *style = _style ? _style.get() : root->getStyle();
+
+  if (!style)
+    return nullptr;
 
-  if (root)
+  if (_lineRunLine != line || _lineRunFontSize != style->textSize)
   {
-    const Graphics::Style *style = _style ? _style : root->getStyle();
-    const char *text = _text.c_str() + _lineInfos[_cursor.y].offset;
-    Vec2 size = root->measureText(style->textSize, text, text + _cursor.x + 1, _monospace);
+    size_t length = getLineLength(line);
+    const char *text = _buffer.getData(getLineOffset(line), length, _lineText);
 
-    _cursorDrawPos.x = size.x;
+    root->layoutText(style->textSize, text, text + length, _lineRun, _monospace);
+    _lineRunLine = line;
+    _lineRunFontSize = style->textSize;
   }
+
+  return &_lineRun;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBox::getNextOffset(size_t offset)
+{
+  const Root *root = getRoot();
+  const GlyphRun *run = root ? getLineRun(root, _cursor.y) : nullptr;
+
+  return run ? run->getNextOffset(offset) : offset + 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextBox::getPreviousOffset(size_t offset)
+{
+  const Root *root = getRoot();
+  const GlyphRun *run = root ? getLineRun(root, _cursor.y) : nullptr;
+
+  return run ? run->getPreviousOffset(offset) : offset - 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::moveToLine(int line)
+{
+  const Root *root = getRoot();
+  const GlyphRun *run = root ? getLineRun(root, line) : nullptr;
+
+  _cursor.y = line;
+  _cursor.x = run ? static_cast<int>(run->getOffsetAt(_cursorDrawPos.x, nullptr)) : minimum(_cursor.x, static_cast<int>(getLineLength(line)));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::placeCursor(const Root *root, int x, int y)
+{
+  if (!_lineHeight)
+    return;
+
+  // Rows are centered LineSpacing apart like in draw()
+  int top = _padding.top + 6 - _scroll.y % _lineHeight - LineSpacing / 2;
+  size_t index = y > top ? (y - top) / LineSpacing : 0;
+
+  updateVisibleRows(_scroll.y / _lineHeight, index + 1);
+
+  if (_visibleRows.empty())
+    return;
+
+  const VisibleRow &row = _visibleRows[minimum(index, _visibleRows.size() - 1)];
+  const GlyphRun *run = getLineRun(root, static_cast<int>(row.line));
+
+  if (!run)
+    return;
+
+  size_t offset = maximum(run->getOffsetAt(x + row.x, nullptr), row.offset);
+
+  // Cursor at the end of a wrapped row would be drawn on the next one
+  if (row.endQuad != static_cast<size_t>(-1) && offset >= row.end)
+    offset = run->getPreviousOffset(row.end);
+
+  _cursor.y = static_cast<int>(row.line);
+  _cursor.x = static_cast<int>(offset);
+  updatePositions();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -426,7 +1047,7 @@ void TextBox::updateScrollArea()
     return;
   
   int availableWidth = _rect.width;
-  int totalHeight = _multiline ? _lineInfos.size() * _lineHeight : _lineHeight;
+  int totalHeight = _multiline ? static_cast<int>(getNumRows()) * _lineHeight : _lineHeight;
 
   if (totalHeight > _rect.height - _padding.getVertical())
   {
@@ -440,7 +1061,8 @@ void TextBox::updateScrollArea()
     _vScroll->show(false);
   }
 
-  if (_longestLineWidth > availableWidth - _padding.getHorizontal())
+  // Wrapped lines fit the width
+  if ((!_wordWrap || !_multiline) && _longestLineWidth > availableWidth - _padding.getHorizontal())
   {
     _hScroll->show(true);
     _hScroll->setMaximum(_longestLineWidth);
@@ -455,4 +1077,113 @@ void TextBox::updateScrollArea()
   }
 }
 
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::updateWrapWidth()
+{
+  size_t rowInLine = 0;
+  size_t topLine = getTopLine(&rowInLine);
+  bool wrapping = isWrapping();
+
+  Root::Ptr root = getRoot();
+  Graphics::Style::Ptr style = getStyle(true);
+
+  // Lines are wrapped once the index is complete
+  if (!_wordWrap || !_multiline || !_buffer.isIndexed() || !root || !style)
+  {
+    _wrap.clear();
+  }
+  else
+  {
+    // Space for the vertical scroll bar is always left so that showing it doesn't change the width
+    int width = maximum(1, _rect.width - _padding.getHorizontal() - _vScroll->getWidth() - 1);
+
+    // Average advance for estimating rows of lines not wrapped yet, the measured x of the last letter is 25 advances
+    static const char sample[] = "abcdefghijklmnopqrstuvwxyz";
+    int charWidth = root->measureText(style->textSize, sample, sample + 26, _monospace).x / 25;
+
+    if (_wrap.getNumLines() != _buffer.getNumLines())
+      _wrap.reset(_buffer, width, charWidth);
+    else
+      _wrap.setWidth(width, charWidth);
+
+    scheduleTick();
+  }
+
+  if (wrapping || isWrapping())
+  {
+    updateScrollArea();
+    scrollToLine(topLine, 0);
+    invalidate();
+  }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::updateWrap()
+{
+  Root::Ptr root = getRoot();
+  Graphics::Style::Ptr style = getStyle(true);
+
+  if (!root || !style)
+    return;
+
+  size_t numRows = _wrap.getNumRows();
+  size_t rowInLine = 0;
+  size_t topLine = getTopLine(&rowInLine);
+
+  for (int i = 0; i < WrapLinesPerTick; ++i)
+  {
+    size_t line = _wrap.findPending();
+
+    if (line == _wrap.getNumLines())
+      break;
+
+    wrapLine(root, style->textSize, line);
+  }
+
+  if (_wrap.getNumRows() != numRows)
+  {
+    updateScrollArea();
+    scrollToLine(topLine, rowInLine);
+  }
+
+  if (_wrap.getNumPending())
+    scheduleTick();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextBox::wrapLine(const Root *root, int fontSize, size_t line)
+{
+  size_t length = getLineLength(line);
+  const char *text = _buffer.getData(getLineOffset(line), length, _lineText);
+
+  root->layoutText(fontSize, text, text + length, _wrapRun, _monospace);
+  _wrapRows.clear();
+
+  int width = _wrap.getWidth();
+  size_t numGlyphs = _wrapRun.getNumGlyphs();
+  size_t rowGlyph = 0;
+  size_t breakGlyph = 0;
+
+  // Rows break after the last space that fits, words longer than the width are broken where they reach it. Spaces
+  // may hang over the edge.
+  for (size_t i = 0; i < numGlyphs; ++i)
+  {
+    char c = text[_wrapRun.getGlyphOffset(i)];
+    bool space = c == ' ' || c == '\t';
+
+    if (!space && i > rowGlyph && _wrapRun.getGlyphX(i + 1) - _wrapRun.getGlyphX(rowGlyph) > width)
+    {
+      size_t glyph = breakGlyph > rowGlyph ? breakGlyph : i;
+      _wrapRows.push_back({ _wrapRun.getGlyphOffset(glyph), glyph, _wrapRun.getGlyphX(glyph) });
+      rowGlyph = glyph;
+    }
+
+    if (space)
+      breakGlyph = i + 1;
+  }
+
+  _wrap.setRows(line, _wrapRows);
+}
+
 }
@@ -1,6 +1,13 @@
 #pragma once
 
 #include "../Control.h"
+#include "../TextBuffer.h"
+#include "../TextMetrics.h"
+#include "../TextSearch.h"
+#include "../TextWrap.h"
+#include "../Tokenizer.h"
+
+#include <unordered_map>
 
 namespace nui {
   
@@ -13,30 +20,217 @@ class TextBox : public Control
 
     explicit TextBox(Control *parent = nullptr, const std::string &text = std::string(), Docking docking = Docking::None);
 
+    void tick(double time, double delta) override;
+
     void draw(Graphics *graphics) override;
 
+    // Text cursor is drawn over the text so that blinking doesn't drop the cached drawing
+    void postDraw(Graphics *graphics) override;
+
+    void invalidateCursor() override;
+
     void processEvent(Event &e, bool propagateUp /* = true */, bool propagateDown /* = false */) override;
 
     void setText(const std::string &text) override;
 
+    // Whole content is assembled from the buffer on demand, getBuffer() gives direct access to it
+    const std::string &getText() const override;
+
+    const TextBuffer &getBuffer() const { return _buffer; }
+
+    // The file stays memory mapped while it's displayed, lines are indexed in the background and show up as they
+    // are found
     void loadTextFromFile(const std::string &fileName);
 
-    void setMonospace(bool set = true) { _monospace = set; }
+    // Adds text at the end, appends made during a frame are added to the content together on the next tick. A view
+    // scrolled to the bottom follows the new lines.
+    void appendText(const char *text, size_t length);
+
+    void appendText(const std::string &text) { appendText(text.data(), text.length()); }
+
+    // Oldest lines are dropped when appended text makes the content longer than capacity bytes, 0 for no limit
+    void setLogCapacity(size_t capacity) { _logCapacity = capacity; }
+
+    size_t getLogCapacity() const { return _logCapacity; }
+
+    void setMonospace(bool set = true)
+    {
+      if (_monospace != set)
+      {
+        _monospace = set;
+        _lineRunLine = -1;
+        _wrap.clear();
+        updateWrapWidth();
+        invalidate();
+      }
+    }
 
     bool getMonospace() const { return _monospace; }
+
+    // Colors lines of a multiline text box, lines are lexed again only when they or the lines above them change
+    void setTokenizer(Tokenizer *tokenizer);
+
+    Tokenizer *getTokenizer() const { return _tokenizer; }
     
     void setMultiline(bool set = true);
 
     bool getMultiline() const { return _multiline; }
 
+    // Lines of a multiline text box longer than its width are broken at spaces. Visible lines are wrapped when drawn,
+    // the rest of them a part in each tick so that the scroll range settles without blocking on large texts.
+    void setWordWrap(bool set = true);
+
+    bool getWordWrap() const { return _wordWrap; }
+
     size_t getCursorOffset() const;
 
+    void setCursorOffset(size_t offset);
+
+    // Finds all occurrences of the pattern on a background thread, matches are highlighted as they are found and kept
+    // up to date while the text is edited. Empty pattern ends the search.
+    void findAll(const std::string &pattern);
+
+    // Moves the cursor to the next match found so far, wraps around when the search is complete
+    bool findNext();
+
+    const TextSearch &getSearch() const { return _search; }
+
   private:
     void insertChar(int ch);
 
+    // Moves text added by appendText() to the buffer
+    void appendPendingText();
+
+    // Drops whole lines from the beginning so that the content fits the log capacity, returns number of dropped lines
+    size_t dropOldestLines();
+
     void deleteChar();
 
-    void rebuildLineInfos();
+    // Single line text box has one line even if the text contains line breaks
+    size_t getNumLines() const { return _multiline ? _buffer.getNumLines() : 1; }
+
+    size_t getLineOffset(size_t line) const { return _multiline ? _buffer.getLineOffset(line) : 0; }
+
+    size_t getLineLength(size_t line) const { return _multiline ? _buffer.getLineLength(line) : _buffer.getLength(); }
+
+    // Wrap rows are kept only while word wrap is on and the line index is complete
+    bool isWrapping() const { return _wrap.getNumLines() != 0; }
+
+    // Visual rows, each line is one row without word wrap
+    size_t getNumRows() const { return isWrapping() ? _wrap.getNumRows() : getNumLines(); }
+
+    size_t getLineRow(size_t line) const { return isWrapping() ? _wrap.getFirstRow(line) : line; }
+
+    void textChanged()
+    {
+      _textCacheValid = false;
+      _lineRunLine = -1;
+    }
+
+    // Part of the text containing erasedBreaks line breaks has been replaced by inserted bytes
+    void textEdited(size_t offset, size_t erased, size_t inserted, size_t erasedBreaks);
+
+    // Whole content has been replaced
+    void textReplaced();
+
+    enum
+    {
+      // Texts with more lines only measure the line with most bytes
+      ExactLongestLineLimit = 4096,
+
+      LineSpacing = 13,
+
+      // Glyph quads of lines which are not visible are kept up to this count above twice the visible lines
+      MinCachedLines = 64,
+
+      // Lines wrapped in the background per tick
+      WrapLinesPerTick = 1000
+    };
+
+    struct LineQuads
+    {
+      size_t length = static_cast<size_t>(-1);
+
+      // Last frame the line was drawn in
+      unsigned frame = 0;
+
+      std::vector<NVGglyphQuad> quads;
+
+      // Offsets of the tokens are indices of their first quads
+      std::vector<Tokenizer::Token> tokens;
+    };
+
+    struct ColorRuns
+    {
+      RGBColor color;
+      std::vector<NVGglyphRun> runs;
+    };
+
+    // Part of a line drawn on one row, offsets are relative to the line
+    struct VisibleRow
+    {
+      size_t line;
+      size_t offset;
+      size_t end;
+
+      // Glyph quads of the row, endQuad is -1 for the last row of the line
+      size_t quad;
+      size_t endQuad;
+
+      // x of the row's first glyph in the line
+      int x;
+    };
+
+    // Rows from firstRow are listed in _visibleRows, visible lines which are not wrapped yet are wrapped first
+    void updateVisibleRows(size_t firstRow, size_t numRows);
+
+    void drawMatches(Graphics *graphics, int x, int y, int rowStep);
+
+    // Draws visible rows in one batch, line quads are rebuilt only for lines with new content
+    void drawLines(Graphics *graphics, int x, int y, int rowStep);
+
+    // Lexer state is used only with a tokenizer
+    const LineQuads &getLineQuads(Graphics *graphics, size_t line, int lexerState);
+
+    void addGlyphRun(const RGBColor &color, const NVGglyphRun &run);
+
+    void updateLongestLine();
+
+    // Measures lines from first to the last one, the widest line so far is kept even if it was removed
+    void updateLongestLine(size_t first);
+
+    // Lines fully visible in the text area
+    int getVisibleLines() const;
+
+    void scrollTo(int y);
+
+    // Line at the top of the view, rowInLine receives the row of the line shown there
+    size_t getTopLine(size_t *rowInLine) const;
+
+    // Keeps the view at the same text while rows above it change
+    void scrollToLine(size_t line, size_t rowInLine);
+
+    // Starts wrapping for the current width and font or stops it when word wrap is off
+    void updateWrapWidth();
+
+    // Wraps lines which still have estimated rows in the background
+    void updateWrap();
+
+    void wrapLine(const Root *root, int fontSize, size_t line);
+
+    // Glyph positions of given line, kept until the line or the text changes
+    const GlyphRun *getLineRun(const Root *root, int line);
+
+    // Offsets of neighbouring glyphs on the cursor's line, bytes are stepped over if the line can't be laid out
+    size_t getNextOffset(size_t offset);
+
+    size_t getPreviousOffset(size_t offset);
+
+    // Moves the cursor to another line keeping its x
+    void moveToLine(int line);
+
+    // Places the cursor at the glyph under a point of the text area
+    void placeCursor(const Root *root, int x, int y);
 
     void updatePositions();
 
@@ -46,12 +240,19 @@ class TextBox : public Control
 
     bool _monospace = false;
 
+    bool _wordWrap = false;
+
     bool _hasSelection = false;
 
     Vec2 _cursor;
 
     Vec2 _cursorDrawPos;
 
+    // Where the last draw placed the text cursor, local coordinates
+    Vec2 _cursorPaintPos;
+
+    bool _cursorShown = false;
+
     Vec2 _selectionStart;
 
     Vec2 _selectionEnd;
@@ -60,14 +261,58 @@ class TextBox : public Control
 
     Vec2 _selectionDrawEnd;
 
-    struct LineInfo
-    {
-      size_t index;
-      size_t offset;
-      size_t length;
-    };
+    TextBuffer _buffer;
+
+    mutable std::string _textCache;
+
+    mutable bool _textCacheValid = false;
+
+    // Scratch for lines which are not stored contiguously in the buffer
+    std::string _lineText;
+
+    GlyphRun _lineRun;
+
+    int _lineRunLine = -1;
+
+    int _lineRunFontSize = 0;
+
+    // Glyph quads keyed by hash of line's content
+    std::unordered_map<uint64_t, LineQuads> _lineQuads;
+
+    int _lineQuadsFontSize = 0;
+
+    bool _lineQuadsMonospace = false;
+
+    int _lineQuadsAtlasGeneration = -1;
+
+    unsigned _drawFrame = 0;
+
+    // Glyph runs of drawn lines grouped by color, the first group has the text color
+    std::vector<ColorRuns> _colorRuns;
+
+    Tokenizer::Ptr _tokenizer;
+
+    LexerStates _lexerStates;
+
+    TextSearch _search;
+
+    // Scratch for positions of highlighted matches
+    GlyphRun _matchRun;
+
+    std::vector<Rect> _matchRects;
+
+    TextWrap _wrap;
+
+    std::vector<VisibleRow> _visibleRows;
+
+    // Scratch for wrapping lines
+    GlyphRun _wrapRun;
+
+    std::vector<TextWrap::Row> _wrapRows;
+
+    std::string _pendingText;
 
-    std::vector<LineInfo> _lineInfos;
+    size_t _logCapacity = 0;
 
     Vec2 _scroll;
 
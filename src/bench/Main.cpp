@@ -0,0 +1,703 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "NUI/NUI.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+// Headless, commands generated by nanovg are recorded and dropped unless a framebuffer is set
+#define NANOVG_SW_IMPLEMENTATION
+#include <nanovg/nanovg.h>
+#include <nanovg/nanovg_sw.h>
+
+// Benchmarks synthetic control trees and writes results as JSON. Has to be run from the data directory so that
+// fonts are found.
+//
+//   nui_bench [output.json] [workload...]
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Heap usage of C++ allocations, text indexing threads allocate too
+struct AllocStats
+{
+  std::atomic<size_t> count{0};
+  std::atomic<size_t> bytes{0};
+  std::atomic<size_t> live{0};
+  std::atomic<size_t> peak{0};
+};
+
+AllocStats g_AllocStats;
+
+// Keeps size of each block in front of it so that operator delete can update live bytes
+static const size_t g_AllocHeader = 16;
+
+//---------------------------------------------------------------------------------------------------------------------
+void *operator new(size_t size)
+{
+  char *block = static_cast<char *>(malloc(size + g_AllocHeader));
+
+  if (!block)
+    throw std::bad_alloc();
+
+  *reinterpret_cast<size_t *>(block) = size;
+
+  g_AllocStats.count.fetch_add(1, std::memory_order_relaxed);
+  g_AllocStats.bytes.fetch_add(size, std::memory_order_relaxed);
+  size_t live = g_AllocStats.live.fetch_add(size, std::memory_order_relaxed) + size;
+  size_t peak = g_AllocStats.peak.load(std::memory_order_relaxed);
+
+  while (live > peak && !g_AllocStats.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+  {
+  }
+
+  return block + g_AllocHeader;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void operator delete(void *ptr) noexcept
+{
+  if (!ptr)
+    return;
+
+  char *block = static_cast<char *>(ptr) - g_AllocHeader;
+  g_AllocStats.live.fetch_sub(*reinterpret_cast<size_t *>(block), std::memory_order_relaxed);
+  free(block);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void operator delete[](void *ptr) noexcept
+{
+  operator delete(ptr);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Result
+{
+  std::string name;
+  size_t iterations = 0;
+  double nsPerOp = 0.0;
+  double allocationsPerOp = 0.0;
+  double bytesPerOp = 0.0;
+};
+
+struct Workload
+{
+  const char *name;
+  std::function<void(nui::Root *root)> build;
+
+  // Control resized to force layout of the measured tree
+  std::function<nui::Control *(nui::Root *root)> getLayoutTarget;
+
+  // Optional, runs before build and isn't measured
+  std::function<void()> prepare;
+
+  // Optional, workload specific operations measured after the common ones
+  std::function<void(nui::Root *root, std::vector<Result> &results)> measureExtra;
+
+  // Optional, nanovg create flags of a context made for the workload instead of the shared one
+  int nvgFlags;
+};
+
+static const int g_ScreenWidth = 1920;
+static const int g_ScreenHeight = 1080;
+
+// Operations are repeated until they take this long
+static const double g_MinTime = 0.2;
+static const size_t g_MaxIterations = 1 << 20;
+
+// Log file generated for the text loading workload, removed on exit
+static const char *g_LogFileName = "nui_bench_log500M.txt";
+static const size_t g_LogFileSize = 500 << 20;
+
+// Text box of the streaming workload, filled up to the capacity and then appended to every frame
+static const size_t g_StreamCapacity = 16 << 20;
+static const size_t g_StreamLinesPerFrame = 100000 / 60;
+
+nui::TextBox *g_StreamTextBox = nullptr;
+NVGcontext *g_NVGcontext = nullptr;
+std::vector<unsigned char> g_Pixels;
+double g_Time = 0.0;
+bool g_LogFileCreated = false;
+
+//---------------------------------------------------------------------------------------------------------------------
+double getSeconds()
+{
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration<double>(now).count();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+Result measure(const char *name, const std::function<void(size_t iteration)> &op)
+{
+  Result result;
+  result.name = name;
+
+  // Warm up
+  op(0);
+
+  size_t countBefore = g_AllocStats.count;
+  size_t bytesBefore = g_AllocStats.bytes;
+  double time = 0.0;
+  size_t iterations = 0;
+
+  // Batches grow until the total time is long enough, time isn't read after each (possibly very short) operation
+  for (size_t batch = 1; time < g_MinTime && iterations < g_MaxIterations; batch *= 2)
+  {
+    batch = nui::minimum(batch, g_MaxIterations - iterations);
+    double start = getSeconds();
+
+    for (size_t i = 0; i < batch; ++i)
+      op(iterations + i + 1);
+
+    time += getSeconds() - start;
+    iterations += batch;
+  }
+
+  result.iterations = iterations;
+  result.nsPerOp = time * 1e9 / iterations;
+  result.allocationsPerOp = static_cast<double>(g_AllocStats.count - countBefore) / iterations;
+  result.bytesPerOp = static_cast<double>(g_AllocStats.bytes - bytesBefore) / iterations;
+  return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void tick(nui::Root *root)
+{
+  root->tick(g_Time, 1.0 / 60.0);
+  g_Time += 1.0 / 60.0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void draw(nui::Root *root, bool rasterize)
+{
+  nvgswSetFramebuffer(g_NVGcontext, rasterize ? g_Pixels.data() : nullptr, g_ScreenWidth, g_ScreenHeight, g_ScreenWidth * 4);
+  nvgBeginFrame(g_NVGcontext, g_ScreenWidth, g_ScreenHeight, 1.0f);
+  root->draw();
+  nvgEndFrame(g_NVGcontext);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void invalidateAll(nui::Control *control)
+{
+  control->invalidate();
+
+  for (nui::Control *child : *control)
+    invalidateAll(child);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t countControls(const nui::Control *control)
+{
+  size_t count = 1;
+
+  for (const nui::Control *child : *control)
+    count += countControls(child);
+
+  return count;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void createLogFile()
+{
+  if (g_LogFileCreated)
+    return;
+
+  FILE *file = fopen(g_LogFileName, "wb");
+
+  if (!file)
+  {
+    fprintf(stderr, "Can't create %s\n", g_LogFileName);
+    return;
+  }
+
+  // Lines of varying length so that the longest one isn't the first one
+  std::string chunk;
+  size_t written = 0;
+
+  for (size_t i = 0; written < g_LogFileSize; ++i)
+  {
+    char line[256];
+    int length = snprintf(line, sizeof(line), "%08zu [worker %zu] request %zu finished in %zu ms%s\n",
+      i, i % 13, i * 7919 % 1000003, i % 997, i % 101 ? "" : " after retrying the connection to the upstream server");
+    chunk.append(line, length);
+
+    if (chunk.size() >= (1 << 20))
+    {
+      fwrite(chunk.data(), 1, chunk.size(), file);
+      written += chunk.size();
+      chunk.clear();
+    }
+  }
+
+  fclose(file);
+  g_LogFileCreated = true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+std::vector<Workload> createWorkloads()
+{
+  std::vector<Workload> workloads;
+
+  workloads.push_back({ "buttons10k",
+    [](nui::Root *root)
+    {
+      nui::Window::Ptr window = new nui::Window(root, "Buttons");
+      window->setRect(0, 0, g_ScreenWidth, g_ScreenHeight);
+
+      for (int i = 0; i < 10000; ++i)
+      {
+        nui::Button::Ptr button = new nui::Button(window, "Button " + std::to_string(i));
+        button->setRect((i % 100) * 19, 20 + (i / 100) * 10, 18, 9);
+      }
+    },
+    [](nui::Root *root) { return root->getChild(0); } });
+
+  workloads.push_back({ "docking50",
+    [](nui::Root *root)
+    {
+      nui::Window::Ptr window = new nui::Window(root, "Docking");
+      window->setRect(0, 0, g_ScreenWidth, g_ScreenHeight);
+
+      nui::Control *parent = window;
+      static const nui::Docking sides[] = { nui::Docking::Left, nui::Docking::Top, nui::Docking::Right, nui::Docking::Bottom };
+
+      for (int depth = 0; depth < 50; ++depth)
+      {
+        new nui::Button(parent, "Side", sides[depth % 4]);
+        new nui::Button(parent, "Side", sides[(depth + 2) % 4]);
+        parent = new nui::Box(parent, nui::Docking::Client);
+      }
+
+      new nui::Button(parent, "Center", nui::Docking::Client);
+    },
+    [](nui::Root *root) { return root->getChild(0); } });
+
+  workloads.push_back({ "windows300",
+    [](nui::Root *root)
+    {
+      for (int i = 0; i < 300; ++i)
+      {
+        nui::Window::Ptr window = new nui::Window(root, "Window " + std::to_string(i));
+        window->setRect((i * 37) % (g_ScreenWidth - 300), (i * 53) % (g_ScreenHeight - 200), 300, 200);
+
+        nui::Box::Ptr box = new nui::Box(window, nui::Docking::Bottom);
+        new nui::Button(box, "Cancel", nui::Docking::Right, NUI_ICON_CANCEL);
+        new nui::Button(box, "OK", nui::Docking::Right, NUI_ICON_OK);
+        box->autoSize();
+
+        new nui::CheckBox(window, "Option", nui::Docking::Top);
+        new nui::TextBox(window, "Hello, world!", nui::Docking::Top);
+      }
+    },
+    [](nui::Root *root) { return root->getChild(root->getNumChildren() - 1); } });
+
+  workloads.push_back({ "textbox1M",
+    [](nui::Root *root)
+    {
+      nui::Window::Ptr window = new nui::Window(root, "Text");
+      window->setRect(0, 0, g_ScreenWidth, g_ScreenHeight);
+
+      std::string text;
+      text.reserve(40 * 1000000);
+
+      for (int i = 0; i < 1000000; ++i)
+        text += "Line " + std::to_string(i) + " of the benchmark text box\n";
+
+      nui::TextBox::Ptr textBox = new nui::TextBox(window, "", nui::Docking::Client);
+      textBox->setMonospace();
+      textBox->setMultiline();
+      textBox->setText(text);
+    },
+    [](nui::Root *root) { return root->getChild(0); } });
+
+  workloads.push_back({ "log500M",
+    [](nui::Root *root)
+    {
+      nui::Window::Ptr window = new nui::Window(root, "Log");
+      window->setRect(0, 0, g_ScreenWidth, g_ScreenHeight);
+
+      nui::TextBox::Ptr textBox = new nui::TextBox(window, "", nui::Docking::Client);
+      textBox->setMonospace();
+      textBox->setMultiline();
+      textBox->loadTextFromFile(g_LogFileName);
+    },
+    [](nui::Root *root) { return root->getChild(0); },
+    createLogFile,
+    [](nui::Root *, std::vector<Result> &results)
+    {
+      // Whole line index of the file rebuilt from scratch
+      results.push_back(measure("indexLines", [](size_t)
+      {
+        nui::TextBuffer buffer;
+        buffer.loadFile(g_LogFileName);
+        buffer.waitForIndex();
+      }));
+    } });
+
+  workloads.push_back({ "source200k",
+    [](nui::Root *root)
+    {
+      nui::Window::Ptr window = new nui::Window(root, "Source");
+      window->setRect(0, 0, g_ScreenWidth, g_ScreenHeight);
+
+      std::string text;
+
+      for (int i = 0; i < 200000 / 8; ++i)
+      {
+        text += "/* Function " + std::to_string(i) + "\n   of the benchmark source */\n";
+        text += "#define VALUE_" + std::to_string(i) + " " + std::to_string(i * 7) + "\n";
+        text += "static int function" + std::to_string(i) + "(const char *text)\n";
+        text += "{\n";
+        text += "  return text[0] == 'x' ? VALUE_" + std::to_string(i) + " : 0x1F; // Comment\n";
+        text += "}\n\n";
+      }
+
+      nui::TextBox::Ptr textBox = new nui::TextBox(window, "", nui::Docking::Client);
+      textBox->setMonospace();
+      textBox->setMultiline();
+      textBox->setTokenizer(new nui::CppTokenizer());
+      textBox->setText(text);
+    },
+    [](nui::Root *root) { return root->getChild(0); },
+    nullptr,
+    [](nui::Root *root, std::vector<Result> &results)
+    {
+      // Typing at the focused line with the text drawn after each key, opening and closing a block comment
+      static const char keys[] = { '/', '*', '*', '/' };
+
+      results.push_back(measure("typeAndDraw", [&](size_t i)
+      {
+        root->eventKeyDown(nui::Key::Character, keys[i % 4]);
+        root->eventKeyUp(nui::Key::Character, keys[i % 4]);
+        tick(root);
+        root->addDamage(root->getRect());
+        draw(root, false);
+      }));
+    } });
+
+  workloads.push_back({ "wrap100k",
+    [](nui::Root *root)
+    {
+      nui::Window::Ptr window = new nui::Window(root, "Wrap");
+      window->setRect(0, 0, g_ScreenWidth, g_ScreenHeight);
+
+      std::string text;
+
+      for (int i = 0; i < 100000; ++i)
+      {
+        text += "Paragraph " + std::to_string(i) + " of the benchmark text";
+        text += i % 4 ? " which is long enough to be wrapped into several rows when the text box is narrow, words are "
+          "separated by spaces and the rows break after the last space that fits\n" : "\n";
+      }
+
+      nui::TextBox::Ptr textBox = new nui::TextBox(window, "", nui::Docking::Client);
+      textBox->setMultiline();
+      textBox->setWordWrap();
+      textBox->setText(text);
+    },
+    [](nui::Root *root) { return root->getChild(0); },
+    nullptr,
+    [](nui::Root *root, std::vector<Result> &results)
+    {
+      // Frame after the width changes, visible lines are wrapped again and a part of the others in the background
+      nui::Control *window = root->getChild(0);
+
+      results.push_back(measure("resizeFrame", [&](size_t i)
+      {
+        window->setSize(i % 2 ? g_ScreenWidth : g_ScreenWidth / 2, g_ScreenHeight);
+        tick(root);
+        root->addDamage(root->getRect());
+        draw(root, false);
+      }));
+    } });
+
+  workloads.push_back({ "logStream",
+    [](nui::Root *root)
+    {
+      nui::Window::Ptr window = new nui::Window(root, "Stream");
+      window->setRect(0, 0, g_ScreenWidth, g_ScreenHeight);
+
+      // Starts full so that every frame drops as many lines as it adds
+      std::string text;
+      text.reserve(g_StreamCapacity);
+
+      for (size_t i = 0; text.length() < g_StreamCapacity; ++i)
+        text += "Line " + std::to_string(i) + " of the streamed log\n";
+
+      g_StreamTextBox = new nui::TextBox(window, "", nui::Docking::Client);
+      g_StreamTextBox->setMonospace();
+      g_StreamTextBox->setMultiline();
+      g_StreamTextBox->setLogCapacity(g_StreamCapacity);
+      g_StreamTextBox->setText(text);
+    },
+    [](nui::Root *root) { return root->getChild(0); },
+    nullptr,
+    [](nui::Root *root, std::vector<Result> &results)
+    {
+      // One frame of a log growing by 100k lines per second at 60 frames per second
+      std::string lines;
+
+      results.push_back(measure("appendFrame", [&](size_t i)
+      {
+        for (size_t line = 0; line < g_StreamLinesPerFrame; ++line)
+        {
+          lines = "Appended line " + std::to_string(i * g_StreamLinesPerFrame + line) + " of the streamed log\n";
+          g_StreamTextBox->appendText(lines);
+        }
+
+        tick(root);
+        draw(root, false);
+      }));
+
+      g_StreamTextBox = nullptr;
+    } });
+
+  auto buildFontSizes = [](nui::Root *root)
+  {
+    nui::Window::Ptr window = new nui::Window(root, "Font sizes");
+    window->setRect(0, 0, g_ScreenWidth, g_ScreenHeight);
+    window->setStyle(new nui::Graphics::Style());
+
+    for (int i = 0; i < 40; ++i)
+      new nui::Button(window, "Button " + std::to_string(i), nui::Docking::Top);
+  };
+
+  auto measureFontSizes = [](nui::Root *root, std::vector<Result> &results)
+  {
+    // Frame drawing text at a size missing from the font atlas, there are too many sizes to keep all of them
+    nui::Control *window = root->getChild(0);
+
+    auto newSizeFrame = [&](size_t i)
+    {
+      window->getStyle()->textSize = 10 + static_cast<int>(i % 190);
+      invalidateAll(window);
+      draw(root, false);
+    };
+
+    results.push_back(measure("newSizeFrame", newSizeFrame));
+
+    // Same with glyphs rasterized in the background and uploaded at the beginning of the next frame
+    nvgFontThreadCount(g_NVGcontext, 2);
+    results.push_back(measure("newSizeFrameAsync", newSizeFrame));
+    nvgFontThreadCount(g_NVGcontext, 0);
+  };
+
+  workloads.push_back({ "fontSizes", buildFontSizes, [](nui::Root *root) { return root->getChild(0); }, nullptr, measureFontSizes });
+
+  // Same with glyphs stored once as distance fields and scaled to every size
+  workloads.push_back({ "fontSizesSDF", buildFontSizes, [](nui::Root *root) { return root->getChild(0); }, nullptr, measureFontSizes,
+    NVG_SDF_TEXT });
+
+  return workloads;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+std::string runWorkload(const Workload &workload)
+{
+  std::vector<Result> results;
+  NVGcontext *sharedContext = g_NVGcontext;
+
+  if (workload.nvgFlags)
+    g_NVGcontext = nvgCreateSW(NVG_ANTIALIAS | workload.nvgFlags);
+
+  nui::Root::Ptr root = new nui::Root(g_NVGcontext);
+  root->setSize(g_ScreenWidth, g_ScreenHeight);
+
+  if (workload.prepare)
+    workload.prepare();
+
+  size_t peakBase = g_AllocStats.live;
+  g_AllocStats.peak = peakBase;
+
+  {
+    Result build;
+    build.name = "build";
+    build.iterations = 1;
+
+    size_t countBefore = g_AllocStats.count;
+    size_t bytesBefore = g_AllocStats.bytes;
+    double start = getSeconds();
+    workload.build(root);
+
+    build.nsPerOp = (getSeconds() - start) * 1e9;
+    build.allocationsPerOp = static_cast<double>(g_AllocStats.count - countBefore);
+    build.bytesPerOp = static_cast<double>(g_AllocStats.bytes - bytesBefore);
+    results.push_back(build);
+  }
+
+  // Initial layout and paint
+  tick(root);
+  draw(root, false);
+
+  nui::Control *layoutTarget = workload.getLayoutTarget(root);
+  nui::Vec2 layoutSize = layoutTarget->getSize();
+
+  results.push_back(measure("tickClean", [&](size_t) { tick(root); }));
+
+  results.push_back(measure("tickLayout", [&](size_t i)
+  {
+    layoutTarget->setSize(layoutSize.x - static_cast<int>(i & 1), layoutSize.y);
+    tick(root);
+  }));
+
+  layoutTarget->setSize(layoutSize.x, layoutSize.y);
+  tick(root);
+
+  results.push_back(measure("controlAtPoint", [&](size_t i)
+  {
+    root->controlAtPoint(static_cast<int>((i * 7919) % g_ScreenWidth), static_cast<int>((i * 104729) % g_ScreenHeight));
+  }));
+
+  results.push_back(measure("mouseMotion", [&](size_t i)
+  {
+    root->eventMouseMotion(static_cast<int>((i * 7919) % g_ScreenWidth), static_cast<int>((i * 104729) % g_ScreenHeight));
+  }));
+
+  results.push_back(measure("click", [&](size_t i)
+  {
+    root->eventMouseMotion(static_cast<int>((i * 7919) % g_ScreenWidth), static_cast<int>((i * 104729) % g_ScreenHeight));
+    root->eventMouseButtonDown(nui::MouseButton::Left);
+    root->eventMouseButtonUp(nui::MouseButton::Left);
+    tick(root);
+  }));
+
+  // Focus whatever is in the middle of the tested tree, typing goes to text boxes
+  nui::Vec2 center = layoutTarget->getAbsolutePosition() + nui::Vec2(layoutTarget->getWidth() / 2, layoutTarget->getHeight() / 2);
+  root->eventMouseMotion(center.x, center.y);
+  root->eventMouseButtonDown(nui::MouseButton::Left);
+  root->eventMouseButtonUp(nui::MouseButton::Left);
+  tick(root);
+
+  results.push_back(measure("keyPress", [&](size_t i)
+  {
+    root->eventKeyDown(nui::Key::Character, 'a' + static_cast<int>(i % 26));
+    root->eventKeyUp(nui::Key::Character, 'a' + static_cast<int>(i % 26));
+    tick(root);
+  }));
+
+  // Clicks may have moved windows around
+  tick(root);
+  draw(root, false);
+
+  // Nothing changed, only the painted areas are checked
+  results.push_back(measure("drawIdle", [&](size_t) { draw(root, false); }));
+
+  results.push_back(measure("drawCached", [&](size_t)
+  {
+    root->addDamage(root->getRect());
+    draw(root, false);
+  }));
+
+  results.push_back(measure("drawInvalidated", [&](size_t)
+  {
+    invalidateAll(root);
+    draw(root, false);
+  }));
+
+  results.push_back(measure("drawRasterized", [&](size_t)
+  {
+    root->addDamage(root->getRect());
+    draw(root, true);
+  }));
+
+  if (workload.measureExtra)
+    workload.measureExtra(root, results);
+
+  size_t numControls = countControls(root);
+  size_t peakBytes = g_AllocStats.peak - peakBase;
+
+  root = nullptr;
+
+  if (g_NVGcontext != sharedContext)
+  {
+    nvgDeleteSW(g_NVGcontext);
+    g_NVGcontext = sharedContext;
+  }
+
+  std::string json;
+  char buffer[256];
+
+  snprintf(buffer, sizeof(buffer), "    {\n      \"workload\": \"%s\",\n      \"controls\": %zu,\n      \"peakBytes\": %zu,\n      \"ops\": [",
+    workload.name, numControls, peakBytes);
+  json += buffer;
+
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const Result &r = results[i];
+
+    snprintf(buffer, sizeof(buffer), "%s\n        { \"name\": \"%s\", \"iterations\": %zu, \"nsPerOp\": %.1f, \"allocationsPerOp\": %.2f, \"bytesPerOp\": %.1f }",
+      i ? "," : "", r.name.c_str(), r.iterations, r.nsPerOp, r.allocationsPerOp, r.bytesPerOp);
+    json += buffer;
+  }
+
+  json += "\n      ]\n    }";
+  return json;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  const char *outputFileName = argc > 1 ? argv[1] : "-";
+
+  g_NVGcontext = nvgCreateSW(NVG_ANTIALIAS);
+  g_Pixels.resize(g_ScreenWidth * g_ScreenHeight * 4);
+
+  std::string json = "{\n  \"benchmarks\": [\n";
+  bool first = true;
+
+  for (const Workload &workload : createWorkloads())
+  {
+    bool selected = argc <= 2;
+
+    for (int i = 2; i < argc; ++i)
+      selected |= strcmp(argv[i], workload.name) == 0;
+
+    if (!selected)
+      continue;
+
+    fprintf(stderr, "%s...\n", workload.name);
+
+    if (!first)
+      json += ",\n";
+
+    json += runWorkload(workload);
+    first = false;
+  }
+
+  json += "\n  ]\n}\n";
+
+  nvgDeleteSW(g_NVGcontext);
+
+  if (g_LogFileCreated)
+    remove(g_LogFileName);
+
+  FILE *output = strcmp(outputFileName, "-") ? fopen(outputFileName, "w") : stdout;
+
+  if (!output)
+  {
+    fprintf(stderr, "Can't open %s\n", outputFileName);
+    return 1;
+  }
+
+  fputs(json.c_str(), output);
+
+  if (output != stdout)
+    fclose(output);
+
+  return 0;
+}
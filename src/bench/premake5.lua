@@ -0,0 +1,13 @@
+project("bench")
+
+generateProject( 
+{
+	type = "console",
+	language = "C++",
+	name = "nui_bench",
+})
+
+links { "NUI", "nanovg" }
+
+filter { "system:linux" }
+  links { "pthread" }
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <atomic>
+#include <cstring>
 #include <map>
 
 #include <SDL.h>
@@ -17,6 +18,7 @@
 #define NANOVG_GL3_IMPLEMENTATION
 #include <nanovg/nanovg.h>
 #include <nanovg/nanovg_gl.h>
+#include <nanovg/nanovg_gl_utils.h>
 
 std::atomic_bool g_ShouldQuit;
 
@@ -32,6 +34,10 @@ SDL_Cursor *g_CursorResizeRL = nullptr;
 
 NVGcontext *g_NVGcontext = nullptr;
 
+// UI is rendered offscreen so that only damaged areas have to be repainted each frame
+NVGLUframebuffer *g_Framebuffer = nullptr;
+nui::Vec2 g_FramebufferSize;
+
 gl2d::context *g_Context2D = nullptr;
 
 uint64_t g_TickOffset = 0;
@@ -41,6 +47,9 @@ uint64_t g_TickFrequency = 0;
 nui::Root::Ptr g_Root = nullptr;
 bool g_TextInputActive = false;
 
+// Window contents were lost (uncovered, restored), the last frame has to be presented again even if nothing changed
+bool g_Exposed = false;
+
 //---------------------------------------------------------------------------------------------------------------------
 NVGcontext *getNVGcontext()
 {
@@ -92,27 +101,52 @@ void tick()
   nui::Vec2 windowSize;
   SDL_GetWindowSize(g_MainWindow, &windowSize.x, &windowSize.y);
 
-  // Clear everything
+  // Recreate offscreen buffer on resize, its previous content is lost so everything has to be repainted
+  if (!g_Framebuffer || g_FramebufferSize.x != windowSize.x || g_FramebufferSize.y != windowSize.y)
+  {
+    if (g_Framebuffer)
+      nvgluDeleteFramebuffer(g_NVGcontext, g_Framebuffer);
+
+    g_Framebuffer = nvgluCreateFramebuffer(g_NVGcontext, windowSize.x, windowSize.y, 0);
+    g_FramebufferSize = windowSize;
+    g_Root->invalidate();
+  }
+
+  g_Root->tick(time, deltaTime);
+
+  nvgluBindFramebuffer(g_Framebuffer);
   glViewport(0, 0, windowSize.x, windowSize.y);
-  glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
-  glClearDepth(1.0f);
-  glClearStencil(0);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
   nvgBeginFrame(g_NVGcontext, windowSize.x, windowSize.y, 1);
+  bool painted = g_Root->draw();
 
-  g_Root->setSize(windowSize.x, windowSize.y);
-  g_Root->tick(time, deltaTime);
-  g_Root->draw();
+  {
+    NUI_PROFILE_SCOPE(EndFrame);
+    nvgEndFrame(g_NVGcontext);
+  }
+
+  nvgluBindFramebuffer(nullptr);
+
+  if (painted || g_Exposed)
+  {
+    NUI_PROFILE_SCOPE(Flush);
+
+    g_Exposed = false;
 
-  nvgEndFrame(g_NVGcontext);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, g_Framebuffer->fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, windowSize.x, windowSize.y, 0, 0, windowSize.x, windowSize.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-  g_Context2D->frame_begin();
-  g_Context2D->move_to({0, 0});
-  g_Context2D->line_to({400, 300});
-  g_Context2D->frame_end();
+    g_Context2D->frame_begin();
+    g_Context2D->move_to({0, 0});
+    g_Context2D->line_to({400, 300});
+    g_Context2D->frame_end();
 
-  SDL_GL_SwapWindow(g_MainWindow);
+    SDL_GL_SwapWindow(g_MainWindow);
+  }
+  else
+    SDL_Delay(1);
 
   updateMouseCursor();
 
@@ -133,7 +167,10 @@ void tick()
 int eventFilter(void *userData, SDL_Event *e)
 {
   if (e->type == SDL_WINDOWEVENT && e->window.event == SDL_WINDOWEVENT_RESIZED)
+  {
+    g_Root->queueResize(e->window.data1, e->window.data2);
     tick();
+  }
 
   return 1;
 }
@@ -197,12 +234,21 @@ int main(int argc, char *argv[])
   // Initialize NanoVG
   g_NVGcontext = nvgCreateGL3(NVG_ANTIALIAS | NVG_STENCIL_STROKES);
 
+  // Glyphs of new sizes are rasterized in the background instead of stalling the frame that needs them
+  nvgFontThreadCount(g_NVGcontext, 2);
+
   g_Context2D = new gl2d::context();
 
   // Initialize UI
   g_Root = new nui::Root(g_NVGcontext);
   g_Root->setSize(width, height);
 
+  // Glyphs of the last run are uploaded at once instead of being rasterized by the first frames
+  g_Root->loadFontCache("fonts.cache");
+
+  // Latin-1 at the default size is ready before the first text needs it
+  g_Root->prefetchGlyphs(nui::Graphics::Style::DefaultTextSize, 0x20, 0xff);
+
   // Set new cursor
   SDL_SetCursor(g_CursorArrow);
 
@@ -282,6 +328,7 @@ int main(int argc, char *argv[])
     nui::TextBox::Ptr textBox = new nui::TextBox(window, "", nui::Docking::Client);
     textBox->setMonospace();
     textBox->setMultiline();
+    textBox->setTokenizer(new nui::CppTokenizer());
 
     textBox->loadTextFromFile("C:\\Temp\\Forward.cpp");
   }
@@ -361,6 +408,13 @@ int main(int argc, char *argv[])
     }
   }
 
+#if defined(NUI_PROFILER)
+  {
+    nui::ProfilerOverlay::Ptr overlay = new nui::ProfilerOverlay(g_Root);
+    overlay->setPosition(width - overlay->getWidth() - 8, 8);
+  }
+#endif
+
   // Main loop
   while (!g_ShouldQuit)
   {
@@ -373,21 +427,30 @@ int main(int argc, char *argv[])
           g_ShouldQuit = true;
           break;
 
+        case SDL_WINDOWEVENT:
+        {
+          if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+            g_Root->queueResize(event.window.data1, event.window.data2);
+          else if (event.window.event == SDL_WINDOWEVENT_EXPOSED)
+            g_Exposed = true;
+        }
+        break;
+
         case SDL_MOUSEMOTION:
         {
-          g_Root->eventMouseMotion(event.motion.x, event.motion.y);
+          g_Root->queueMouseMotion(event.motion.x, event.motion.y);
         }
         break;
 
         case SDL_MOUSEBUTTONDOWN:
         {
-          g_Root->eventMouseButtonDown(SDL2UIButton[event.button.button]);
+          g_Root->queueMouseButtonDown(SDL2UIButton[event.button.button]);
         }
         break;
 
         case SDL_MOUSEBUTTONUP:
         {
-          g_Root->eventMouseButtonUp(SDL2UIButton[event.button.button]);
+          g_Root->queueMouseButtonUp(SDL2UIButton[event.button.button]);
         }
         break;
 
@@ -396,7 +459,7 @@ int main(int argc, char *argv[])
           auto iter = SDL2UIKey.find(event.key.keysym.sym);
 
           if (iter != SDL2UIKey.end())
-            g_Root->eventKeyDown(iter->second);
+            g_Root->queueKeyDown(iter->second);
         }
         break;
 
@@ -405,14 +468,24 @@ int main(int argc, char *argv[])
           auto iter = SDL2UIKey.find(event.key.keysym.sym);
 
           if (iter != SDL2UIKey.end())
-            g_Root->eventKeyUp(iter->second);
+            g_Root->queueKeyUp(iter->second);
         }
         break;
 
         case SDL_TEXTINPUT:
         {
-          g_Root->eventKeyDown(nui::Key::Character, event.text.text[0]);
-          g_Root->eventKeyUp(nui::Key::Character, event.text.text[0]);
+          // Text is UTF-8 and may contain several characters
+          const char *text = event.text.text;
+          const char *end = text + strlen(text);
+
+          while (text < end)
+          {
+            size_t length;
+            int character = nui::decodeUtf8(text, end, &length);
+            g_Root->queueKeyDown(nui::Key::Character, character);
+            g_Root->queueKeyUp(nui::Key::Character, character);
+            text += length;
+          }
         }
         break;
       }
@@ -421,9 +494,17 @@ int main(int argc, char *argv[])
     tick();
   }
 
+#if defined(NUI_PROFILER)
+  nui::Profiler::get().saveJSON("profile.json");
+#endif
+
   // Deinitialize UI
+  g_Root->saveFontCache("fonts.cache");
   g_Root = nullptr;
 
+  if (g_Framebuffer)
+    nvgluDeleteFramebuffer(g_NVGcontext, g_Framebuffer);
+
   // Destroy NanoVG context
   nvgDeleteGL3(g_NVGcontext);
 
@@ -9,4 +9,7 @@ generateProject(
 links { "NUI", "SDL", "nanovg", "glew" }
 
 filter { "system:windows" }
-  links { "opengl32", "imm32", "winmm", "version" }
\ No newline at end of file
+  links { "opengl32", "imm32", "winmm", "version" }
+
+filter { "system:linux" }
+  links { "pthread" }
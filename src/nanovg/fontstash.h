@@ -24,6 +24,9 @@
 enum FONSflags {
 	FONS_ZERO_TOPLEFT = 1,
 	FONS_ZERO_BOTTOMLEFT = 2,
+	// Glyphs are stored once as signed distance fields of FONS_SDF_SIZE and scaled to every size and blur,
+	// the edge is at 128 and the field reaches FONS_SDF_PAD pixels of FONS_SDF_SIZE out of it. Needs stb_truetype.
+	FONS_SDF = 4,
 };
 
 enum FONSalign {
@@ -95,6 +98,22 @@ int fonsExpandAtlas(FONScontext* s, int width, int height);
 // Resets the whole stash.
 int fonsResetAtlas(FONScontext* stash, int width, int height);
 
+// Atlas pages, squares of FONS_ATLAS_PAGE_SIZE packed and evicted separately.
+// Starts a new frame, pages used since then are never evicted.
+void fonsBeginFrame(FONScontext* s);
+// Marks pages under the texture coordinates as used, for glyph quads drawn without looking the glyphs up again.
+void fonsTouchAtlas(FONScontext* s, float s0, float t0, float s1, float t1);
+// Drops glyphs of the least recently used page to make room in a full atlas, texture coordinates of glyphs
+// made before become invalid. Returns 0 if all pages were used in the current frame.
+int fonsEvictAtlasPage(FONScontext* s);
+
+// Glyph cache files, the atlas and the glyphs saved to start the next run with.
+// Saves the glyphs of all fonts, background rasterization is finished first. Returns 1 on success.
+int fonsSaveCache(FONScontext* s, const char* path);
+// Replaces the atlas with a cache file in memory, glyphs are matched to loaded fonts by the hash of their data.
+// Returns 0 and leaves the atlas as it was if the file was saved by another version or with other settings.
+int fonsLoadCache(FONScontext* s, const unsigned char* data, int ndata);
+
 // Add fonts
 int fonsAddFont(FONScontext* s, const char* name, const char* path);
 int fonsAddFontMem(FONScontext* s, const char* name, unsigned char* data, int ndata, int freeData);
@@ -125,10 +144,19 @@ void fonsVertMetrics(FONScontext* s, float* ascender, float* descender, float* l
 int fonsTextIterInit(FONScontext* stash, FONStextIter* iter, float x, float y, const char* str, const char* end);
 int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, struct FONSquad* quad);
 
-// Pull texture changes
+// Pull texture changes, fonsValidateTexture() returns dirty rectangles one page at a time until it returns 0.
 const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* height);
 int fonsValidateTexture(FONScontext* s, int* dirty);
 
+// Background rasterization, not available with FreeType.
+// Missing glyphs are rasterized by 'count' threads instead of when they're first used, 0 turns it off (default).
+// Their quads are valid right away but they stay blank until fonsUpdateAsync() adds them to the texture data.
+void fonsSetThreadCount(FONScontext* s, int count);
+// Copies glyphs finished in the background to the texture data, returns number of glyphs added.
+int fonsUpdateAsync(FONScontext* s);
+// Creates glyphs of a code point range in current font, size and blur ahead of use.
+void fonsPrefetchGlyphs(FONScontext* s, unsigned int first, unsigned int last);
+
 // Draws the stash texture for debugging
 void fonsDrawDebug(FONScontext* s, float x, float y);
 
@@ -171,6 +199,12 @@ int fons__tt_loadFont(FONScontext *context, FONSttFontImpl *font, unsigned char
 	return ftError == 0;
 }
 
+void fons__tt_setAllocator(FONSttFontImpl *font, void *up)
+{
+	FONS_NOTUSED(font);
+	FONS_NOTUSED(up);
+}
+
 void fons__tt_getFontVMetrics(FONSttFontImpl *font, int *ascent, int *descent, int *lineGap)
 {
 	*ascent = font->font->ascender;
@@ -229,6 +263,22 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	}
 }
 
+// Distance fields are made from glyph outlines of stb_truetype, FONS_SDF is dropped when the stash is created
+void fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+							 float scale, int glyph, int x0, int y0, int spread)
+{
+	FONS_NOTUSED(font);
+	FONS_NOTUSED(output);
+	FONS_NOTUSED(outWidth);
+	FONS_NOTUSED(outHeight);
+	FONS_NOTUSED(outStride);
+	FONS_NOTUSED(scale);
+	FONS_NOTUSED(glyph);
+	FONS_NOTUSED(x0);
+	FONS_NOTUSED(y0);
+	FONS_NOTUSED(spread);
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	FT_Vector ftKerning;
@@ -259,13 +309,19 @@ int fons__tt_init(FONScontext *context)
 int fons__tt_loadFont(FONScontext *context, FONSttFontImpl *font, unsigned char *data, int dataSize)
 {
 	int stbError;
+	FONS_NOTUSED(context);
 	FONS_NOTUSED(dataSize);
 
-	font->font.userdata = context;
 	stbError = stbtt_InitFont(&font->font, data, 0);
 	return stbError;
 }
 
+// Temporary allocations of the font are made from the FONSscratch at 'up'
+void fons__tt_setAllocator(FONSttFontImpl *font, void *up)
+{
+	font->font.userdata = up;
+}
+
 void fons__tt_getFontVMetrics(FONSttFontImpl *font, int *ascent, int *descent, int *lineGap)
 {
 	stbtt_GetFontVMetrics(&font->font, ascent, descent, lineGap);
@@ -296,6 +352,76 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	stbtt_MakeGlyphBitmap(&font->font, output, outWidth, outHeight, outStride, scaleX, scaleY, glyph);
 }
 
+// Writes the signed distance to the glyph outline, 128 on the outline, 255 and 0 'spread' pixels inside and outside
+// of it. Pixel (0,0) of the output is at (x0,y0) in the coordinates of the glyph bitmap box.
+void fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+							 float scale, int glyph, int x0, int y0, int spread)
+{
+	stbtt_vertex* verts = NULL;
+	float* segs;
+	float px = 0, py = 0;
+	int nverts, nsegs = 0, i, j, x, y;
+
+	nverts = stbtt_GetGlyphShape(&font->font, glyph, &verts);
+
+	// Outline is flattened to line segments in bitmap coordinates, curves are short at the sizes of distance fields
+	segs = (float*)malloc(sizeof(float) * 4 * (nverts * 8 + 1));
+	if (segs == NULL) {
+		stbtt_FreeShape(&font->font, verts);
+		return;
+	}
+	for (i = 0; i < nverts; i++) {
+		float vx = verts[i].x * scale, vy = -verts[i].y * scale;
+		if (verts[i].type == STBTT_vline) {
+			float* s = &segs[nsegs++ * 4];
+			s[0] = px; s[1] = py; s[2] = vx; s[3] = vy;
+		} else if (verts[i].type == STBTT_vcurve) {
+			float cx = verts[i].cx * scale, cy = -verts[i].cy * scale;
+			float ax = px, ay = py;
+			for (j = 1; j <= 8; j++) {
+				float t = j / 8.0f, it = 1.0f - t;
+				float* s = &segs[nsegs++ * 4];
+				s[0] = ax; s[1] = ay;
+				s[2] = ax = it*it*px + 2*it*t*cx + t*t*vx;
+				s[3] = ay = it*it*py + 2*it*t*cy + t*t*vy;
+			}
+		}
+		px = vx;
+		py = vy;
+	}
+	stbtt_FreeShape(&font->font, verts);
+
+	for (y = 0; y < outHeight; y++) {
+		float cy = y0 + y + 0.5f;
+		for (x = 0; x < outWidth; x++) {
+			float cx = x0 + x + 0.5f;
+			float mind = (float)spread * spread;
+			float d;
+			int winding = 0;
+			for (i = 0; i < nsegs; i++) {
+				const float* s = &segs[i * 4];
+				float dx = s[2] - s[0], dy = s[3] - s[1];
+				float len = dx*dx + dy*dy;
+				float t = len > 0.0f ? ((cx - s[0])*dx + (cy - s[1])*dy) / len : 0.0f;
+				float ex, ey;
+				if (t < 0.0f) t = 0.0f;
+				if (t > 1.0f) t = 1.0f;
+				ex = s[0] + dx*t - cx;
+				ey = s[1] + dy*t - cy;
+				if (ex*ex + ey*ey < mind) mind = ex*ex + ey*ey;
+				// Non-zero winding of a ray towards +x tells the inside
+				if ((s[1] <= cy) != (s[3] <= cy) && s[0] + (cy - s[1]) * dx / dy > cx)
+					winding += dy > 0.0f ? 1 : -1;
+			}
+			d = sqrtf(mind) / (2.0f * spread);
+			d = winding != 0 ? 0.5f + d : 0.5f - d;
+			output[x + y * outStride] = (unsigned char)(d * 255.0f + 0.5f);
+		}
+	}
+
+	free(segs);
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	return stbtt_GetGlyphKernAdvance(&font->font, glyph1, glyph2);
@@ -306,8 +432,8 @@ int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 #ifndef FONS_SCRATCH_BUF_SIZE
 #	define FONS_SCRATCH_BUF_SIZE 16000
 #endif
-#ifndef FONS_HASH_LUT_SIZE
-#	define FONS_HASH_LUT_SIZE 256
+#ifndef FONS_GLYPH_ROWS
+#	define FONS_GLYPH_ROWS 4
 #endif
 #ifndef FONS_INIT_FONTS
 #	define FONS_INIT_FONTS 4
@@ -324,6 +450,37 @@ int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 #ifndef FONS_MAX_STATES
 #	define FONS_MAX_STATES 20
 #endif
+#ifndef FONS_MAX_THREADS
+#	define FONS_MAX_THREADS 16
+#endif
+#ifndef FONS_ATLAS_PAGE_SIZE
+#	define FONS_ATLAS_PAGE_SIZE 512
+#endif
+#ifndef FONS_SDF_SIZE
+#	define FONS_SDF_SIZE 32
+#endif
+#ifndef FONS_SDF_PAD
+#	define FONS_SDF_PAD 6
+#endif
+
+// Glyph cache files are "FSGC" in native byte order, the version changes with their layout
+#define FONS_CACHE_MAGIC 0x43475346
+#define FONS_CACHE_VERSION 1
+
+#ifdef _WIN32
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+typedef HANDLE FONSthread;
+typedef CRITICAL_SECTION FONSmutex;
+typedef CONDITION_VARIABLE FONScond;
+#else
+#	include <pthread.h>
+typedef pthread_t FONSthread;
+typedef pthread_mutex_t FONSmutex;
+typedef pthread_cond_t FONScond;
+#endif
 
 static unsigned int fons__hashint(unsigned int a)
 {
@@ -350,13 +507,29 @@ struct FONSglyph
 {
 	unsigned int codepoint;
 	int index;
-	int next;
 	short size, blur;
 	short x0,y0,x1,y1;
 	short xadv,xoff,yoff;
 };
 typedef struct FONSglyph FONSglyph;
 
+// Slot of the glyph hash table, the key is stored to compare it without touching the glyph
+struct FONSglyphSlot
+{
+	unsigned int codepoint;
+	short size, blur;
+	int glyph;
+};
+typedef struct FONSglyphSlot FONSglyphSlot;
+
+// Glyphs of code points below 256 at one size and blur, -1 where the hash table wasn't looked up yet
+struct FONSglyphRow
+{
+	short size, blur;
+	int glyphs[256];
+};
+typedef struct FONSglyphRow FONSglyphRow;
+
 struct FONSfont
 {
 	FONSttFontImpl font;
@@ -364,13 +537,20 @@ struct FONSfont
 	unsigned char* data;
 	int dataSize;
 	unsigned char freeData;
+	// Hash of the data identifying the font in cache files, 0 until needed
+	unsigned int hash;
 	float ascender;
 	float descender;
 	float lineh;
 	FONSglyph* glyphs;
 	int cglyphs;
 	int nglyphs;
-	int lut[FONS_HASH_LUT_SIZE];
+	// Open addressing on code point, size and blur, at most half full
+	FONSglyphSlot* slots;
+	int cslots;
+	FONSglyphRow rows[FONS_GLYPH_ROWS];
+	int nrows;
+	int nextRow;
 };
 typedef struct FONSfont FONSfont;
 
@@ -399,43 +579,142 @@ struct FONSatlas
 };
 typedef struct FONSatlas FONSatlas;
 
+// Cache files are the header, the skyline of each page, each font followed by its glyphs and the texture data
+struct FONScacheHeader
+{
+	unsigned int magic;
+	int version;
+	int flags;
+	int pageSize, sdfSize, sdfPad;
+	int width, height;
+	int nfonts;
+};
+typedef struct FONScacheHeader FONScacheHeader;
+
+struct FONScacheFont
+{
+	unsigned int hash;
+	int dataSize;
+	int nglyphs;
+};
+typedef struct FONScacheFont FONScacheFont;
+
+struct FONScacheGlyph
+{
+	unsigned int codepoint;
+	int index;
+	short size, blur;
+	short x0,y0,x1,y1;
+	short xadv,xoff,yoff;
+	short pad;
+};
+typedef struct FONScacheGlyph FONScacheGlyph;
+
+struct FONSpage
+{
+	// Skyline in the coordinates of the page
+	FONSatlas* atlas;
+	int x, y;
+	int dirtyRect[4];
+	// Frame the page was last used in
+	int lastUse;
+	// Increased when the page is evicted, glyphs rasterized in the background for it before are dropped
+	int generation;
+};
+typedef struct FONSpage FONSpage;
+
+struct FONSscratch
+{
+	unsigned char* data;
+	int size;
+	// Receives errors, NULL for scratches of worker threads
+	FONScontext* stash;
+};
+typedef struct FONSscratch FONSscratch;
+
+// Glyph rasterized in the background into its own bitmap including the padding
+struct FONSjob
+{
+	FONSttFontImpl font;
+	int glyph;
+	float scale;
+	int x, y, width, height;
+	int pad, blur;
+	int pageGeneration;
+	// Distance fields are computed at the offset of the glyph
+	int sdf, xoff, yoff;
+	int generation;
+	unsigned char* bitmap;
+};
+typedef struct FONSjob FONSjob;
+
+struct FONSjobList
+{
+	FONSjob* jobs;
+	int njobs;
+	int cjobs;
+};
+typedef struct FONSjobList FONSjobList;
+
+struct FONSworker
+{
+	FONScontext* stash;
+	FONSthread thread;
+	FONSscratch scratch;
+};
+typedef struct FONSworker FONSworker;
+
 struct FONScontext
 {
 	FONSparams params;
 	float itw,ith;
 	unsigned char* texData;
-	int dirtyRect[4];
 	FONSfont** fonts;
-	FONSatlas* atlas;
+	// Pages in rows, new glyphs go to the current page first
+	FONSpage* pages;
+	int pageCols, pageRows;
+	int curPage;
+	int frame;
 	int cfonts;
 	int nfonts;
 	float verts[FONS_VERTEX_COUNT*2];
 	float tcoords[FONS_VERTEX_COUNT*2];
 	unsigned int colors[FONS_VERTEX_COUNT];
 	int nverts;
-	unsigned char* scratch;
-	int nscratch;
+	FONSscratch scratch;
 	FONSstate states[FONS_MAX_STATES];
 	int nstates;
 	void (*handleError)(void* uptr, int error, int val);
 	void* errorUptr;
+	// Background rasterization, the lists and the generation are guarded by the mutex
+	FONSworker workers[FONS_MAX_THREADS];
+	int nworkers;
+	FONSmutex mutex;
+	FONScond jobCond;
+	FONSjobList queued;
+	int nextJob;
+	FONSjobList finished;
+	// Increased when the atlas is reset, jobs made for earlier atlases are dropped
+	int generation;
+	int quit;
 };
 
 static void* fons__tmpalloc(size_t size, void* up)
 {
 	unsigned char* ptr;
-	FONScontext* stash = (FONScontext*)up;
+	FONSscratch* scratch = (FONSscratch*)up;
+	FONScontext* stash = scratch->stash;
 
 	// 16-byte align the returned pointer
 	size = (size + 0xf) & ~0xf;
 
-	if (stash->nscratch+(int)size > FONS_SCRATCH_BUF_SIZE) {
-		if (stash->handleError)
-			stash->handleError(stash->errorUptr, FONS_SCRATCH_FULL, stash->nscratch+(int)size);
+	if (scratch->size+(int)size > FONS_SCRATCH_BUF_SIZE) {
+		if (stash != NULL && stash->handleError)
+			stash->handleError(stash->errorUptr, FONS_SCRATCH_FULL, scratch->size+(int)size);
 		return NULL;
 	}
-	ptr = stash->scratch + stash->nscratch;
-	stash->nscratch += (int)size;
+	ptr = scratch->data + scratch->size;
+	scratch->size += (int)size;
 	return ptr;
 }
 
@@ -446,6 +725,26 @@ static void fons__tmpfree(void* ptr, void* up)
 	// empty
 }
 
+#ifdef _WIN32
+static void fons__mutexInit(FONSmutex* m) { InitializeCriticalSection(m); }
+static void fons__mutexDestroy(FONSmutex* m) { DeleteCriticalSection(m); }
+static void fons__lock(FONSmutex* m) { EnterCriticalSection(m); }
+static void fons__unlock(FONSmutex* m) { LeaveCriticalSection(m); }
+static void fons__condInit(FONScond* c) { InitializeConditionVariable(c); }
+static void fons__condDestroy(FONScond* c) { FONS_NOTUSED(c); }
+static void fons__condWait(FONScond* c, FONSmutex* m) { SleepConditionVariableCS(c, m, INFINITE); }
+static void fons__condBroadcast(FONScond* c) { WakeAllConditionVariable(c); }
+#else
+static void fons__mutexInit(FONSmutex* m) { pthread_mutex_init(m, NULL); }
+static void fons__mutexDestroy(FONSmutex* m) { pthread_mutex_destroy(m); }
+static void fons__lock(FONSmutex* m) { pthread_mutex_lock(m); }
+static void fons__unlock(FONSmutex* m) { pthread_mutex_unlock(m); }
+static void fons__condInit(FONScond* c) { pthread_cond_init(c, NULL); }
+static void fons__condDestroy(FONScond* c) { pthread_cond_destroy(c); }
+static void fons__condWait(FONScond* c, FONSmutex* m) { pthread_cond_wait(c, m); }
+static void fons__condBroadcast(FONScond* c) { pthread_cond_broadcast(c); }
+#endif
+
 // Copyright (c) 2008-2010 Bjoern Hoehrmann <bjoern@hoehrmann.de>
 // See http://bjoern.hoehrmann.de/utf-8/decoder/dfa/ for details.
 
@@ -667,11 +966,107 @@ static int fons__atlasAddRect(FONSatlas* atlas, int rw, int rh, int* rx, int* ry
 	return 1;
 }
 
+static FONSpage* fons__pageAt(FONScontext* stash, int x, int y)
+{
+	return &stash->pages[(y / FONS_ATLAS_PAGE_SIZE) * stash->pageCols + x / FONS_ATLAS_PAGE_SIZE];
+}
+
+static void fons__resetDirty(FONSpage* page)
+{
+	page->dirtyRect[0] = page->x + FONS_ATLAS_PAGE_SIZE;
+	page->dirtyRect[1] = page->y + FONS_ATLAS_PAGE_SIZE;
+	page->dirtyRect[2] = page->x;
+	page->dirtyRect[3] = page->y;
+}
+
+// Adds the rect to the dirty rect of the page it's in
+static void fons__markDirty(FONScontext* stash, int x0, int y0, int x1, int y1)
+{
+	FONSpage* page = fons__pageAt(stash, x0, y0);
+	page->dirtyRect[0] = fons__mini(page->dirtyRect[0], x0);
+	page->dirtyRect[1] = fons__mini(page->dirtyRect[1], y0);
+	page->dirtyRect[2] = fons__maxi(page->dirtyRect[2], x1);
+	page->dirtyRect[3] = fons__maxi(page->dirtyRect[3], y1);
+}
+
+static void fons__freePages(FONScontext* stash)
+{
+	int i;
+	for (i = 0; i < stash->pageCols * stash->pageRows; i++)
+		fons__deleteAtlas(stash->pages[i].atlas);
+	free(stash->pages);
+	stash->pages = NULL;
+	stash->pageCols = stash->pageRows = 0;
+	stash->curPage = 0;
+}
+
+// Covers an atlas of the size with pages, pages already there keep their glyphs
+static int fons__layoutPages(FONScontext* stash, int width, int height)
+{
+	int cols = (width + FONS_ATLAS_PAGE_SIZE-1) / FONS_ATLAS_PAGE_SIZE;
+	int rows = (height + FONS_ATLAS_PAGE_SIZE-1) / FONS_ATLAS_PAGE_SIZE;
+	FONSpage* pages = (FONSpage*)malloc(sizeof(FONSpage) * cols * rows);
+	int i, x, y;
+	if (pages == NULL) return 0;
+
+	for (y = 0; y < rows; y++) {
+		for (x = 0; x < cols; x++) {
+			FONSpage* page = &pages[y * cols + x];
+			int w = fons__mini(FONS_ATLAS_PAGE_SIZE, width - x * FONS_ATLAS_PAGE_SIZE);
+			int h = fons__mini(FONS_ATLAS_PAGE_SIZE, height - y * FONS_ATLAS_PAGE_SIZE);
+			if (x < stash->pageCols && y < stash->pageRows) {
+				*page = stash->pages[y * stash->pageCols + x];
+				fons__atlasExpand(page->atlas, w, h);
+				continue;
+			}
+			memset(page, 0, sizeof(FONSpage));
+			page->x = x * FONS_ATLAS_PAGE_SIZE;
+			page->y = y * FONS_ATLAS_PAGE_SIZE;
+			page->lastUse = stash->frame;
+			fons__resetDirty(page);
+			page->atlas = fons__allocAtlas(w, h, FONS_INIT_ATLAS_NODES);
+			if (page->atlas == NULL) {
+				// Only the new pages are freed
+				for (i = 0; i < y * cols + x; i++) {
+					if (i % cols >= stash->pageCols || i / cols >= stash->pageRows)
+						fons__deleteAtlas(pages[i].atlas);
+				}
+				free(pages);
+				return 0;
+			}
+		}
+	}
+
+	free(stash->pages);
+	stash->pages = pages;
+	stash->curPage = fons__mini(stash->curPage, cols * rows - 1);
+	stash->pageCols = cols;
+	stash->pageRows = rows;
+	return 1;
+}
+
+// Finds space for the rect in the pages starting from the current one
+static int fons__allocRect(FONScontext* stash, int w, int h, int* x, int* y)
+{
+	int i, npages = stash->pageCols * stash->pageRows;
+	for (i = 0; i < npages; i++) {
+		int idx = (stash->curPage + i) % npages;
+		FONSpage* page = &stash->pages[idx];
+		if (fons__atlasAddRect(page->atlas, w, h, x, y)) {
+			*x += page->x;
+			*y += page->y;
+			stash->curPage = idx;
+			return 1;
+		}
+	}
+	return 0;
+}
+
 static void fons__addWhiteRect(FONScontext* stash, int w, int h)
 {
 	int x, y, gx, gy;
 	unsigned char* dst;
-	if (fons__atlasAddRect(stash->atlas, w, h, &gx, &gy) == 0)
+	if (fons__atlasAddRect(stash->pages[0].atlas, w, h, &gx, &gy) == 0)
 		return;
 
 	// Rasterize
@@ -682,10 +1077,7 @@ static void fons__addWhiteRect(FONScontext* stash, int w, int h)
 		dst += stash->params.width;
 	}
 
-	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], gx);
-	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], gy);
-	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], gx+w);
-	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], gy+h);
+	fons__markDirty(stash, gx, gy, gx+w, gy+h);
 }
 
 FONScontext* fonsCreateInternal(FONSparams* params)
@@ -698,10 +1090,17 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	memset(stash, 0, sizeof(FONScontext));
 
 	stash->params = *params;
+#ifdef FONS_USE_FREETYPE
+	stash->params.flags &= ~FONS_SDF;
+#endif
+
+	fons__mutexInit(&stash->mutex);
+	fons__condInit(&stash->jobCond);
 
 	// Allocate scratch buffer.
-	stash->scratch = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
-	if (stash->scratch == NULL) goto error;
+	stash->scratch.data = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+	if (stash->scratch.data == NULL) goto error;
+	stash->scratch.stash = stash;
 
 	// Initialize implementation library
 	if (!fons__tt_init(stash)) goto error;
@@ -711,8 +1110,7 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 			goto error;
 	}
 
-	stash->atlas = fons__allocAtlas(stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
-	if (stash->atlas == NULL) goto error;
+	if (!fons__layoutPages(stash, stash->params.width, stash->params.height)) goto error;
 
 	// Allocate space for fonts.
 	stash->fonts = (FONSfont**)malloc(sizeof(FONSfont*) * FONS_INIT_FONTS);
@@ -728,11 +1126,6 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	if (stash->texData == NULL) goto error;
 	memset(stash->texData, 0, stash->params.width * stash->params.height);
 
-	stash->dirtyRect[0] = stash->params.width;
-	stash->dirtyRect[1] = stash->params.height;
-	stash->dirtyRect[2] = 0;
-	stash->dirtyRect[3] = 0;
-
 	// Add white rect at 0,0 for debug drawing.
 	fons__addWhiteRect(stash, 2,2);
 
@@ -818,6 +1211,7 @@ static void fons__freeFont(FONSfont* font)
 {
 	if (font == NULL) return;
 	if (font->glyphs) free(font->glyphs);
+	if (font->slots) free(font->slots);
 	if (font->freeData && font->data) free(font->data);
 	free(font);
 }
@@ -877,7 +1271,7 @@ error:
 
 int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, int dataSize, int freeData)
 {
-	int i, ascent, descent, fh, lineGap;
+	int ascent, descent, fh, lineGap;
 	FONSfont* font;
 
 	int idx = fons__allocFont(stash);
@@ -889,17 +1283,14 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	strncpy(font->name, name, sizeof(font->name));
 	font->name[sizeof(font->name)-1] = '\0';
 
-	// Init hash lookup.
-	for (i = 0; i < FONS_HASH_LUT_SIZE; ++i)
-		font->lut[i] = -1;
-
 	// Read in the font data.
 	font->dataSize = dataSize;
 	font->data = data;
 	font->freeData = (unsigned char)freeData;
 
 	// Init font
-	stash->nscratch = 0;
+	stash->scratch.size = 0;
+	fons__tt_setAllocator(&font->font, &stash->scratch);
 	if (!fons__tt_loadFont(stash, &font->font, data, dataSize)) goto error;
 
 	// Store normalized line height. The real line height is got
@@ -1006,35 +1397,294 @@ static void fons__blur(FONScontext* stash, unsigned char* dst, int w, int h, int
 //	fons__blurcols(dst, w, h, dstStride, alpha);
 }
 
-static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
-								 short isize, short iblur)
+static int fons__addJob(FONSjobList* list, const FONSjob* job)
+{
+	if (list->njobs+1 > list->cjobs) {
+		int cjobs = list->cjobs == 0 ? 64 : list->cjobs * 2;
+		FONSjob* jobs = (FONSjob*)realloc(list->jobs, sizeof(FONSjob) * cjobs);
+		if (jobs == NULL) return 0;
+		list->jobs = jobs;
+		list->cjobs = cjobs;
+	}
+	list->jobs[list->njobs++] = *job;
+	return 1;
+}
+
+static void fons__rasterizeJob(FONSjob* job, FONSscratch* scratch)
+{
+	int pad = job->pad;
+
+	job->bitmap = (unsigned char*)calloc(job->width * job->height, 1);
+	if (job->bitmap == NULL) return;
+
+	// The bitmap starts cleared so the one pixel empty border is already there
+	scratch->size = 0;
+	fons__tt_setAllocator(&job->font, scratch);
+	if (job->sdf)
+		fons__tt_renderGlyphSDF(&job->font, &job->bitmap[1 + job->width], job->width-2, job->height-2, job->width,
+								job->scale, job->glyph, job->xoff + 1, job->yoff + 1, pad);
+	else
+		fons__tt_renderGlyphBitmap(&job->font, &job->bitmap[pad + pad * job->width], job->width-pad*2, job->height-pad*2,
+								   job->width, job->scale, job->scale, job->glyph);
+
+	if (job->blur > 0)
+		fons__blur(NULL, job->bitmap, job->width, job->height, job->width, job->blur);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI fons__workerMain(LPVOID param)
+#else
+static void* fons__workerMain(void* param)
+#endif
+{
+	FONSworker* worker = (FONSworker*)param;
+	FONScontext* stash = worker->stash;
+	FONSjob job;
+
+	for (;;) {
+		fons__lock(&stash->mutex);
+		while (stash->nextJob == stash->queued.njobs && !stash->quit)
+			fons__condWait(&stash->jobCond, &stash->mutex);
+		if (stash->quit) {
+			fons__unlock(&stash->mutex);
+			break;
+		}
+		job = stash->queued.jobs[stash->nextJob++];
+		if (stash->nextJob == stash->queued.njobs)
+			stash->nextJob = stash->queued.njobs = 0;
+		fons__unlock(&stash->mutex);
+
+		fons__rasterizeJob(&job, &worker->scratch);
+
+		fons__lock(&stash->mutex);
+		if (job.bitmap != NULL && !fons__addJob(&stash->finished, &job))
+			free(job.bitmap);
+		fons__unlock(&stash->mutex);
+	}
+
+	return 0;
+}
+
+static void fons__stopWorkers(FONScontext* stash)
+{
+	int i;
+
+	if (stash->nworkers == 0)
+		return;
+
+	fons__lock(&stash->mutex);
+	stash->quit = 1;
+	fons__condBroadcast(&stash->jobCond);
+	fons__unlock(&stash->mutex);
+
+	for (i = 0; i < stash->nworkers; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(stash->workers[i].thread, INFINITE);
+		CloseHandle(stash->workers[i].thread);
+#else
+		pthread_join(stash->workers[i].thread, NULL);
+#endif
+		free(stash->workers[i].scratch.data);
+	}
+
+	stash->nworkers = 0;
+	stash->quit = 0;
+
+	// Jobs nobody took are finished here so that their glyphs don't stay blank
+	for (i = stash->nextJob; i < stash->queued.njobs; i++) {
+		FONSjob* job = &stash->queued.jobs[i];
+		fons__rasterizeJob(job, &stash->scratch);
+		if (job->bitmap != NULL && !fons__addJob(&stash->finished, job))
+			free(job->bitmap);
+	}
+	stash->nextJob = stash->queued.njobs = 0;
+}
+
+static void fons__startWorkers(FONScontext* stash, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		FONSworker* worker = &stash->workers[i];
+		worker->stash = stash;
+		worker->scratch.data = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+		worker->scratch.size = 0;
+		worker->scratch.stash = NULL;
+		if (worker->scratch.data == NULL) break;
+#ifdef _WIN32
+		worker->thread = CreateThread(NULL, 0, fons__workerMain, worker, 0, NULL);
+		if (worker->thread == NULL) {
+			free(worker->scratch.data);
+			break;
+		}
+#else
+		if (pthread_create(&worker->thread, NULL, fons__workerMain, worker) != 0) {
+			free(worker->scratch.data);
+			break;
+		}
+#endif
+		stash->nworkers = i + 1;
+	}
+}
+
+// Queues rasterization of the glyph, returns 0 if it has to be rasterized right away
+static int fons__queueGlyph(FONScontext* stash, FONSfont* font, FONSglyph* glyph, float scale, int pad, int iblur)
+{
+	FONSjob job;
+	int queued;
+
+	job.font = font->font;
+	job.glyph = glyph->index;
+	job.scale = scale;
+	job.x = glyph->x0;
+	job.y = glyph->y0;
+	job.width = glyph->x1 - glyph->x0;
+	job.height = glyph->y1 - glyph->y0;
+	job.pad = pad;
+	job.blur = iblur;
+	job.pageGeneration = fons__pageAt(stash, glyph->x0, glyph->y0)->generation;
+	job.sdf = (stash->params.flags & FONS_SDF) != 0;
+	job.xoff = glyph->xoff;
+	job.yoff = glyph->yoff;
+	job.bitmap = NULL;
+
+	fons__lock(&stash->mutex);
+	job.generation = stash->generation;
+	queued = fons__addJob(&stash->queued, &job);
+	if (queued)
+		fons__condBroadcast(&stash->jobCond);
+	fons__unlock(&stash->mutex);
+
+	return queued;
+}
+
+// Size and blur the glyph is stored with, distance fields are shared by all of them. Returns 0 for too small text.
+static int fons__glyphKey(FONScontext* stash, short* isize, short* iblur)
+{
+	if (*isize < 2) return 0;
+	if (*iblur > 20) *iblur = 20;
+	// Larger glyphs might not fit a page, they are scaled from this size
+	if (*isize > FONS_ATLAS_PAGE_SIZE*5) *isize = FONS_ATLAS_PAGE_SIZE*5;
+	if (stash->params.flags & FONS_SDF) {
+		*isize = FONS_SDF_SIZE*10;
+		*iblur = 0;
+	}
+	return 1;
+}
+
+static unsigned int fons__glyphHash(unsigned int codepoint, short isize, short iblur)
+{
+	return fons__hashint(codepoint ^ ((unsigned int)isize << 20) ^ ((unsigned int)iblur << 12));
+}
+
+// Row of the size and blur, a new one replaces the oldest if 'make' is set
+static FONSglyphRow* fons__glyphRow(FONSfont* font, short isize, short iblur, int make)
 {
-	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, x, y;
+	FONSglyphRow* row;
+	int i;
+	for (i = 0; i < font->nrows; i++) {
+		if (font->rows[i].size == isize && font->rows[i].blur == iblur)
+			return &font->rows[i];
+	}
+	if (!make) return NULL;
+	if (font->nrows < FONS_GLYPH_ROWS) {
+		row = &font->rows[font->nrows++];
+	} else {
+		row = &font->rows[font->nextRow];
+		font->nextRow = (font->nextRow + 1) % FONS_GLYPH_ROWS;
+	}
+	row->size = isize;
+	row->blur = iblur;
+	memset(row->glyphs, 0xff, sizeof(row->glyphs));
+	return row;
+}
+
+static void fons__insertSlot(FONSfont* font, int idx)
+{
+	FONSglyph* glyph = &font->glyphs[idx];
+	unsigned int h = fons__glyphHash(glyph->codepoint, glyph->size, glyph->blur) & (font->cslots-1);
+	while (font->slots[h].glyph != -1)
+		h = (h+1) & (font->cslots-1);
+	font->slots[h].codepoint = glyph->codepoint;
+	font->slots[h].size = glyph->size;
+	font->slots[h].blur = glyph->blur;
+	font->slots[h].glyph = idx;
+}
+
+// Indexes all glyphs of the font again, after they were reset or moved
+static void fons__rebuildGlyphLookup(FONSfont* font)
+{
+	int i;
+	for (i = 0; i < font->cslots; i++)
+		font->slots[i].glyph = -1;
+	for (i = 0; i < font->nglyphs; i++)
+		fons__insertSlot(font, i);
+	font->nrows = font->nextRow = 0;
+}
+
+// Indexes the last glyph added to the font, returns 0 if the table couldn't grow
+static int fons__insertGlyph(FONSfont* font)
+{
+	FONSglyph* glyph = &font->glyphs[font->nglyphs-1];
+	FONSglyphRow* row;
+	if (font->nglyphs*2 > font->cslots) {
+		int cslots = font->cslots == 0 ? 256 : font->cslots*2;
+		FONSglyphSlot* slots = (FONSglyphSlot*)realloc(font->slots, sizeof(FONSglyphSlot) * cslots);
+		if (slots == NULL) return 0;
+		font->slots = slots;
+		font->cslots = cslots;
+		fons__rebuildGlyphLookup(font);
+		return 1;
+	}
+	fons__insertSlot(font, font->nglyphs-1);
+	if (glyph->codepoint < 256 && (row = fons__glyphRow(font, glyph->size, glyph->blur, 0)) != NULL)
+		row->glyphs[glyph->codepoint] = font->nglyphs-1;
+	return 1;
+}
+
+static FONSglyph* fons__findGlyph(FONSfont* font, unsigned int codepoint, short isize, short iblur)
+{
+	FONSglyphRow* row = NULL;
+	unsigned int h;
+
+	// Latin-1 is read straight from the row of its size
+	if (codepoint < 256) {
+		row = fons__glyphRow(font, isize, iblur, 1);
+		if (row->glyphs[codepoint] != -1)
+			return &font->glyphs[row->glyphs[codepoint]];
+	}
+
+	if (font->cslots == 0) return NULL;
+	h = fons__glyphHash(codepoint, isize, iblur) & (font->cslots-1);
+	while (font->slots[h].glyph != -1) {
+		FONSglyphSlot* slot = &font->slots[h];
+		if (slot->codepoint == codepoint && slot->size == isize && slot->blur == iblur) {
+			if (row != NULL)
+				row->glyphs[codepoint] = slot->glyph;
+			return &font->glyphs[slot->glyph];
+		}
+		h = (h+1) & (font->cslots-1);
+	}
+	return NULL;
+}
+
+// Creates a glyph missing from the font, a full atlas is reported to the error callback if 'reportFull' is set.
+static FONSglyph* fons__addGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
+								 short isize, short iblur, int reportFull)
+{
+	int g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, x, y;
 	float scale;
 	FONSglyph* glyph = NULL;
-	unsigned int h;
 	float size = isize/10.0f;
 	int pad, added;
 	unsigned char* bdst;
 	unsigned char* dst;
 
-	if (isize < 2) return NULL;
-	if (iblur > 20) iblur = 20;
-	pad = iblur+2;
+	pad = (stash->params.flags & FONS_SDF) ? FONS_SDF_PAD : iblur+2;
 
 	// Reset allocator.
-	stash->nscratch = 0;
+	stash->scratch.size = 0;
 
-	// Find code point and size.
-	h = fons__hashint(codepoint) & (FONS_HASH_LUT_SIZE-1);
-	i = font->lut[h];
-	while (i != -1) {
-		if (font->glyphs[i].codepoint == codepoint && font->glyphs[i].size == isize && font->glyphs[i].blur == iblur)
-			return &font->glyphs[i];
-		i = font->glyphs[i].next;
-	}
-
-	// Could not find glyph, create it.
 	scale = fons__tt_getPixelHeightScale(&font->font, size);
 	g = fons__tt_getGlyphIndex(&font->font, codepoint);
 	fons__tt_buildGlyphBitmap(&font->font, g, size, scale, &advance, &lsb, &x0, &y0, &x1, &y1);
@@ -1042,16 +1692,17 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	gh = y1-y0 + pad*2;
 
 	// Find free spot for the rect in the atlas
-	added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
-	if (added == 0 && stash->handleError != NULL) {
+	added = fons__allocRect(stash, gw, gh, &gx, &gy);
+	if (added == 0 && reportFull && stash->handleError != NULL) {
 		// Atlas is full, let the user to resize the atlas (or not), and try again.
 		stash->handleError(stash->errorUptr, FONS_ATLAS_FULL, 0);
-		added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
+		added = fons__allocRect(stash, gw, gh, &gx, &gy);
 	}
 	if (added == 0) return NULL;
 
 	// Init glyph.
 	glyph = fons__allocGlyph(font);
+	if (glyph == NULL) return NULL;
 	glyph->codepoint = codepoint;
 	glyph->size = isize;
 	glyph->blur = iblur;
@@ -1063,15 +1714,25 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	glyph->xadv = (short)(scale * advance * 10.0f);
 	glyph->xoff = (short)(x0 - pad);
 	glyph->yoff = (short)(y0 - pad);
-	glyph->next = 0;
 
 	// Insert char to hash lookup.
-	glyph->next = font->lut[h];
-	font->lut[h] = font->nglyphs-1;
+	if (!fons__insertGlyph(font)) {
+		font->nglyphs--;
+		return NULL;
+	}
+
+	// Empty glyphs like spaces have nothing to wait for
+	if (stash->nworkers > 0 && x1 > x0 && y1 > y0 && fons__queueGlyph(stash, font, glyph, scale, pad, iblur))
+		return glyph;
 
 	// Rasterize
-	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
-	fons__tt_renderGlyphBitmap(&font->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale,scale, g);
+	if (stash->params.flags & FONS_SDF) {
+		dst = &stash->texData[(glyph->x0+1) + (glyph->y0+1) * stash->params.width];
+		fons__tt_renderGlyphSDF(&font->font, dst, gw-2,gh-2, stash->params.width, scale, g, glyph->xoff+1,glyph->yoff+1, pad);
+	} else {
+		dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
+		fons__tt_renderGlyphBitmap(&font->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale,scale, g);
+	}
 
 	// Make sure there is one pixel empty border.
 	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
@@ -1096,24 +1757,42 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 
 	// Blur
 	if (iblur > 0) {
-		stash->nscratch = 0;
+		stash->scratch.size = 0;
 		bdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
 		fons__blur(stash, bdst, gw,gh, stash->params.width, iblur);
 	}
 
-	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
-	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0);
-	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], glyph->x1);
-	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], glyph->y1);
+	fons__markDirty(stash, glyph->x0, glyph->y0, glyph->x1, glyph->y1);
+
+	return glyph;
+}
+
+static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
+								 short isize, short iblur)
+{
+	FONSglyph* glyph;
+
+	if (!fons__glyphKey(stash, &isize, &iblur)) return NULL;
 
+	// Find code point and size.
+	glyph = fons__findGlyph(font, codepoint, isize, iblur);
+	// Could not find glyph, create it.
+	if (glyph == NULL)
+		glyph = fons__addGlyph(stash, font, codepoint, isize, iblur, 1);
+
+	// Pages of glyphs in use aren't evicted in this frame
+	if (glyph != NULL)
+		fons__pageAt(stash, glyph->x0, glyph->y0)->lastUse = stash->frame;
 	return glyph;
 }
 
 static void fons__getQuad(FONScontext* stash, FONSfont* font,
-						   int prevGlyphIndex, FONSglyph* glyph,
+						   int prevGlyphIndex, FONSglyph* glyph, short isize,
 						   float scale, float spacing, float* x, float* y, FONSquad* q)
 {
 	float rx,ry,xoff,yoff,x0,y0,x1,y1;
+	// Glyphs stored at another size (distance fields) are scaled to the text size
+	float gscale = (float)isize / glyph->size;
 
 	if (prevGlyphIndex != -1) {
 		float adv = fons__tt_getGlyphKernAdvance(&font->font, prevGlyphIndex, glyph->index) * scale;
@@ -1123,8 +1802,8 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 	// Each glyph has 2px border to allow good interpolation,
 	// one pixel to prevent leaking, and one to allow good interpolation for rendering.
 	// Inset the texture region by one pixel for correct interpolation.
-	xoff = (short)(glyph->xoff+1);
-	yoff = (short)(glyph->yoff+1);
+	xoff = (short)(glyph->xoff+1) * gscale;
+	yoff = (short)(glyph->yoff+1) * gscale;
 	x0 = (float)(glyph->x0+1);
 	y0 = (float)(glyph->y0+1);
 	x1 = (float)(glyph->x1-1);
@@ -1136,8 +1815,8 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 
 		q->x0 = rx;
 		q->y0 = ry;
-		q->x1 = rx + x1 - x0;
-		q->y1 = ry + y1 - y0;
+		q->x1 = rx + (x1 - x0) * gscale;
+		q->y1 = ry + (y1 - y0) * gscale;
 
 		q->s0 = x0 * stash->itw;
 		q->t0 = y0 * stash->ith;
@@ -1149,8 +1828,8 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 
 		q->x0 = rx;
 		q->y0 = ry;
-		q->x1 = rx + x1 - x0;
-		q->y1 = ry - y1 + y0;
+		q->x1 = rx + (x1 - x0) * gscale;
+		q->y1 = ry - (y1 - y0) * gscale;
 
 		q->s0 = x0 * stash->itw;
 		q->t0 = y0 * stash->ith;
@@ -1158,20 +1837,17 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 		q->t1 = y1 * stash->ith;
 	}
 
-	*x += (int)(glyph->xadv / 10.0f + 0.5f);
+	*x += (int)(glyph->xadv / 10.0f * gscale + 0.5f);
 }
 
 static void fons__flush(FONScontext* stash)
 {
+	int dirty[4];
+
 	// Flush texture
-	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
+	while (fonsValidateTexture(stash, dirty)) {
 		if (stash->params.renderUpdate != NULL)
-			stash->params.renderUpdate(stash->params.userPtr, stash->dirtyRect, stash->texData);
-		// Reset dirty rect
-		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
-		stash->dirtyRect[2] = 0;
-		stash->dirtyRect[3] = 0;
+			stash->params.renderUpdate(stash->params.userPtr, dirty, stash->texData);
 	}
 
 	// Flush triangles
@@ -1262,7 +1938,7 @@ float fonsDrawText(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
 
 			if (stash->nverts+6 > FONS_VERTEX_COUNT)
 				fons__flush(stash);
@@ -1345,7 +2021,7 @@ int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
 		iter->y = iter->nexty;
 		glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur);
 		if (glyph != NULL)
-			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->isize, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
 		iter->prevGlyphIndex = glyph != NULL ? glyph->index : -1;
 		break;
 	}
@@ -1356,7 +2032,7 @@ int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
 
 void fonsDrawDebug(FONScontext* stash, float x, float y)
 {
-	int i;
+	int i, j;
 	int w = stash->params.width;
 	int h = stash->params.height;
 	float u = w == 0 ? 0 : (1.0f / w);
@@ -1384,19 +2060,23 @@ void fonsDrawDebug(FONScontext* stash, float x, float y)
 	fons__vertex(stash, x+w, y+h, 1, 1, 0xffffffff);
 
 	// Drawbug draw atlas
-	for (i = 0; i < stash->atlas->nnodes; i++) {
-		FONSatlasNode* n = &stash->atlas->nodes[i];
+	for (j = 0; j < stash->pageCols * stash->pageRows; j++) {
+		FONSpage* page = &stash->pages[j];
+		for (i = 0; i < page->atlas->nnodes; i++) {
+			FONSatlasNode* n = &page->atlas->nodes[i];
+			float nx = x + page->x + n->x, ny = y + page->y + n->y;
 
-		if (stash->nverts+6 > FONS_VERTEX_COUNT)
-			fons__flush(stash);
+			if (stash->nverts+6 > FONS_VERTEX_COUNT)
+				fons__flush(stash);
 
-		fons__vertex(stash, x+n->x+0, y+n->y+0, u, v, 0xc00000ff);
-		fons__vertex(stash, x+n->x+n->width, y+n->y+1, u, v, 0xc00000ff);
-		fons__vertex(stash, x+n->x+n->width, y+n->y+0, u, v, 0xc00000ff);
+			fons__vertex(stash, nx+0, ny+0, u, v, 0xc00000ff);
+			fons__vertex(stash, nx+n->width, ny+1, u, v, 0xc00000ff);
+			fons__vertex(stash, nx+n->width, ny+0, u, v, 0xc00000ff);
 
-		fons__vertex(stash, x+n->x+0, y+n->y+0, u, v, 0xc00000ff);
-		fons__vertex(stash, x+n->x+0, y+n->y+1, u, v, 0xc00000ff);
-		fons__vertex(stash, x+n->x+n->width, y+n->y+1, u, v, 0xc00000ff);
+			fons__vertex(stash, nx+0, ny+0, u, v, 0xc00000ff);
+			fons__vertex(stash, nx+0, ny+1, u, v, 0xc00000ff);
+			fons__vertex(stash, nx+n->width, ny+1, u, v, 0xc00000ff);
+		}
 	}
 
 	fons__flush(stash);
@@ -1442,7 +2122,7 @@ float fonsTextBounds(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
 			if (q.x0 < minx) minx = q.x0;
 			if (q.x1 > maxx) maxx = q.x1;
 			if (stash->params.flags & FONS_ZERO_TOPLEFT) {
@@ -1534,36 +2214,108 @@ const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* hei
 
 int fonsValidateTexture(FONScontext* stash, int* dirty)
 {
-	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
-		dirty[0] = stash->dirtyRect[0];
-		dirty[1] = stash->dirtyRect[1];
-		dirty[2] = stash->dirtyRect[2];
-		dirty[3] = stash->dirtyRect[3];
-		// Reset dirty rect
-		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
-		stash->dirtyRect[2] = 0;
-		stash->dirtyRect[3] = 0;
-		return 1;
+	int i;
+	for (i = 0; i < stash->pageCols * stash->pageRows; i++) {
+		FONSpage* page = &stash->pages[i];
+		if (page->dirtyRect[0] < page->dirtyRect[2] && page->dirtyRect[1] < page->dirtyRect[3]) {
+			dirty[0] = page->dirtyRect[0];
+			dirty[1] = page->dirtyRect[1];
+			dirty[2] = page->dirtyRect[2];
+			dirty[3] = page->dirtyRect[3];
+			// Reset dirty rect
+			fons__resetDirty(page);
+			return 1;
+		}
 	}
 	return 0;
 }
 
+void fonsSetThreadCount(FONScontext* stash, int count)
+{
+	if (stash == NULL) return;
+#ifdef FONS_USE_FREETYPE
+	// FreeType faces can't be shared between threads
+	count = 0;
+#endif
+	count = fons__mini(fons__maxi(count, 0), FONS_MAX_THREADS);
+	if (count == stash->nworkers)
+		return;
+
+	fons__stopWorkers(stash);
+	fons__startWorkers(stash, count);
+}
+
+int fonsUpdateAsync(FONScontext* stash)
+{
+	int i, y, n = 0;
+	if (stash == NULL) return 0;
+
+	fons__lock(&stash->mutex);
+	for (i = 0; i < stash->finished.njobs; i++) {
+		FONSjob* job = &stash->finished.jobs[i];
+		if (job->generation == stash->generation &&
+			job->pageGeneration == fons__pageAt(stash, job->x, job->y)->generation) {
+			for (y = 0; y < job->height; y++)
+				memcpy(&stash->texData[job->x + (job->y + y) * stash->params.width], &job->bitmap[y * job->width], job->width);
+
+			fons__markDirty(stash, job->x, job->y, job->x + job->width, job->y + job->height);
+			n++;
+		}
+		free(job->bitmap);
+	}
+	stash->finished.njobs = 0;
+	fons__unlock(&stash->mutex);
+
+	return n;
+}
+
+void fonsPrefetchGlyphs(FONScontext* stash, unsigned int first, unsigned int last)
+{
+	FONSstate* state;
+	FONSfont* font;
+	unsigned int codepoint;
+	short isize, iblur;
+
+	if (stash == NULL) return;
+	state = fons__getState(stash);
+	if (state->font < 0 || state->font >= stash->nfonts) return;
+	font = stash->fonts[state->font];
+
+	isize = (short)(state->size*10.0f);
+	iblur = (short)state->blur;
+	if (!fons__glyphKey(stash, &isize, &iblur)) return;
+
+	// Stops when the atlas is full, prefetching isn't worth resetting it
+	for (codepoint = first; codepoint <= last && codepoint >= first; codepoint++) {
+		if (fons__findGlyph(font, codepoint, isize, iblur) == NULL &&
+			fons__addGlyph(stash, font, codepoint, isize, iblur, 0) == NULL)
+			break;
+	}
+}
+
 void fonsDeleteInternal(FONScontext* stash)
 {
 	int i;
 	if (stash == NULL) return;
 
+	fons__stopWorkers(stash);
+	fons__mutexDestroy(&stash->mutex);
+	fons__condDestroy(&stash->jobCond);
+	free(stash->queued.jobs);
+	for (i = 0; i < stash->finished.njobs; i++)
+		free(stash->finished.jobs[i].bitmap);
+	free(stash->finished.jobs);
+
 	if (stash->params.renderDelete)
 		stash->params.renderDelete(stash->params.userPtr);
 
 	for (i = 0; i < stash->nfonts; ++i)
 		fons__freeFont(stash->fonts[i]);
 
-	if (stash->atlas) fons__deleteAtlas(stash->atlas);
+	fons__freePages(stash);
 	if (stash->fonts) free(stash->fonts);
 	if (stash->texData) free(stash->texData);
-	if (stash->scratch) free(stash->scratch);
+	if (stash->scratch.data) free(stash->scratch.data);
 	free(stash);
 }
 
@@ -1583,7 +2335,7 @@ void fonsGetAtlasSize(FONScontext* stash, int* width, int* height)
 
 int fonsExpandAtlas(FONScontext* stash, int width, int height)
 {
-	int i, maxy = 0;
+	int i, j, maxy = 0;
 	unsigned char* data = NULL;
 	if (stash == NULL) return 0;
 
@@ -1615,19 +2367,23 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 	if (height > stash->params.height)
 		memset(&data[stash->params.height * width], 0, (height - stash->params.height) * width);
 
+	// Increase atlas size
+	if (!fons__layoutPages(stash, width, height)) {
+		free(data);
+		return 0;
+	}
+
 	free(stash->texData);
 	stash->texData = data;
 
-	// Increase atlas size
-	fons__atlasExpand(stash->atlas, width, height);
-
-	// Add existing data as dirty.
-	for (i = 0; i < stash->atlas->nnodes; i++)
-		maxy = fons__maxi(maxy, stash->atlas->nodes[i].y);
-	stash->dirtyRect[0] = 0;
-	stash->dirtyRect[1] = 0;
-	stash->dirtyRect[2] = stash->params.width;
-	stash->dirtyRect[3] = maxy;
+	// Add existing data as dirty, new pages are empty.
+	for (i = 0; i < stash->pageCols * stash->pageRows; i++) {
+		FONSpage* page = &stash->pages[i];
+		for (j = 0, maxy = 0; j < page->atlas->nnodes; j++)
+			maxy = fons__maxi(maxy, page->atlas->nodes[j].y);
+		if (maxy > 0)
+			fons__markDirty(stash, page->x, page->y, page->x + page->atlas->width, page->y + maxy);
+	}
 
 	stash->params.width = width;
 	stash->params.height = height;
@@ -1639,7 +2395,7 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 
 int fonsResetAtlas(FONScontext* stash, int width, int height)
 {
-	int i, j;
+	int i;
 	if (stash == NULL) return 0;
 
 	// Flush pending glyphs.
@@ -1652,25 +2408,25 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	}
 
 	// Reset atlas
-	fons__atlasReset(stash->atlas, width, height);
+	fons__freePages(stash);
+	if (!fons__layoutPages(stash, width, height)) return 0;
+
+	// Glyphs still being rasterized belong to the old atlas
+	fons__lock(&stash->mutex);
+	stash->generation++;
+	stash->nextJob = stash->queued.njobs = 0;
+	fons__unlock(&stash->mutex);
 
 	// Clear texture data.
 	stash->texData = (unsigned char*)realloc(stash->texData, width * height);
 	if (stash->texData == NULL) return 0;
 	memset(stash->texData, 0, width * height);
 
-	// Reset dirty rect
-	stash->dirtyRect[0] = width;
-	stash->dirtyRect[1] = height;
-	stash->dirtyRect[2] = 0;
-	stash->dirtyRect[3] = 0;
-
 	// Reset cached glyphs
 	for (i = 0; i < stash->nfonts; i++) {
 		FONSfont* font = stash->fonts[i];
 		font->nglyphs = 0;
-		for (j = 0; j < FONS_HASH_LUT_SIZE; j++)
-			font->lut[j] = -1;
+		fons__rebuildGlyphLookup(font);
 	}
 
 	stash->params.width = width;
@@ -1684,5 +2440,267 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	return 1;
 }
 
+void fonsBeginFrame(FONScontext* stash)
+{
+	if (stash == NULL) return;
+	stash->frame++;
+}
+
+void fonsTouchAtlas(FONScontext* stash, float s0, float t0, float s1, float t1)
+{
+	int x0, y0, x1, y1, x, y;
+	if (stash == NULL) return;
+	x0 = fons__maxi(0, (int)(s0 * stash->params.width)) / FONS_ATLAS_PAGE_SIZE;
+	y0 = fons__maxi(0, (int)(t0 * stash->params.height)) / FONS_ATLAS_PAGE_SIZE;
+	x1 = fons__mini(stash->pageCols-1, (int)(s1 * stash->params.width) / FONS_ATLAS_PAGE_SIZE);
+	y1 = fons__mini(stash->pageRows-1, (int)(t1 * stash->params.height) / FONS_ATLAS_PAGE_SIZE);
+	for (y = y0; y <= y1; y++)
+		for (x = x0; x <= x1; x++)
+			stash->pages[y * stash->pageCols + x].lastUse = stash->frame;
+}
+
+int fonsEvictAtlasPage(FONScontext* stash)
+{
+	int i, j, k, idx = -1;
+	FONSpage* page;
+	if (stash == NULL) return 0;
+
+	// Least recently used page that wasn't used in this frame.
+	for (i = 0; i < stash->pageCols * stash->pageRows; i++) {
+		if (stash->pages[i].lastUse >= stash->frame) continue;
+		if (idx == -1 || stash->pages[i].lastUse < stash->pages[idx].lastUse)
+			idx = i;
+	}
+	if (idx == -1) return 0;
+	page = &stash->pages[idx];
+
+	fons__flush(stash);
+
+	// Drop the page's glyphs and index the rest again.
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0, k = 0; j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (fons__pageAt(stash, glyph->x0, glyph->y0) == page) continue;
+			font->glyphs[k++] = *glyph;
+		}
+		font->nglyphs = k;
+		fons__rebuildGlyphLookup(font);
+	}
+
+	// Clear the page, glyphs still being rasterized for it are dropped.
+	fons__lock(&stash->mutex);
+	page->generation++;
+	fons__unlock(&stash->mutex);
+	fons__atlasReset(page->atlas, page->atlas->width, page->atlas->height);
+	for (i = 0; i < page->atlas->height; i++)
+		memset(&stash->texData[(page->y + i) * stash->params.width + page->x], 0, page->atlas->width);
+	fons__markDirty(stash, page->x, page->y, page->x + page->atlas->width, page->y + page->atlas->height);
+	page->lastUse = stash->frame;
+	stash->curPage = idx;
+
+	if (idx == 0)
+		fons__addWhiteRect(stash, 2,2);
+
+	return 1;
+}
+
+// FNV-1a
+static unsigned int fons__fontHash(FONSfont* font)
+{
+	int i;
+	unsigned int h = 2166136261u;
+	if (font->hash != 0) return font->hash;
+	for (i = 0; i < font->dataSize; i++)
+		h = (h ^ font->data[i]) * 16777619u;
+	font->hash = h != 0 ? h : 1;
+	return font->hash;
+}
+
+static void fons__cacheHeader(FONScontext* stash, FONScacheHeader* header)
+{
+	memset(header, 0, sizeof(FONScacheHeader));
+	header->magic = FONS_CACHE_MAGIC;
+	header->version = FONS_CACHE_VERSION;
+	// Bitmaps of the backends differ
+#ifdef FONS_USE_FREETYPE
+	header->flags = 0x100;
+#endif
+	header->flags |= stash->params.flags & FONS_SDF;
+	header->pageSize = FONS_ATLAS_PAGE_SIZE;
+	header->sdfSize = FONS_SDF_SIZE;
+	header->sdfPad = FONS_SDF_PAD;
+	header->width = stash->params.width;
+	header->height = stash->params.height;
+	header->nfonts = stash->nfonts;
+}
+
+// Moves past 'size' bytes, copying them to 'dst' if not NULL. Returns 0 if the data ends before.
+static int fons__cacheRead(const unsigned char** p, const unsigned char* end, void* dst, int size)
+{
+	if (size < 0 || end - *p < size) return 0;
+	if (dst != NULL) memcpy(dst, *p, size);
+	*p += size;
+	return 1;
+}
+
+int fonsSaveCache(FONScontext* stash, const char* path)
+{
+	FONScacheHeader header;
+	FONScacheFont cfont;
+	FONScacheGlyph cglyph;
+	FILE* fp;
+	int i, j, nworkers, ok;
+	if (stash == NULL) return 0;
+
+	// Glyphs still being rasterized would be saved blank.
+	nworkers = stash->nworkers;
+	fons__stopWorkers(stash);
+	fons__startWorkers(stash, nworkers);
+	fonsUpdateAsync(stash);
+
+	fp = fopen(path, "wb");
+	if (fp == NULL) return 0;
+
+	fons__cacheHeader(stash, &header);
+	ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+	for (i = 0; ok && i < stash->pageCols * stash->pageRows; i++) {
+		FONSatlas* atlas = stash->pages[i].atlas;
+		ok = fwrite(&atlas->nnodes, sizeof(int), 1, fp) == 1 &&
+			fwrite(atlas->nodes, sizeof(FONSatlasNode), atlas->nnodes, fp) == (size_t)atlas->nnodes;
+	}
+
+	for (i = 0; ok && i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		cfont.hash = fons__fontHash(font);
+		cfont.dataSize = font->dataSize;
+		cfont.nglyphs = font->nglyphs;
+		ok = fwrite(&cfont, sizeof(cfont), 1, fp) == 1;
+		for (j = 0; ok && j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			memset(&cglyph, 0, sizeof(cglyph));
+			cglyph.codepoint = glyph->codepoint;
+			cglyph.index = glyph->index;
+			cglyph.size = glyph->size;
+			cglyph.blur = glyph->blur;
+			cglyph.x0 = glyph->x0;
+			cglyph.y0 = glyph->y0;
+			cglyph.x1 = glyph->x1;
+			cglyph.y1 = glyph->y1;
+			cglyph.xadv = glyph->xadv;
+			cglyph.xoff = glyph->xoff;
+			cglyph.yoff = glyph->yoff;
+			ok = fwrite(&cglyph, sizeof(cglyph), 1, fp) == 1;
+		}
+	}
+
+	if (ok)
+		ok = fwrite(stash->texData, stash->params.width, stash->params.height, fp) == (size_t)stash->params.height;
+
+	if (fclose(fp) != 0) ok = 0;
+	return ok;
+}
+
+int fonsLoadCache(FONScontext* stash, const unsigned char* data, int ndata)
+{
+	FONScacheHeader header, expected;
+	FONScacheFont cfont;
+	FONScacheGlyph cglyph;
+	FONSatlasNode node;
+	const unsigned char* end = data + ndata;
+	const unsigned char* p = data;
+	const unsigned char* pages;
+	const unsigned char* fonts;
+	int i, j, nnodes, npages;
+	if (stash == NULL || data == NULL) return 0;
+
+	// Check the whole file before anything is changed.
+	if (!fons__cacheRead(&p, end, &header, sizeof(header))) return 0;
+	fons__cacheHeader(stash, &expected);
+	if (header.magic != expected.magic || header.version != expected.version || header.flags != expected.flags ||
+		header.pageSize != expected.pageSize || header.sdfSize != expected.sdfSize || header.sdfPad != expected.sdfPad)
+		return 0;
+	if (header.width <= 0 || header.height <= 0 || header.width > 0x7fff || header.height > 0x7fff || header.nfonts < 0)
+		return 0;
+
+	npages = ((header.width + FONS_ATLAS_PAGE_SIZE-1) / FONS_ATLAS_PAGE_SIZE) *
+		((header.height + FONS_ATLAS_PAGE_SIZE-1) / FONS_ATLAS_PAGE_SIZE);
+	pages = p;
+	for (i = 0; i < npages; i++) {
+		if (!fons__cacheRead(&p, end, &nnodes, sizeof(int)) || nnodes < 1 || nnodes > FONS_ATLAS_PAGE_SIZE+1 ||
+			!fons__cacheRead(&p, end, NULL, nnodes * (int)sizeof(FONSatlasNode)))
+			return 0;
+	}
+	fonts = p;
+	for (i = 0; i < header.nfonts; i++) {
+		if (!fons__cacheRead(&p, end, &cfont, sizeof(cfont)) || cfont.nglyphs < 0 ||
+			cfont.nglyphs > (int)((end - p) / sizeof(FONScacheGlyph)) ||
+			!fons__cacheRead(&p, end, NULL, cfont.nglyphs * (int)sizeof(FONScacheGlyph)))
+			return 0;
+	}
+	if (end - p != header.width * header.height)
+		return 0;
+
+	if (!fonsResetAtlas(stash, header.width, header.height))
+		return 0;
+	memcpy(stash->texData, p, header.width * header.height);
+
+	// Skylines continue packing where the saved atlas ended.
+	p = pages;
+	for (i = 0; i < npages; i++) {
+		FONSpage* page = &stash->pages[i];
+		FONSatlas* atlas = page->atlas;
+		fons__cacheRead(&p, end, &nnodes, sizeof(int));
+		atlas->nnodes = 0;
+		for (j = 0; j < nnodes; j++) {
+			fons__cacheRead(&p, end, &node, sizeof(node));
+			if (node.x < 0 || node.y < 0 || node.width < 0 || node.x + node.width > atlas->width || node.y > atlas->height ||
+				!fons__atlasInsertNode(atlas, atlas->nnodes, node.x, node.y, node.width)) {
+				fonsResetAtlas(stash, header.width, header.height);
+				return 0;
+			}
+		}
+		fons__markDirty(stash, page->x, page->y, page->x + atlas->width, page->y + atlas->height);
+	}
+
+	// Glyphs of fonts that aren't loaded keep their space until their page is evicted.
+	p = fonts;
+	for (i = 0; i < header.nfonts; i++) {
+		FONSfont* font = NULL;
+		fons__cacheRead(&p, end, &cfont, sizeof(cfont));
+		for (j = 0; j < stash->nfonts && font == NULL; j++) {
+			if (stash->fonts[j]->dataSize == cfont.dataSize && fons__fontHash(stash->fonts[j]) == cfont.hash)
+				font = stash->fonts[j];
+		}
+		for (j = 0; j < cfont.nglyphs; j++) {
+			FONSglyph* glyph;
+			fons__cacheRead(&p, end, &cglyph, sizeof(cglyph));
+			if (font == NULL || cglyph.x0 < 0 || cglyph.y0 < 0 || cglyph.x1 < cglyph.x0 || cglyph.y1 < cglyph.y0 ||
+				cglyph.x1 > header.width || cglyph.y1 > header.height)
+				continue;
+			glyph = fons__allocGlyph(font);
+			if (glyph == NULL) break;
+			glyph->codepoint = cglyph.codepoint;
+			glyph->index = cglyph.index;
+			glyph->size = cglyph.size;
+			glyph->blur = cglyph.blur;
+			glyph->x0 = cglyph.x0;
+			glyph->y0 = cglyph.y0;
+			glyph->x1 = cglyph.x1;
+			glyph->y1 = cglyph.y1;
+			glyph->xadv = cglyph.xadv;
+			glyph->xoff = cglyph.xoff;
+			glyph->yoff = cglyph.yoff;
+			if (!fons__insertGlyph(font)) {
+				font->nglyphs--;
+				break;
+			}
+		}
+	}
+
+	return 1;
+}
+
 
 #endif
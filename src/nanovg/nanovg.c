@@ -65,6 +65,8 @@ enum NVGpointFlags
 struct NVGstate {
 	NVGpaint fill;
 	NVGpaint stroke;
+	int fillTransformed;
+	int strokeTransformed;
 	float strokeWidth;
 	float miterLimit;
 	int lineJoin;
@@ -72,6 +74,7 @@ struct NVGstate {
 	float alpha;
 	float xform[6];
 	NVGscissor scissor;
+	int scissorChanged;
 	float fontSize;
 	float letterSpacing;
 	float lineHeight;
@@ -104,6 +107,64 @@ struct NVGpathCache {
 };
 typedef struct NVGpathCache NVGpathCache;
 
+enum NVGrecordCallType {
+	NVG_RECORD_FILL = 0,
+	NVG_RECORD_STROKE,
+	NVG_RECORD_TRIANGLES,
+};
+
+struct NVGrecordPath {
+	int fill;
+	int nfill;
+	int stroke;
+	int nstroke;
+	unsigned char closed;
+	int nbevel;
+	int winding;
+	int convex;
+};
+typedef struct NVGrecordPath NVGrecordPath;
+
+struct NVGrecordCall {
+	int type;
+	NVGpaint paint;
+	int paintTransformed;
+	NVGscissor scissor;
+	int ownScissor;
+	float fringe;
+	float strokeWidth;
+	float bounds[4];
+	int path;
+	int npaths;
+	int vert;
+	int nverts;
+};
+typedef struct NVGrecordCall NVGrecordCall;
+
+struct NVGrecording {
+	NVGrecordCall* calls;
+	int ncalls;
+	int ccalls;
+	NVGrecordPath* paths;
+	int npaths;
+	int cpaths;
+	NVGvertex* verts;
+	int nverts;
+	int cverts;
+	NVGpath* tempPaths;
+	int ctempPaths;
+	NVGvertex* tempVerts;
+	int ctempVerts;
+	float xform[6];
+	NVGscissor scissor;
+	float alpha;
+	float devicePxRatio;
+	int fontAtlasGeneration;
+	int hasOwnScissor;
+	int hasText;
+	int valid;
+};
+
 struct NVGcontext {
 	NVGparams params;
 	float* commands;
@@ -124,6 +185,13 @@ struct NVGcontext {
 	int fillTriCount;
 	int strokeTriCount;
 	int textTriCount;
+	int callCount;
+	int pathCount;
+	int vertexCount;
+	int textureUploadCount;
+	int fontAtlasGeneration;
+	int fontAsyncGeneration;
+	NVGrecording* recording;
 };
 
 static float nvg__sqrtf(float a) { return sqrtf(a); }
@@ -228,10 +296,14 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	if (ctx->params.renderCreate(ctx->params.userPtr) == 0) goto error;
 
 	// Init font rendering
+#ifdef FONS_USE_FREETYPE
+	// Distance fields are made from stb_truetype outlines
+	ctx->params.sdfText = 0;
+#endif
 	memset(&fontParams, 0, sizeof(fontParams));
 	fontParams.width = NVG_INIT_FONTIMAGE_SIZE;
 	fontParams.height = NVG_INIT_FONTIMAGE_SIZE;
-	fontParams.flags = FONS_ZERO_TOPLEFT;
+	fontParams.flags = FONS_ZERO_TOPLEFT | (ctx->params.sdfText ? FONS_SDF : 0);
 	fontParams.renderCreate = NULL;
 	fontParams.renderUpdate = NULL;
 	fontParams.renderDraw = NULL;
@@ -241,7 +313,7 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	if (ctx->fs == NULL) goto error;
 
 	// Create font texture
-	ctx->fontImages[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, 0, NULL);
+	ctx->fontImages[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, ctx->params.sdfText ? NVG_IMAGE_SDF : 0, NULL);
 	if (ctx->fontImages[0] == 0) goto error;
 	ctx->fontImageIdx = 0;
 
@@ -280,6 +352,8 @@ void nvgDeleteInternal(NVGcontext* ctx)
 	free(ctx);
 }
 
+static void nvg__flushTextTexture(NVGcontext* ctx);
+
 void nvgBeginFrame(NVGcontext* ctx, int windowWidth, int windowHeight, float devicePixelRatio)
 {
 /*	printf("Tris: draws:%d  fill:%d  stroke:%d  text:%d  TOT:%d\n",
@@ -298,6 +372,28 @@ void nvgBeginFrame(NVGcontext* ctx, int windowWidth, int windowHeight, float dev
 	ctx->fillTriCount = 0;
 	ctx->strokeTriCount = 0;
 	ctx->textTriCount = 0;
+	ctx->callCount = 0;
+	ctx->pathCount = 0;
+	ctx->vertexCount = 0;
+	ctx->textureUploadCount = 0;
+
+	fonsBeginFrame(ctx->fs);
+
+	// Glyphs rasterized in the background since the last frame are uploaded together
+	if (fonsUpdateAsync(ctx->fs) > 0) {
+		nvg__flushTextTexture(ctx);
+		ctx->fontAsyncGeneration++;
+	}
+}
+
+void nvgFrameStats(NVGcontext* ctx, NVGframeStats* stats)
+{
+	stats->drawCalls = ctx->drawCallCount;
+	stats->renderCalls = ctx->callCount;
+	stats->paths = ctx->pathCount;
+	stats->vertices = ctx->vertexCount;
+	stats->triangles = ctx->fillTriCount + ctx->strokeTriCount + ctx->textTriCount;
+	stats->textureUploads = ctx->textureUploadCount;
 }
 
 void nvgCancelFrame(NVGcontext* ctx)
@@ -681,12 +777,14 @@ void nvgStrokeColor(NVGcontext* ctx, NVGcolor color)
 {
 	NVGstate* state = nvg__getState(ctx);
 	nvg__setPaintColor(&state->stroke, color);
+	state->strokeTransformed = 0;
 }
 
 void nvgStrokePaint(NVGcontext* ctx, NVGpaint paint)
 {
 	NVGstate* state = nvg__getState(ctx);
 	state->stroke = paint;
+	state->strokeTransformed = 1;
 	nvgTransformMultiply(state->stroke.xform, state->xform);
 }
 
@@ -694,12 +792,14 @@ void nvgFillColor(NVGcontext* ctx, NVGcolor color)
 {
 	NVGstate* state = nvg__getState(ctx);
 	nvg__setPaintColor(&state->fill, color);
+	state->fillTransformed = 0;
 }
 
 void nvgFillPaint(NVGcontext* ctx, NVGpaint paint)
 {
 	NVGstate* state = nvg__getState(ctx);
 	state->fill = paint;
+	state->fillTransformed = 1;
 	nvgTransformMultiply(state->fill.xform, state->xform);
 }
 
@@ -742,6 +842,7 @@ void nvgUpdateImage(NVGcontext* ctx, int image, const unsigned char* data)
 	int w, h;
 	ctx->params.renderGetTextureSize(ctx->params.userPtr, image, &w, &h);
 	ctx->params.renderUpdateTexture(ctx->params.userPtr, image, 0,0, w,h, data);
+	ctx->textureUploadCount++;
 }
 
 void nvgImageSize(NVGcontext* ctx, int image, int* w, int* h)
@@ -883,6 +984,7 @@ void nvgScissor(NVGcontext* ctx, float x, float y, float w, float h)
 
 	state->scissor.extent[0] = w*0.5f;
 	state->scissor.extent[1] = h*0.5f;
+	state->scissorChanged = 1;
 }
 
 static void nvg__isectRects(float* dst,
@@ -934,12 +1036,14 @@ void nvgResetScissor(NVGcontext* ctx)
 	memset(state->scissor.xform, 0, sizeof(state->scissor.xform));
 	state->scissor.extent[0] = -1.0f;
 	state->scissor.extent[1] = -1.0f;
+	state->scissorChanged = 1;
 }
 
 void nvgSetScissor(NVGcontext* ctx, const NVGscissor* scissor)
 {
 	NVGstate* state = nvg__getState(ctx);
 	memcpy(&(state->scissor), scissor, sizeof(NVGscissor));
+	state->scissorChanged = 1;
 }
 
 void nvgCurrentScissor(NVGcontext* ctx, NVGscissor* scissor)
@@ -2096,6 +2200,126 @@ void nvgDebugDumpPathCache(NVGcontext* ctx)
 	}
 }
 
+static NVGrecordCall* nvg__allocRecordCall(NVGcontext* ctx, int type, NVGpaint* paint, int paintTransformed, NVGscissor* scissor)
+{
+	NVGrecording* rec = ctx->recording;
+	NVGrecordCall* call;
+	if (rec->ncalls+1 > rec->ccalls) {
+		NVGrecordCall* calls;
+		int ccalls = rec->ncalls+1 + rec->ccalls/2;
+		calls = (NVGrecordCall*)realloc(rec->calls, sizeof(NVGrecordCall)*ccalls);
+		if (calls == NULL) return NULL;
+		rec->calls = calls;
+		rec->ccalls = ccalls;
+	}
+	call = &rec->calls[rec->ncalls++];
+	memset(call, 0, sizeof(NVGrecordCall));
+	call->type = type;
+	call->paint = *paint;
+	call->paintTransformed = paintTransformed;
+	call->scissor = *scissor;
+	// Scissor set while recording is kept even if it came out the same as the outer one, which may be larger on replay
+	call->ownScissor = nvg__getState(ctx)->scissorChanged || memcmp(scissor, &rec->scissor, sizeof(NVGscissor)) != 0;
+	rec->hasOwnScissor |= call->ownScissor;
+	return call;
+}
+
+static int nvg__allocRecordVerts(NVGrecording* rec, const NVGvertex* verts, int nverts)
+{
+	int first = rec->nverts;
+	if (rec->nverts+nverts > rec->cverts) {
+		NVGvertex* newVerts;
+		int cverts = rec->nverts+nverts + rec->cverts/2;
+		newVerts = (NVGvertex*)realloc(rec->verts, sizeof(NVGvertex)*cverts);
+		if (newVerts == NULL) return -1;
+		rec->verts = newVerts;
+		rec->cverts = cverts;
+	}
+	if (nverts > 0)
+		memcpy(&rec->verts[first], verts, sizeof(NVGvertex)*nverts);
+	rec->nverts += nverts;
+	return first;
+}
+
+static void nvg__recordPaths(NVGcontext* ctx, int type, NVGpaint* paint, int paintTransformed, NVGscissor* scissor, float fringe, float strokeWidth,
+							 const float* bounds, const NVGpath* paths, int npaths)
+{
+	NVGrecording* rec = ctx->recording;
+	NVGrecordCall* call;
+	int i;
+
+	if (!rec->valid) return;
+
+	call = nvg__allocRecordCall(ctx, type, paint, paintTransformed, scissor);
+	if (call == NULL) goto error;
+	call->fringe = fringe;
+	call->strokeWidth = strokeWidth;
+	if (bounds != NULL)
+		memcpy(call->bounds, bounds, sizeof(call->bounds));
+
+	if (rec->npaths+npaths > rec->cpaths) {
+		NVGrecordPath* newPaths;
+		int cpaths = rec->npaths+npaths + rec->cpaths/2;
+		newPaths = (NVGrecordPath*)realloc(rec->paths, sizeof(NVGrecordPath)*cpaths);
+		if (newPaths == NULL) goto error;
+		rec->paths = newPaths;
+		rec->cpaths = cpaths;
+	}
+	call->path = rec->npaths;
+	call->npaths = npaths;
+
+	for (i = 0; i < npaths; i++) {
+		const NVGpath* path = &paths[i];
+		NVGrecordPath* dst = &rec->paths[rec->npaths++];
+		dst->closed = path->closed;
+		dst->nbevel = path->nbevel;
+		dst->winding = path->winding;
+		dst->convex = path->convex;
+		dst->nfill = path->nfill;
+		dst->nstroke = path->nstroke;
+		dst->fill = nvg__allocRecordVerts(rec, path->fill, path->nfill);
+		dst->stroke = nvg__allocRecordVerts(rec, path->stroke, path->nstroke);
+		if (dst->fill < 0 || dst->stroke < 0) goto error;
+	}
+	return;
+
+error:
+	rec->valid = 0;
+}
+
+static void nvg__recordTriangles(NVGcontext* ctx, NVGpaint* paint, NVGscissor* scissor, const NVGvertex* verts, int nverts)
+{
+	NVGrecording* rec = ctx->recording;
+	NVGrecordCall* call;
+	int i;
+
+	if (!rec->valid) return;
+
+	// Text is mapped by vertex texture coordinates only
+	call = nvg__allocRecordCall(ctx, NVG_RECORD_TRIANGLES, paint, 0, scissor);
+	if (call == NULL) goto error;
+	call->nverts = nverts;
+	call->vert = nvg__allocRecordVerts(rec, verts, nverts);
+	if (call->vert < 0) goto error;
+
+	// Bounds of the texture coordinates, the atlas pages touched on replay
+	call->bounds[0] = call->bounds[1] = 1e6f;
+	call->bounds[2] = call->bounds[3] = -1e6f;
+	for (i = 0; i < nverts; i++) {
+		call->bounds[0] = nvg__minf(call->bounds[0], verts[i].u);
+		call->bounds[1] = nvg__minf(call->bounds[1], verts[i].v);
+		call->bounds[2] = nvg__maxf(call->bounds[2], verts[i].u);
+		call->bounds[3] = nvg__maxf(call->bounds[3], verts[i].v);
+	}
+
+	// Triangles are only used for text, glyphs are valid until the font atlas is reset
+	rec->hasText = 1;
+	return;
+
+error:
+	rec->valid = 0;
+}
+
 void nvgFill(NVGcontext* ctx)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -2116,13 +2340,20 @@ void nvgFill(NVGcontext* ctx)
 	ctx->params.renderFill(ctx->params.userPtr, &fillPaint, &state->scissor, ctx->fringeWidth,
 						   ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
 
+	if (ctx->recording != NULL)
+		nvg__recordPaths(ctx, NVG_RECORD_FILL, &fillPaint, state->fillTransformed, &state->scissor, ctx->fringeWidth, 0.0f,
+						 ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
+
 	// Count triangles
 	for (i = 0; i < ctx->cache->npaths; i++) {
 		path = &ctx->cache->paths[i];
 		ctx->fillTriCount += path->nfill-2;
 		ctx->fillTriCount += path->nstroke-2;
 		ctx->drawCallCount += 2;
+		ctx->vertexCount += path->nfill + path->nstroke;
 	}
+	ctx->pathCount += ctx->cache->npaths;
+	ctx->callCount++;
 }
 
 void nvgStroke(NVGcontext* ctx)
@@ -2157,12 +2388,19 @@ void nvgStroke(NVGcontext* ctx)
 	ctx->params.renderStroke(ctx->params.userPtr, &strokePaint, &state->scissor, ctx->fringeWidth,
 							 strokeWidth, ctx->cache->paths, ctx->cache->npaths);
 
+	if (ctx->recording != NULL)
+		nvg__recordPaths(ctx, NVG_RECORD_STROKE, &strokePaint, state->strokeTransformed, &state->scissor, ctx->fringeWidth, strokeWidth,
+						 NULL, ctx->cache->paths, ctx->cache->npaths);
+
 	// Count triangles
 	for (i = 0; i < ctx->cache->npaths; i++) {
 		path = &ctx->cache->paths[i];
 		ctx->strokeTriCount += path->nstroke-2;
 		ctx->drawCallCount++;
+		ctx->vertexCount += path->nstroke;
 	}
+	ctx->pathCount += ctx->cache->npaths;
+	ctx->callCount++;
 }
 
 // Add fonts
@@ -2239,7 +2477,7 @@ static void nvg__flushTextTexture(NVGcontext* ctx)
 {
 	int dirty[4];
 
-	if (fonsValidateTexture(ctx->fs, dirty)) {
+	while (fonsValidateTexture(ctx->fs, dirty)) {
 		int fontImage = ctx->fontImages[ctx->fontImageIdx];
 		// Update texture
 		if (fontImage != 0) {
@@ -2250,30 +2488,56 @@ static void nvg__flushTextTexture(NVGcontext* ctx)
 			int w = dirty[2] - dirty[0];
 			int h = dirty[3] - dirty[1];
 			ctx->params.renderUpdateTexture(ctx->params.userPtr, fontImage, x,y, w,h, data);
+			ctx->textureUploadCount++;
 		}
 	}
 }
 
-static int nvg__allocTextAtlas(NVGcontext* ctx)
+// Makes the next font image of the size current, earlier images stay valid for text drawn before
+static int nvg__nextFontImage(NVGcontext* ctx, int iw, int ih)
 {
-	int iw, ih;
-	nvg__flushTextTexture(ctx);
 	if (ctx->fontImageIdx >= NVG_MAX_FONTIMAGES-1)
 		return 0;
-	// if next fontImage already have a texture
-	if (ctx->fontImages[ctx->fontImageIdx+1] != 0)
-		nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx+1], &iw, &ih);
-	else { // calculate the new font image size and create it.
-		nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx], &iw, &ih);
+	// if next fontImage already have a texture of the size
+	if (ctx->fontImages[ctx->fontImageIdx+1] != 0) {
+		int nw, nh;
+		nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx+1], &nw, &nh);
+		if (nw != iw || nh != ih) {
+			nvgDeleteImage(ctx, ctx->fontImages[ctx->fontImageIdx+1]);
+			ctx->fontImages[ctx->fontImageIdx+1] = 0;
+		}
+	}
+	if (ctx->fontImages[ctx->fontImageIdx+1] == 0)
+		ctx->fontImages[ctx->fontImageIdx+1] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, ctx->params.sdfText ? NVG_IMAGE_SDF : 0, NULL);
+	++ctx->fontImageIdx;
+	++ctx->fontAtlasGeneration;
+	return 1;
+}
+
+static int nvg__allocTextAtlas(NVGcontext* ctx)
+{
+	int iw, ih, grow;
+	nvg__flushTextTexture(ctx);
+	nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx], &iw, &ih);
+	grow = iw < NVG_MAX_FONTIMAGE_SIZE || ih < NVG_MAX_FONTIMAGE_SIZE;
+	// A full atlas of the largest size drops the glyphs least recently drawn
+	if (!grow && fonsEvictAtlasPage(ctx->fs)) {
+		++ctx->fontAtlasGeneration;
+		return 1;
+	}
+	if (grow) {
 		if (iw > ih)
 			ih *= 2;
 		else
 			iw *= 2;
-		if (iw > NVG_MAX_FONTIMAGE_SIZE || ih > NVG_MAX_FONTIMAGE_SIZE)
-			iw = ih = NVG_MAX_FONTIMAGE_SIZE;
-		ctx->fontImages[ctx->fontImageIdx+1] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, 0, NULL);
+		iw = nvg__mini(iw, NVG_MAX_FONTIMAGE_SIZE);
+		ih = nvg__mini(ih, NVG_MAX_FONTIMAGE_SIZE);
 	}
-	++ctx->fontImageIdx;
+	if (!nvg__nextFontImage(ctx, iw, ih))
+		return 0;
+	// Growing keeps the glyphs, texture coordinates of quads made before change
+	if (grow)
+		return fonsExpandAtlas(ctx->fs, iw, ih);
 	fonsResetAtlas(ctx->fs, iw, ih);
 	return 1;
 }
@@ -2286,14 +2550,26 @@ static void nvg__renderText(NVGcontext* ctx, NVGvertex* verts, int nverts)
 	// Render triangles.
 	paint.image = ctx->fontImages[ctx->fontImageIdx];
 
+	// Distance field glyphs are cut at the width of one pixel widened by the blur, in units of the field
+	if (ctx->params.sdfText) {
+		float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+		float size = nvg__maxf(state->fontSize*scale, 1.0f);
+		paint.feather = FONS_SDF_SIZE * (1.0f + 2.0f*state->fontBlur*scale) / (2.0f * FONS_SDF_PAD * size);
+	}
+
 	// Apply global alpha
 	paint.innerColor.a *= state->alpha;
 	paint.outerColor.a *= state->alpha;
 
 	ctx->params.renderTriangles(ctx->params.userPtr, &paint, &state->scissor, verts, nverts);
 
+	if (ctx->recording != NULL)
+		nvg__recordTriangles(ctx, &paint, &state->scissor, verts, nverts);
+
 	ctx->drawCallCount++;
 	ctx->textTriCount += nverts/3;
+	ctx->vertexCount += nverts;
+	ctx->callCount++;
 }
 
 float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
@@ -2327,12 +2603,14 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
 		float c[4*2];
 		if (iter.prevGlyphIndex == -1) { // can not retrieve glyph?
-			if (!nvg__allocTextAtlas(ctx))
-				break; // no memory :(
+			// Glyphs so far are drawn from the current image before it's replaced
 			if (nverts != 0) {
+				nvg__flushTextTexture(ctx);
 				nvg__renderText(ctx, verts, nverts);
 				nverts = 0;
 			}
+			if (!nvg__allocTextAtlas(ctx))
+				break; // no memory :(
 			iter = prevIter;
 			fonsTextIterNext(ctx->fs, &iter, &q); // try again
 			if (iter.prevGlyphIndex == -1) // still can not find glyph?
@@ -2363,6 +2641,163 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 	return iter.x;
 }
 
+int nvgFontAtlasGeneration(NVGcontext* ctx)
+{
+	return ctx->fontAtlasGeneration;
+}
+
+void nvgFontThreadCount(NVGcontext* ctx, int count)
+{
+	fonsSetThreadCount(ctx->fs, count);
+}
+
+int nvgFontAsyncGeneration(NVGcontext* ctx)
+{
+	return ctx->fontAsyncGeneration;
+}
+
+int nvgSaveFontCache(NVGcontext* ctx, const char* path)
+{
+	return fonsSaveCache(ctx->fs, path);
+}
+
+int nvgLoadFontCache(NVGcontext* ctx, const unsigned char* data, int ndata)
+{
+	int iw, ih, w, h;
+	nvg__flushTextTexture(ctx);
+	if (!fonsLoadCache(ctx->fs, data, ndata))
+		return 0;
+	// Cached atlas may be larger than the font image
+	fonsGetTextureData(ctx->fs, &w, &h);
+	nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx], &iw, &ih);
+	if (iw != w || ih != h) {
+		if (!nvg__nextFontImage(ctx, w, h)) {
+			nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx], &iw, &ih);
+			fonsResetAtlas(ctx->fs, iw, ih);
+			return 0;
+		}
+	} else {
+		++ctx->fontAtlasGeneration;
+	}
+	nvg__flushTextTexture(ctx);
+	return 1;
+}
+
+void nvgPrefetchGlyphs(NVGcontext* ctx, unsigned int first, unsigned int last)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+
+	if (state->fontId == FONS_INVALID) return;
+
+	fonsSetSize(ctx->fs, state->fontSize*scale);
+	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetFont(ctx->fs, state->fontId);
+
+	fonsPrefetchGlyphs(ctx->fs, first, last);
+	nvg__flushTextTexture(ctx);
+}
+
+// Quads are computed away from the origin so that pixel snapping rounds them the same way as when drawn at any
+// positive integer position.
+#define NVG_GLYPH_QUAD_ORIGIN 4096.0f
+
+int nvgTextGlyphQuads(NVGcontext* ctx, const char* string, const char* end, NVGglyphQuad* quads, int maxQuads)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+	float invscale = 1.0f / scale;
+	float origin = NVG_GLYPH_QUAD_ORIGIN * scale;
+	FONStextIter iter, prevIter;
+	FONSquad q;
+	int nquads = 0;
+
+	if (state->fontId == FONS_INVALID) return 0;
+
+	if (end == NULL)
+		end = string + strlen(string);
+
+	if (string == end || maxQuads <= 0)
+		return 0;
+
+	fonsSetSize(ctx->fs, state->fontSize*scale);
+	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
+	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetAlign(ctx->fs, state->textAlign);
+	fonsSetFont(ctx->fs, state->fontId);
+
+	fonsTextIterInit(ctx->fs, &iter, origin, origin, string, end);
+	prevIter = iter;
+	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
+		NVGglyphQuad* quad;
+		if (iter.prevGlyphIndex == -1) { // can not retrieve glyph?
+			if (!nvg__allocTextAtlas(ctx))
+				break; // no memory :(
+			iter = prevIter;
+			fonsTextIterNext(ctx->fs, &iter, &q); // try again
+			if (iter.prevGlyphIndex == -1) // still can not find glyph?
+				break;
+		}
+		prevIter = iter;
+		quad = &quads[nquads];
+		quad->x0 = (q.x0 - origin) * invscale;
+		quad->y0 = (q.y0 - origin) * invscale;
+		quad->x1 = (q.x1 - origin) * invscale;
+		quad->y1 = (q.y1 - origin) * invscale;
+		quad->s0 = q.s0;
+		quad->t0 = q.t0;
+		quad->s1 = q.s1;
+		quad->t1 = q.t1;
+		if (++nquads >= maxQuads)
+			break;
+	}
+
+	return nquads;
+}
+
+void nvgDrawGlyphRuns(NVGcontext* ctx, const NVGglyphRun* runs, int nruns)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGvertex* verts;
+	int cverts = 0;
+	int nverts = 0;
+	int i, j;
+
+	for (i = 0; i < nruns; i++)
+		cverts += runs[i].nquads * 6;
+
+	if (cverts == 0) return;
+
+	verts = nvg__allocTempVerts(ctx, cverts);
+	if (verts == NULL) return;
+
+	for (i = 0; i < nruns; i++) {
+		const NVGglyphRun* run = &runs[i];
+		for (j = 0; j < run->nquads; j++) {
+			const NVGglyphQuad* q = &run->quads[j];
+			float c[4*2];
+			// Keeps the glyph's atlas page from being evicted this frame
+			fonsTouchAtlas(ctx->fs, q->s0, q->t0, q->s1, q->t1);
+			// Transform corners.
+			nvgTransformPoint(&c[0],&c[1], state->xform, run->x + q->x0, run->y + q->y0);
+			nvgTransformPoint(&c[2],&c[3], state->xform, run->x + q->x1, run->y + q->y0);
+			nvgTransformPoint(&c[4],&c[5], state->xform, run->x + q->x1, run->y + q->y1);
+			nvgTransformPoint(&c[6],&c[7], state->xform, run->x + q->x0, run->y + q->y1);
+			// Create triangles
+			nvg__vset(&verts[nverts], c[0], c[1], q->s0, q->t0); nverts++;
+			nvg__vset(&verts[nverts], c[4], c[5], q->s1, q->t1); nverts++;
+			nvg__vset(&verts[nverts], c[2], c[3], q->s1, q->t0); nverts++;
+			nvg__vset(&verts[nverts], c[0], c[1], q->s0, q->t0); nverts++;
+			nvg__vset(&verts[nverts], c[6], c[7], q->s0, q->t1); nverts++;
+			nvg__vset(&verts[nverts], c[4], c[5], q->s1, q->t1); nverts++;
+		}
+	}
+
+	nvg__flushTextTexture(ctx);
+
+	nvg__renderText(ctx, verts, nverts);
+}
+
 void nvgTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const char* string, const char* end)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -2761,4 +3196,193 @@ void nvgTextMetrics(NVGcontext* ctx, float* ascender, float* descender, float* l
 	if (lineh != NULL)
 		*lineh *= invscale;
 }
+NVGrecording* nvgCreateRecording(void)
+{
+	NVGrecording* rec = (NVGrecording*)malloc(sizeof(NVGrecording));
+	if (rec == NULL) return NULL;
+	memset(rec, 0, sizeof(NVGrecording));
+	return rec;
+}
+
+void nvgDeleteRecording(NVGrecording* rec)
+{
+	if (rec == NULL) return;
+	free(rec->calls);
+	free(rec->paths);
+	free(rec->verts);
+	free(rec->tempPaths);
+	free(rec->tempVerts);
+	free(rec);
+}
+
+void nvgBeginRecording(NVGcontext* ctx, NVGrecording* rec)
+{
+	NVGstate* state = nvg__getState(ctx);
+
+	rec->ncalls = 0;
+	rec->npaths = 0;
+	rec->nverts = 0;
+	memcpy(rec->xform, state->xform, sizeof(rec->xform));
+	rec->scissor = state->scissor;
+	state->scissorChanged = 0;
+	rec->alpha = state->alpha;
+	rec->devicePxRatio = ctx->devicePxRatio;
+	rec->fontAtlasGeneration = ctx->fontAtlasGeneration;
+	rec->hasOwnScissor = 0;
+	rec->hasText = 0;
+	rec->valid = 1;
+
+	ctx->recording = rec;
+}
+
+void nvgEndRecording(NVGcontext* ctx)
+{
+	NVGrecording* rec = ctx->recording;
+	if (rec == NULL) return;
+
+	// Glyphs recorded before the atlas was reset are gone
+	if (rec->hasText && rec->fontAtlasGeneration != ctx->fontAtlasGeneration)
+		rec->valid = 0;
+
+	ctx->recording = NULL;
+}
+
+static int nvg__translatedScissorEquals(const NVGscissor* a, const NVGscissor* b, float tx, float ty)
+{
+	const float tol = 0.001f;
+	int i;
+	for (i = 0; i < 4; i++)
+		if (nvg__absf(a->xform[i] - b->xform[i]) > tol) return 0;
+	if (nvg__absf(a->xform[4] - (b->xform[4] + tx)) > tol || nvg__absf(a->xform[5] - (b->xform[5] + ty)) > tol) return 0;
+	return nvg__absf(a->extent[0] - b->extent[0]) <= tol && nvg__absf(a->extent[1] - b->extent[1]) <= tol;
+}
+
+static const NVGvertex* nvg__replayVerts(NVGrecording* rec, int first, int count, int offset, float tx, float ty)
+{
+	const NVGvertex* src = &rec->verts[first];
+	NVGvertex* dst;
+	int i;
+
+	if (tx == 0.0f && ty == 0.0f)
+		return src;
+
+	dst = &rec->tempVerts[offset];
+	for (i = 0; i < count; i++) {
+		dst[i].x = src[i].x + tx;
+		dst[i].y = src[i].y + ty;
+		dst[i].u = src[i].u;
+		dst[i].v = src[i].v;
+	}
+	return dst;
+}
+
+int nvgReplayRecording(NVGcontext* ctx, NVGrecording* rec)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float tx, ty;
+	int i, j;
+
+	if (rec == NULL || !rec->valid || ctx->recording != NULL) return 0;
+
+	for (i = 0; i < 4; i++)
+		if (state->xform[i] != rec->xform[i]) return 0;
+
+	if (state->alpha != rec->alpha || ctx->devicePxRatio != rec->devicePxRatio) return 0;
+	if (rec->hasText && ctx->fontAtlasGeneration != rec->fontAtlasGeneration) return 0;
+
+	tx = state->xform[4] - rec->xform[4];
+	ty = state->xform[5] - rec->xform[5];
+
+	if (rec->hasOwnScissor && !nvg__translatedScissorEquals(&state->scissor, &rec->scissor, tx, ty)) return 0;
+
+	// Scratch space for translated geometry
+	if (tx != 0.0f || ty != 0.0f) {
+		if (rec->nverts > rec->ctempVerts) {
+			NVGvertex* verts = (NVGvertex*)realloc(rec->tempVerts, sizeof(NVGvertex)*rec->nverts);
+			if (verts == NULL) return 0;
+			rec->tempVerts = verts;
+			rec->ctempVerts = rec->nverts;
+		}
+	}
+	if (rec->npaths > rec->ctempPaths) {
+		NVGpath* paths = (NVGpath*)realloc(rec->tempPaths, sizeof(NVGpath)*rec->npaths);
+		if (paths == NULL) return 0;
+		rec->tempPaths = paths;
+		rec->ctempPaths = rec->npaths;
+	}
+
+	for (i = 0; i < rec->ncalls; i++) {
+		NVGrecordCall* call = &rec->calls[i];
+		NVGpaint paint = call->paint;
+		NVGscissor scissor = call->ownScissor ? call->scissor : state->scissor;
+		NVGpath* paths = &rec->tempPaths[call->path];
+
+		// Solid colors keep their identity transform
+		if (call->paintTransformed) {
+			paint.xform[4] += tx;
+			paint.xform[5] += ty;
+		}
+
+		if (call->ownScissor) {
+			scissor.xform[4] += tx;
+			scissor.xform[5] += ty;
+		}
+
+		if (call->type == NVG_RECORD_TRIANGLES) {
+			paint.image = ctx->fontImages[ctx->fontImageIdx];
+			fonsTouchAtlas(ctx->fs, call->bounds[0], call->bounds[1], call->bounds[2], call->bounds[3]);
+			ctx->params.renderTriangles(ctx->params.userPtr, &paint, &scissor,
+										nvg__replayVerts(rec, call->vert, call->nverts, call->vert, tx, ty), call->nverts);
+			ctx->drawCallCount++;
+			ctx->textTriCount += call->nverts/3;
+			ctx->vertexCount += call->nverts;
+			ctx->callCount++;
+			continue;
+		}
+
+		for (j = 0; j < call->npaths; j++) {
+			const NVGrecordPath* src = &rec->paths[call->path + j];
+			NVGpath* path = &paths[j];
+			memset(path, 0, sizeof(NVGpath));
+			path->closed = src->closed;
+			path->nbevel = src->nbevel;
+			path->winding = src->winding;
+			path->convex = src->convex;
+			path->nfill = src->nfill;
+			path->nstroke = src->nstroke;
+			path->fill = (NVGvertex*)nvg__replayVerts(rec, src->fill, src->nfill, src->fill, tx, ty);
+			path->stroke = (NVGvertex*)nvg__replayVerts(rec, src->stroke, src->nstroke, src->stroke, tx, ty);
+		}
+
+		if (call->type == NVG_RECORD_FILL) {
+			float bounds[4];
+			bounds[0] = call->bounds[0] + tx;
+			bounds[1] = call->bounds[1] + ty;
+			bounds[2] = call->bounds[2] + tx;
+			bounds[3] = call->bounds[3] + ty;
+			ctx->params.renderFill(ctx->params.userPtr, &paint, &scissor, call->fringe, bounds, paths, call->npaths);
+
+			for (j = 0; j < call->npaths; j++) {
+				ctx->fillTriCount += paths[j].nfill-2;
+				ctx->fillTriCount += paths[j].nstroke-2;
+				ctx->drawCallCount += 2;
+				ctx->vertexCount += paths[j].nfill + paths[j].nstroke;
+			}
+		} else {
+			ctx->params.renderStroke(ctx->params.userPtr, &paint, &scissor, call->fringe, call->strokeWidth, paths, call->npaths);
+
+			for (j = 0; j < call->npaths; j++) {
+				ctx->strokeTriCount += paths[j].nstroke-2;
+				ctx->drawCallCount++;
+				ctx->vertexCount += paths[j].nstroke;
+			}
+		}
+
+		ctx->pathCount += call->npaths;
+		ctx->callCount++;
+	}
+
+	return 1;
+}
+
 // vim: ft=c nu noet ts=4
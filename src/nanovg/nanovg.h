@@ -111,6 +111,7 @@ enum NVGimageFlags {
 	NVG_IMAGE_REPEATY			= 1<<2,		// Repeat image in Y direction.
 	NVG_IMAGE_FLIPY				= 1<<3,		// Flips (inverses) image in Y direction when rendered.
 	NVG_IMAGE_PREMULTIPLIED		= 1<<4,		// Image data has premultiplied alpha.
+	NVG_IMAGE_SDF				= 1<<5,		// Alpha image holds a signed distance field, 0.5 is the edge, paint feather is the width of the edge ramp.
 };
 
 // Begin drawing a new frame
@@ -129,6 +130,19 @@ void nvgCancelFrame(NVGcontext* ctx);
 // Ends drawing flushing remaining render state.
 void nvgEndFrame(NVGcontext* ctx);
 
+struct NVGframeStats {
+	int drawCalls;			// Estimated number of draw calls issued by the backend.
+	int renderCalls;		// Number of renderFill(), renderStroke() and renderTriangles() calls.
+	int paths;
+	int vertices;
+	int triangles;
+	int textureUploads;		// Number of renderUpdateTexture() calls, including font atlas updates.
+};
+typedef struct NVGframeStats NVGframeStats;
+
+// Returns rendering statistics of the current frame, counters are reset by nvgBeginFrame().
+void nvgFrameStats(NVGcontext* ctx, NVGframeStats* stats);
+
 //
 // Color utils
 //
@@ -559,6 +573,79 @@ void nvgTextMetrics(NVGcontext* ctx, float* ascender, float* descender, float* l
 // Words longer than the max width are slit at nearest character (i.e. no hyphenation).
 int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows);
 
+//
+// Glyph quads
+//
+// Quads of the glyphs of a text can be computed once and drawn many times without walking the font again. Quads are
+// relative to the pen position and stay valid while the font atlas generation and the font scale (scale of the
+// transform and device pixel ratio) don't change.
+
+struct NVGglyphQuad {
+	float x0, y0, x1, y1;
+	float s0, t0, s1, t1;
+};
+typedef struct NVGglyphQuad NVGglyphQuad;
+
+struct NVGglyphRun {
+	float x, y;
+	const NVGglyphQuad* quads;
+	int nquads;
+};
+typedef struct NVGglyphRun NVGglyphRun;
+
+// Returns the generation of the font atlas, it's increased whenever the atlas is reset and previous quads are lost.
+int nvgFontAtlasGeneration(NVGcontext* ctx);
+
+// Rasterizes missing glyphs on 'count' background threads, 0 rasterizes them when text is drawn (default).
+// Text drawn before its glyphs arrive has blank glyphs, they're added to the atlas at the beginning of a later frame
+// and nvgFontAsyncGeneration() is increased then so that the text can be drawn again.
+void nvgFontThreadCount(NVGcontext* ctx, int count);
+int nvgFontAsyncGeneration(NVGcontext* ctx);
+
+// Creates glyphs of the code point range with current font, size and blur ahead of use.
+void nvgPrefetchGlyphs(NVGcontext* ctx, unsigned int first, unsigned int last);
+
+// Saves the font atlas with its glyphs, returns 1 on success.
+int nvgSaveFontCache(NVGcontext* ctx, const char* path);
+// Loads a saved font atlas from memory and uploads it, its glyphs are used for the fonts already created that have
+// the same data. Returns 0 if the cache doesn't match this build or its settings.
+int nvgLoadFontCache(NVGcontext* ctx, const unsigned char* data, int ndata);
+
+// Calculates quads of the specified text as nvgText() would draw them at (0,0) using current text style.
+// Returns number of quads written, at most maxQuads.
+int nvgTextGlyphQuads(NVGcontext* ctx, const char* string, const char* end, NVGglyphQuad* quads, int maxQuads);
+
+// Draws glyph runs with the current fill in a single draw call, quads of each run are offset by its position.
+// Font size and blur should be the ones the quads were calculated with, they set the edges of distance field glyphs.
+void nvgDrawGlyphRuns(NVGcontext* ctx, const NVGglyphRun* runs, int nruns);
+
+//
+// Recording
+//
+// Draw calls issued between nvgBeginRecording() and nvgEndRecording() are rendered as usual and their
+// tessellated output is also stored in the recording. Replaying it later submits the same geometry again
+// without flattening and expanding paths or shaping text. Geometry is moved along if the translation of the
+// current transform differs from the one used while recording.
+
+typedef struct NVGrecording NVGrecording;
+
+// Creates empty recording.
+NVGrecording* nvgCreateRecording(void);
+
+// Deletes recording.
+void nvgDeleteRecording(NVGrecording* rec);
+
+// Starts storing draw calls in the specified recording, previous content is discarded.
+void nvgBeginRecording(NVGcontext* ctx, NVGrecording* rec);
+
+// Stops storing draw calls.
+void nvgEndRecording(NVGcontext* ctx);
+
+// Submits recorded draw calls. Returns 0 and draws nothing if the recording can't be reused in the current state,
+// i.e. the transform differs in more than translation, global alpha, pixel ratio or font atlas has changed,
+// recorded calls had their own scissor and the current scissor differs, or another recording is active.
+int nvgReplayRecording(NVGcontext* ctx, NVGrecording* rec);
+
 //
 // Internal Render API
 //
@@ -589,6 +676,7 @@ typedef struct NVGpath NVGpath;
 struct NVGparams {
 	void* userPtr;
 	int edgeAntiAlias;
+	int sdfText;
 	int (*renderCreate)(void* uptr);
 	int (*renderCreateTexture)(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data);
 	int (*renderDeleteTexture)(void* uptr, int image);
@@ -24,6 +24,8 @@ extern "C" {
 
 // Create flags
 
+#ifndef NANOVG_CREATE_FLAGS
+#define NANOVG_CREATE_FLAGS
 enum NVGcreateFlags {
 	// Flag indicating if geometry based anti-aliasing is used (may not be needed when using MSAA).
 	NVG_ANTIALIAS 		= 1<<0,
@@ -32,7 +34,11 @@ enum NVGcreateFlags {
 	NVG_STENCIL_STROKES	= 1<<1,
 	// Flag indicating that additional debug checks are done.
 	NVG_DEBUG 			= 1<<2,
+	// Flag indicating that glyphs are stored as signed distance fields shared by all text sizes and blurs
+	// instead of a bitmap per size. Ignored when fontstash uses FreeType.
+	NVG_SDF_TEXT		= 1<<3,
 };
+#endif
 
 #if defined NANOVG_GL2_IMPLEMENTATION
 #  define NANOVG_GL2 1
@@ -613,6 +619,7 @@ static int glnvg__renderCreate(void* uptr)
 		"#endif\n"
 		"		if (texType == 1) color = vec4(color.xyz*color.w,color.w);"
 		"		if (texType == 2) color = vec4(color.x);"
+		"		if (texType == 3) color = vec4(clamp((color.x - 0.5) / feather + 0.5, 0.0, 1.0));\n"
 		"		// Apply color tint and alpha.\n"
 		"		color *= innerCol;\n"
 		"		// Combine alpha\n"
@@ -628,6 +635,7 @@ static int glnvg__renderCreate(void* uptr)
 		"#endif\n"
 		"		if (texType == 1) color = vec4(color.xyz*color.w,color.w);"
 		"		if (texType == 2) color = vec4(color.x);"
+		"		if (texType == 3) color = vec4(clamp((color.x - 0.5) / feather + 0.5, 0.0, 1.0));\n"
 		"		color *= scissor;\n"
 		"		result = color * innerCol;\n"
 		"	}\n"
@@ -898,9 +906,14 @@ static int glnvg__convertPaint(GLNVGcontext* gl, GLNVGfragUniforms* frag, NVGpai
 
 		if (tex->type == NVG_TEXTURE_RGBA)
 			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
+		else if (tex->flags & NVG_IMAGE_SDF)
+			frag->texType = 3;
 		else
 			frag->texType = 2;
 //		printf("frag->texType = %d\n", frag->texType);
+		// Distance fields are read through the feather, without one the distance itself is shown
+		if (frag->texType == 3)
+			frag->feather = paint->feather > 0.0f ? paint->feather : 1.0f;
 	} else {
 		frag->type = NSVG_SHADER_FILLGRAD;
 		frag->radius = paint->radius;
@@ -1472,6 +1485,7 @@ NVGcontext* nvgCreateGLES3(int flags)
 	params.renderDelete = glnvg__renderDelete;
 	params.userPtr = gl;
 	params.edgeAntiAlias = flags & NVG_ANTIALIAS ? 1 : 0;
+	params.sdfText = flags & NVG_SDF_TEXT ? 1 : 0;
 
 	gl->flags = flags;
 
@@ -0,0 +1,1589 @@
+//
+// Copyright (c) 2009-2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef NANOVG_SW_H
+#define NANOVG_SW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Create flags, shared with nanovg_gl.h
+
+#ifndef NANOVG_CREATE_FLAGS
+#define NANOVG_CREATE_FLAGS
+enum NVGcreateFlags {
+	// Flag indicating if geometry based anti-aliasing is used (may not be needed when using MSAA).
+	NVG_ANTIALIAS 		= 1<<0,
+	// Flag indicating if strokes should be drawn using stencil buffer. The rendering will be a little
+	// slower, but path overlaps (i.e. self-intersecting or sharp turns) will be drawn just once.
+	NVG_STENCIL_STROKES	= 1<<1,
+	// Flag indicating that additional debug checks are done.
+	NVG_DEBUG 			= 1<<2,
+	// Flag indicating that glyphs are stored as signed distance fields shared by all text sizes and blurs
+	// instead of a bitmap per size. Ignored when fontstash uses FreeType.
+	NVG_SDF_TEXT		= 1<<3,
+};
+#endif
+
+// Creates NanoVG context rendering on CPU into a memory buffer. The triangles produced by nanovg are
+// rasterized the same way as by the GL backends, frame is split into horizontal bands rendered in parallel.
+// NVG_STENCIL_STROKES is not supported and ignored.
+NVGcontext* nvgCreateSW(int flags);
+void nvgDeleteSW(NVGcontext* ctx);
+
+// Sets the buffer following frames are rendered into. Pixels are RGBA with premultiplied alpha, rows are
+// 'stride' bytes apart. The buffer is not cleared by nanovg and has to stay valid until nvgEndFrame().
+void nvgswSetFramebuffer(NVGcontext* ctx, unsigned char* pixels, int width, int height, int stride);
+
+// Sets number of threads used to rasterize frames including the calling one, 0 uses one per CPU core.
+void nvgswSetThreadCount(NVGcontext* ctx, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOVG_SW_H */
+
+#ifdef NANOVG_SW_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "nanovg.h"
+
+#ifdef _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <unistd.h>
+#endif
+
+#if !defined(NANOVG_SW_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#  define NANOVG_SW_SSE2 1
+#  include <emmintrin.h>
+#endif
+
+#define SWNVG_BAND_HEIGHT 16
+#define SWNVG_MAX_THREADS 16
+
+// Vertices are snapped to 1/256 of a pixel, so that triangles sharing an edge never both cover a pixel
+#define SWNVG_SUBPIXEL_BITS 8
+#define SWNVG_SUBPIXEL (1 << SWNVG_SUBPIXEL_BITS)
+#define SWNVG_MAX_COORD (1 << 20)
+
+//
+// Four lanes of floats, pixels are shaded four at a time
+//
+
+#ifdef NANOVG_SW_SSE2
+
+typedef __m128 swnvg__f4;
+
+static swnvg__f4 swnvg__set1(float a) { return _mm_set1_ps(a); }
+static swnvg__f4 swnvg__ramp(float a, float step) { return _mm_add_ps(_mm_set1_ps(a), _mm_mul_ps(_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_set1_ps(step))); }
+static swnvg__f4 swnvg__load(const float* p) { return _mm_loadu_ps(p); }
+static void swnvg__store(float* p, swnvg__f4 a) { _mm_storeu_ps(p, a); }
+static swnvg__f4 swnvg__add(swnvg__f4 a, swnvg__f4 b) { return _mm_add_ps(a, b); }
+static swnvg__f4 swnvg__sub(swnvg__f4 a, swnvg__f4 b) { return _mm_sub_ps(a, b); }
+static swnvg__f4 swnvg__mul(swnvg__f4 a, swnvg__f4 b) { return _mm_mul_ps(a, b); }
+static swnvg__f4 swnvg__min(swnvg__f4 a, swnvg__f4 b) { return _mm_min_ps(a, b); }
+static swnvg__f4 swnvg__max(swnvg__f4 a, swnvg__f4 b) { return _mm_max_ps(a, b); }
+static swnvg__f4 swnvg__sqrt(swnvg__f4 a) { return _mm_sqrt_ps(a); }
+static swnvg__f4 swnvg__abs(swnvg__f4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static int swnvg__all(swnvg__f4 a, int n) { int mask = (1 << n) - 1; return (_mm_movemask_ps(_mm_cmpeq_ps(a, _mm_set1_ps(1.0f))) & mask) == mask; }
+
+#else
+
+typedef struct swnvg__f4 { float v[4]; } swnvg__f4;
+
+static swnvg__f4 swnvg__set1(float a) { swnvg__f4 r; int i; for (i = 0; i < 4; i++) r.v[i] = a; return r; }
+static swnvg__f4 swnvg__ramp(float a, float step) { swnvg__f4 r; int i; for (i = 0; i < 4; i++) r.v[i] = a + step*i; return r; }
+static swnvg__f4 swnvg__load(const float* p) { swnvg__f4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+static void swnvg__store(float* p, swnvg__f4 a) { memcpy(p, a.v, sizeof(a.v)); }
+static swnvg__f4 swnvg__add(swnvg__f4 a, swnvg__f4 b) { int i; for (i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+static swnvg__f4 swnvg__sub(swnvg__f4 a, swnvg__f4 b) { int i; for (i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+static swnvg__f4 swnvg__mul(swnvg__f4 a, swnvg__f4 b) { int i; for (i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+static swnvg__f4 swnvg__min(swnvg__f4 a, swnvg__f4 b) { int i; for (i = 0; i < 4; i++) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return a; }
+static swnvg__f4 swnvg__max(swnvg__f4 a, swnvg__f4 b) { int i; for (i = 0; i < 4; i++) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+static swnvg__f4 swnvg__sqrt(swnvg__f4 a) { int i; for (i = 0; i < 4; i++) a.v[i] = sqrtf(a.v[i]); return a; }
+static swnvg__f4 swnvg__abs(swnvg__f4 a) { int i; for (i = 0; i < 4; i++) a.v[i] = fabsf(a.v[i]); return a; }
+static int swnvg__all(swnvg__f4 a, int n) { int i; for (i = 0; i < n; i++) if (a.v[i] != 1.0f) return 0; return 1; }
+
+#endif
+
+static swnvg__f4 swnvg__clamp01(swnvg__f4 a) { return swnvg__min(swnvg__max(a, swnvg__set1(0.0f)), swnvg__set1(1.0f)); }
+static swnvg__f4 swnvg__madd(swnvg__f4 a, swnvg__f4 b, swnvg__f4 c) { return swnvg__add(swnvg__mul(a, b), c); }
+
+//
+// Threads
+//
+
+#ifdef _WIN32
+typedef HANDLE SWNVGthread;
+typedef CRITICAL_SECTION SWNVGmutex;
+typedef CONDITION_VARIABLE SWNVGcond;
+#else
+typedef pthread_t SWNVGthread;
+typedef pthread_mutex_t SWNVGmutex;
+typedef pthread_cond_t SWNVGcond;
+#endif
+
+enum SWNVGshaderType {
+	SWNVG_SHADER_FILLGRAD,
+	SWNVG_SHADER_FILLIMG,
+	SWNVG_SHADER_SIMPLE,
+	SWNVG_SHADER_IMG
+};
+
+enum SWNVGrasterMode {
+	SWNVG_RASTER_SHADE,			// Blend into framebuffer
+	SWNVG_RASTER_STENCIL,		// Add triangle's winding to the stencil buffer
+	SWNVG_RASTER_SHADE_OUTSIDE,	// Blend into framebuffer where stencil is zero
+};
+
+struct SWNVGtexture {
+	int id;
+	unsigned char* data;
+	int width, height;
+	int type;
+	int flags;
+};
+typedef struct SWNVGtexture SWNVGtexture;
+
+enum SWNVGcallType {
+	SWNVG_NONE = 0,
+	SWNVG_FILL,
+	SWNVG_CONVEXFILL,
+	SWNVG_STROKE,
+	SWNVG_TRIANGLES,
+};
+
+struct SWNVGcall {
+	int type;
+	int image;
+	int pathOffset;
+	int pathCount;
+	int triangleOffset;
+	int triangleCount;
+	int uniformOffset;
+	float scissorBounds[4];		// View space bounds of the scissor
+	int bounds[4];				// Pixels possibly covered by the call, [x0,y0,x1,y1), set by flush
+};
+typedef struct SWNVGcall SWNVGcall;
+
+struct SWNVGpath {
+	int fillOffset;
+	int fillCount;
+	int strokeOffset;
+	int strokeCount;
+	int rows[2];		// Pixel rows possibly covered by the path, [y0,y1), set by flush
+};
+typedef struct SWNVGpath SWNVGpath;
+
+struct SWNVGfragUniforms {
+	float scissorMat[6];
+	float paintMat[6];
+	float innerCol[4];
+	float outerCol[4];
+	float scissorExt[2];
+	float scissorScale[2];
+	float extent[2];
+	float radius;
+	float feather;
+	float strokeMult;
+	int texType;
+	int type;
+	int scissored;
+	int solid;
+	int linear;
+	int opaque;
+	unsigned int opaqueColor;	// RGBA bytes of an opaque solid color
+	float scissorInner[4];		// View space rectangle fully inside of an axis aligned scissor
+	int scissorPixels[4];		// Pixels fully inside of the scissor, set by flush
+	const SWNVGtexture* tex;
+};
+typedef struct SWNVGfragUniforms SWNVGfragUniforms;
+
+struct SWNVGcontext;
+
+struct SWNVGworker {
+	struct SWNVGcontext* sw;
+	SWNVGthread thread;
+	unsigned char* stencil;
+	int stencilSize;
+};
+typedef struct SWNVGworker SWNVGworker;
+
+struct SWNVGband {
+	int y0, y1;
+	unsigned char* stencil;
+};
+typedef struct SWNVGband SWNVGband;
+
+struct SWNVGcontext {
+	SWNVGtexture* textures;
+	float view[2];
+	int ntextures;
+	int ctextures;
+	int textureId;
+	int flags;
+
+	// Target buffer
+	unsigned char* pixels;
+	int width;
+	int height;
+	int stride;
+	float scale[2];		// View to pixels
+	float invScale[2];
+
+	// Per frame buffers
+	SWNVGcall* calls;
+	int ccalls;
+	int ncalls;
+	SWNVGpath* paths;
+	int cpaths;
+	int npaths;
+	struct NVGvertex* verts;
+	int cverts;
+	int nverts;
+	SWNVGfragUniforms* uniforms;
+	int cuniforms;
+	int nuniforms;
+
+	// Workers, the first one is the thread calling nvgEndFrame()
+	SWNVGworker workers[SWNVG_MAX_THREADS];
+	int nworkers;
+	int nthreads;		// Requested, 0 for automatic
+	SWNVGmutex mutex;
+	SWNVGcond startCond;
+	SWNVGcond doneCond;
+	int generation;
+	int nextBand;
+	int nbands;
+	int running;
+	int quit;
+};
+typedef struct SWNVGcontext SWNVGcontext;
+
+static int swnvg__maxi(int a, int b) { return a > b ? a : b; }
+static int swnvg__mini(int a, int b) { return a < b ? a : b; }
+static float swnvg__minf(float a, float b) { return a < b ? a : b; }
+static float swnvg__maxf(float a, float b) { return a > b ? a : b; }
+
+#ifdef _WIN32
+static void swnvg__mutexInit(SWNVGmutex* m) { InitializeCriticalSection(m); }
+static void swnvg__mutexDestroy(SWNVGmutex* m) { DeleteCriticalSection(m); }
+static void swnvg__lock(SWNVGmutex* m) { EnterCriticalSection(m); }
+static void swnvg__unlock(SWNVGmutex* m) { LeaveCriticalSection(m); }
+static void swnvg__condInit(SWNVGcond* c) { InitializeConditionVariable(c); }
+static void swnvg__condDestroy(SWNVGcond* c) { NVG_NOTUSED(c); }
+static void swnvg__condWait(SWNVGcond* c, SWNVGmutex* m) { SleepConditionVariableCS(c, m, INFINITE); }
+static void swnvg__condBroadcast(SWNVGcond* c) { WakeAllConditionVariable(c); }
+static int swnvg__cpuCount(void) { SYSTEM_INFO info; GetSystemInfo(&info); return (int)info.dwNumberOfProcessors; }
+#else
+static void swnvg__mutexInit(SWNVGmutex* m) { pthread_mutex_init(m, NULL); }
+static void swnvg__mutexDestroy(SWNVGmutex* m) { pthread_mutex_destroy(m); }
+static void swnvg__lock(SWNVGmutex* m) { pthread_mutex_lock(m); }
+static void swnvg__unlock(SWNVGmutex* m) { pthread_mutex_unlock(m); }
+static void swnvg__condInit(SWNVGcond* c) { pthread_cond_init(c, NULL); }
+static void swnvg__condDestroy(SWNVGcond* c) { pthread_cond_destroy(c); }
+static void swnvg__condWait(SWNVGcond* c, SWNVGmutex* m) { pthread_cond_wait(c, m); }
+static void swnvg__condBroadcast(SWNVGcond* c) { pthread_cond_broadcast(c); }
+static int swnvg__cpuCount(void) { long n = sysconf(_SC_NPROCESSORS_ONLN); return n > 0 ? (int)n : 1; }
+#endif
+
+static SWNVGtexture* swnvg__allocTexture(SWNVGcontext* sw)
+{
+	SWNVGtexture* tex = NULL;
+	int i;
+
+	for (i = 0; i < sw->ntextures; i++) {
+		if (sw->textures[i].id == 0) {
+			tex = &sw->textures[i];
+			break;
+		}
+	}
+	if (tex == NULL) {
+		if (sw->ntextures+1 > sw->ctextures) {
+			SWNVGtexture* textures;
+			int ctextures = swnvg__maxi(sw->ntextures+1, 4) +  sw->ctextures/2; // 1.5x Overallocate
+			textures = (SWNVGtexture*)realloc(sw->textures, sizeof(SWNVGtexture)*ctextures);
+			if (textures == NULL) return NULL;
+			sw->textures = textures;
+			sw->ctextures = ctextures;
+		}
+		tex = &sw->textures[sw->ntextures++];
+	}
+
+	memset(tex, 0, sizeof(*tex));
+	tex->id = ++sw->textureId;
+
+	return tex;
+}
+
+static SWNVGtexture* swnvg__findTexture(SWNVGcontext* sw, int id)
+{
+	int i;
+	for (i = 0; i < sw->ntextures; i++)
+		if (sw->textures[i].id == id)
+			return &sw->textures[i];
+	return NULL;
+}
+
+static int swnvg__deleteTexture(SWNVGcontext* sw, int id)
+{
+	int i;
+	for (i = 0; i < sw->ntextures; i++) {
+		if (sw->textures[i].id == id) {
+			free(sw->textures[i].data);
+			memset(&sw->textures[i], 0, sizeof(sw->textures[i]));
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int swnvg__renderCreate(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+	return 1;
+}
+
+static int swnvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__allocTexture(sw);
+	int size = w * h * (type == NVG_TEXTURE_RGBA ? 4 : 1);
+
+	if (tex == NULL) return 0;
+
+	tex->data = (unsigned char*)malloc(size);
+	if (tex->data == NULL) {
+		tex->id = 0;
+		return 0;
+	}
+
+	if (data != NULL)
+		memcpy(tex->data, data, size);
+	else
+		memset(tex->data, 0, size);
+
+	tex->width = w;
+	tex->height = h;
+	tex->type = type;
+	tex->flags = imageFlags;
+
+	return tex->id;
+}
+
+static int swnvg__renderDeleteTexture(void* uptr, int image)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	return swnvg__deleteTexture(sw, image);
+}
+
+static int swnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	int bpp, row;
+
+	if (tex == NULL) return 0;
+
+	// Data is the whole image, same as with GL_UNPACK_SKIP_*
+	bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+	for (row = y; row < y + h; row++)
+		memcpy(&tex->data[(row * tex->width + x) * bpp], &data[(row * tex->width + x) * bpp], w * bpp);
+
+	return 1;
+}
+
+static int swnvg__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	if (tex == NULL) return 0;
+	*w = tex->width;
+	*h = tex->height;
+	return 1;
+}
+
+static NVGcolor swnvg__premulColor(NVGcolor c)
+{
+	c.r *= c.a;
+	c.g *= c.a;
+	c.b *= c.a;
+	return c;
+}
+
+static int swnvg__convertPaint(SWNVGcontext* sw, SWNVGfragUniforms* frag, NVGpaint* paint,
+							   NVGscissor* scissor, float width, float fringe)
+{
+	SWNVGtexture* tex = NULL;
+	NVGcolor innerCol, outerCol;
+	float invxform[6];
+
+	memset(frag, 0, sizeof(*frag));
+
+	innerCol = swnvg__premulColor(paint->innerColor);
+	outerCol = swnvg__premulColor(paint->outerColor);
+	memcpy(frag->innerCol, innerCol.rgba, sizeof(frag->innerCol));
+	memcpy(frag->outerCol, outerCol.rgba, sizeof(frag->outerCol));
+
+	if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f) {
+		frag->scissorExt[0] = 1.0f;
+		frag->scissorExt[1] = 1.0f;
+		frag->scissorScale[0] = 1.0f;
+		frag->scissorScale[1] = 1.0f;
+	} else {
+		nvgTransformInverse(frag->scissorMat, scissor->xform);
+		frag->scissorExt[0] = scissor->extent[0];
+		frag->scissorExt[1] = scissor->extent[1];
+		frag->scissorScale[0] = sqrtf(scissor->xform[0]*scissor->xform[0] + scissor->xform[2]*scissor->xform[2]) / fringe;
+		frag->scissorScale[1] = sqrtf(scissor->xform[1]*scissor->xform[1] + scissor->xform[3]*scissor->xform[3]) / fringe;
+		frag->scissored = 1;
+
+		if (scissor->xform[1] == 0.0f && scissor->xform[2] == 0.0f) {
+			// Mask is 1 where the distance from the scissor edge is at least half of the fringe
+			float ex = fabsf(scissor->xform[0]) * scissor->extent[0] - fringe*0.5f;
+			float ey = fabsf(scissor->xform[3]) * scissor->extent[1] - fringe*0.5f;
+			frag->scissorInner[0] = scissor->xform[4] - ex;
+			frag->scissorInner[1] = scissor->xform[5] - ey;
+			frag->scissorInner[2] = scissor->xform[4] + ex;
+			frag->scissorInner[3] = scissor->xform[5] + ey;
+		}
+	}
+
+	memcpy(frag->extent, paint->extent, sizeof(frag->extent));
+	frag->strokeMult = (width*0.5f + fringe*0.5f) / fringe;
+
+	if (paint->image != 0) {
+		tex = swnvg__findTexture(sw, paint->image);
+		if (tex == NULL) return 0;
+		if ((tex->flags & NVG_IMAGE_FLIPY) != 0) {
+			float flipped[6];
+			nvgTransformScale(flipped, 1.0f, -1.0f);
+			nvgTransformMultiply(flipped, paint->xform);
+			nvgTransformInverse(invxform, flipped);
+		} else {
+			nvgTransformInverse(invxform, paint->xform);
+		}
+		frag->type = SWNVG_SHADER_FILLIMG;
+
+		if (tex->type == NVG_TEXTURE_RGBA)
+			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
+		else if (tex->flags & NVG_IMAGE_SDF)
+			frag->texType = 3;
+		else
+			frag->texType = 2;
+		// Distance fields are read through the feather, without one the distance itself is shown
+		if (frag->texType == 3)
+			frag->feather = paint->feather > 0.0f ? paint->feather : 1.0f;
+	} else {
+		frag->type = SWNVG_SHADER_FILLGRAD;
+		frag->radius = paint->radius;
+		frag->feather = swnvg__maxf(paint->feather, 1e-6f);
+		frag->solid = memcmp(&innerCol, &outerCol, sizeof(NVGcolor)) == 0;
+		// nvgLinearGradient() makes the box so wide that only the distance along y matters
+		frag->linear = paint->radius == 0.0f && paint->extent[0] >= 1e4f;
+		if (frag->solid && innerCol.a >= 1.0f) {
+			unsigned char bytes[4];
+			int i;
+			for (i = 0; i < 4; i++)
+				bytes[i] = (unsigned char)lrintf(swnvg__minf(swnvg__maxf(innerCol.rgba[i] * 255.0f, 0.0f), 255.0f)); // Rounded as by blending
+			memcpy(&frag->opaqueColor, bytes, 4);
+			frag->opaque = 1;
+		}
+		nvgTransformInverse(invxform, paint->xform);
+	}
+
+	memcpy(frag->paintMat, invxform, sizeof(frag->paintMat));
+	frag->tex = tex;
+
+	return 1;
+}
+
+static void swnvg__renderViewport(void* uptr, int width, int height)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	sw->view[0] = (float)width;
+	sw->view[1] = (float)height;
+}
+
+static void swnvg__renderCancel(void* uptr) {
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	sw->nverts = 0;
+	sw->npaths = 0;
+	sw->ncalls = 0;
+	sw->nuniforms = 0;
+}
+
+//
+// Shading
+//
+
+static int swnvg__wrap(int i, int size, int repeat)
+{
+	if (repeat) {
+		i %= size;
+		return i < 0 ? i + size : i;
+	}
+	return i < 0 ? 0 : (i >= size ? size - 1 : i);
+}
+
+// Bilinear sample of a texture at normalized coordinates, same as GL_LINEAR
+static void swnvg__sample(const SWNVGtexture* tex, float u, float v, float* color)
+{
+	float x = swnvg__minf(swnvg__maxf(u * tex->width - 0.5f, -1e6f), 1e6f);
+	float y = swnvg__minf(swnvg__maxf(v * tex->height - 0.5f, -1e6f), 1e6f);
+	float fx = floorf(x), fy = floorf(y);
+	float ax = x - fx, ay = y - fy;
+	int repeatX = (tex->flags & NVG_IMAGE_REPEATX) != 0;
+	int repeatY = (tex->flags & NVG_IMAGE_REPEATY) != 0;
+	int x0 = swnvg__wrap((int)fx, tex->width, repeatX);
+	int x1 = swnvg__wrap((int)fx + 1, tex->width, repeatX);
+	int y0 = swnvg__wrap((int)fy, tex->height, repeatY);
+	int y1 = swnvg__wrap((int)fy + 1, tex->height, repeatY);
+	float w00 = (1.0f - ax) * (1.0f - ay), w10 = ax * (1.0f - ay);
+	float w01 = (1.0f - ax) * ay, w11 = ax * ay;
+	int i;
+
+	if (tex->type == NVG_TEXTURE_RGBA) {
+		const unsigned char* p00 = &tex->data[(y0 * tex->width + x0) * 4];
+		const unsigned char* p10 = &tex->data[(y0 * tex->width + x1) * 4];
+		const unsigned char* p01 = &tex->data[(y1 * tex->width + x0) * 4];
+		const unsigned char* p11 = &tex->data[(y1 * tex->width + x1) * 4];
+		for (i = 0; i < 4; i++)
+			color[i] = (p00[i]*w00 + p10[i]*w10 + p01[i]*w01 + p11[i]*w11) * (1.0f / 255.0f);
+	} else {
+		const unsigned char* row0 = &tex->data[y0 * tex->width];
+		const unsigned char* row1 = &tex->data[y1 * tex->width];
+		color[0] = (row0[x0]*w00 + row0[x1]*w10 + row1[x0]*w01 + row1[x1]*w11) * (1.0f / 255.0f);
+		color[1] = color[2] = color[3] = color[0];
+	}
+}
+
+// Texture colors of four pixels with texType conversion applied
+static void swnvg__sample4(const SWNVGfragUniforms* frag, swnvg__f4 u, swnvg__f4 v,
+						   swnvg__f4* r, swnvg__f4* g, swnvg__f4* b, swnvg__f4* a)
+{
+	float us[4], vs[4], c[4][4];
+	int i;
+
+	swnvg__store(us, u);
+	swnvg__store(vs, v);
+
+	for (i = 0; i < 4; i++) {
+		float color[4];
+		swnvg__sample(frag->tex, us[i], vs[i], color);
+		if (frag->texType == 1) {
+			color[0] *= color[3];
+			color[1] *= color[3];
+			color[2] *= color[3];
+		} else if (frag->texType == 3) {
+			color[0] = swnvg__minf(swnvg__maxf((color[0] - 0.5f) / frag->feather + 0.5f, 0.0f), 1.0f);
+			color[1] = color[2] = color[3] = color[0];
+		}
+		c[0][i] = color[0];
+		c[1][i] = color[1];
+		c[2][i] = color[2];
+		c[3][i] = color[3];
+	}
+
+	*r = swnvg__load(c[0]);
+	*g = swnvg__load(c[1]);
+	*b = swnvg__load(c[2]);
+	*a = swnvg__load(c[3]);
+}
+
+// Blends premultiplied colors in [0..1] over n <= 4 pixels
+static void swnvg__blend4(unsigned char* dst, int n, swnvg__f4 r, swnvg__f4 g, swnvg__f4 b, swnvg__f4 a)
+{
+	swnvg__f4 inv = swnvg__sub(swnvg__set1(1.0f), a);
+	swnvg__f4 s = swnvg__set1(255.0f);
+	float rs[4], gs[4], bs[4], as[4], invs[4];
+	int i;
+
+	r = swnvg__mul(r, s);
+	g = swnvg__mul(g, s);
+	b = swnvg__mul(b, s);
+	a = swnvg__mul(a, s);
+
+#ifdef NANOVG_SW_SSE2
+	if (n == 4) {
+		__m128i zero = _mm_setzero_si128();
+		__m128i px = _mm_loadu_si128((const __m128i*)dst);
+		__m128i lo = _mm_unpacklo_epi8(px, zero);
+		__m128i hi = _mm_unpackhi_epi8(px, zero);
+		__m128 d0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+		__m128 d1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+		__m128 d2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+		__m128 d3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+		__m128i q0, q1, q2, q3;
+
+		// Pixels to channels and back
+		_MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+		d0 = _mm_add_ps(r, _mm_mul_ps(d0, inv));
+		d1 = _mm_add_ps(g, _mm_mul_ps(d1, inv));
+		d2 = _mm_add_ps(b, _mm_mul_ps(d2, inv));
+		d3 = _mm_add_ps(a, _mm_mul_ps(d3, inv));
+		_MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+
+		q0 = _mm_cvtps_epi32(d0);
+		q1 = _mm_cvtps_epi32(d1);
+		q2 = _mm_cvtps_epi32(d2);
+		q3 = _mm_cvtps_epi32(d3);
+		_mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(_mm_packs_epi32(q0, q1), _mm_packs_epi32(q2, q3)));
+		return;
+	}
+#endif
+
+	swnvg__store(rs, r);
+	swnvg__store(gs, g);
+	swnvg__store(bs, b);
+	swnvg__store(as, a);
+	swnvg__store(invs, inv);
+
+	for (i = 0; i < n; i++, dst += 4) {
+		float c[4];
+		int j;
+		c[0] = rs[i] + dst[0] * invs[i];
+		c[1] = gs[i] + dst[1] * invs[i];
+		c[2] = bs[i] + dst[2] * invs[i];
+		c[3] = as[i] + dst[3] * invs[i];
+		for (j = 0; j < 4; j++)
+			dst[j] = (unsigned char)lrintf(swnvg__minf(swnvg__maxf(c[j], 0.0f), 255.0f));
+	}
+}
+
+// Fragment shader of the GL backend evaluated for four pixels, cover is the extra per pixel coverage
+static void swnvg__shade4(const SWNVGcontext* sw, const SWNVGfragUniforms* frag, unsigned char* dst, int x, int y, int n,
+						  swnvg__f4 u, swnvg__f4 v, swnvg__f4 cover)
+{
+	swnvg__f4 px = swnvg__ramp((x + 0.5f) * sw->invScale[0], sw->invScale[0]);
+	swnvg__f4 py = swnvg__set1((y + 0.5f) * sw->invScale[1]);
+	swnvg__f4 one = swnvg__set1(1.0f);
+	swnvg__f4 alpha = cover;
+	swnvg__f4 r, g, b, a;
+	const int* inner = frag->scissorPixels;
+
+	if (frag->scissored && (x < inner[0] || x + n > inner[2] || y < inner[1] || y >= inner[3])) {
+		const float* m = frag->scissorMat;
+		swnvg__f4 sx = swnvg__madd(px, swnvg__set1(m[0]), swnvg__madd(py, swnvg__set1(m[2]), swnvg__set1(m[4])));
+		swnvg__f4 sy = swnvg__madd(px, swnvg__set1(m[1]), swnvg__madd(py, swnvg__set1(m[3]), swnvg__set1(m[5])));
+		sx = swnvg__sub(swnvg__abs(sx), swnvg__set1(frag->scissorExt[0]));
+		sy = swnvg__sub(swnvg__abs(sy), swnvg__set1(frag->scissorExt[1]));
+		sx = swnvg__clamp01(swnvg__sub(swnvg__set1(0.5f), swnvg__mul(sx, swnvg__set1(frag->scissorScale[0]))));
+		sy = swnvg__clamp01(swnvg__sub(swnvg__set1(0.5f), swnvg__mul(sy, swnvg__set1(frag->scissorScale[1]))));
+		alpha = swnvg__mul(alpha, swnvg__mul(sx, sy));
+	}
+
+	if (frag->type == SWNVG_SHADER_IMG) {
+		swnvg__sample4(frag, u, v, &r, &g, &b, &a);
+		r = swnvg__mul(r, swnvg__set1(frag->innerCol[0]));
+		g = swnvg__mul(g, swnvg__set1(frag->innerCol[1]));
+		b = swnvg__mul(b, swnvg__set1(frag->innerCol[2]));
+		a = swnvg__mul(a, swnvg__set1(frag->innerCol[3]));
+	} else {
+		if (sw->flags & NVG_ANTIALIAS) {
+			// Stroke - from [0..1] to clipped pyramid, where the slope is 1px
+			swnvg__f4 sa = swnvg__sub(one, swnvg__abs(swnvg__sub(swnvg__add(u, u), one)));
+			sa = swnvg__min(one, swnvg__mul(sa, swnvg__set1(frag->strokeMult)));
+			alpha = swnvg__mul(alpha, swnvg__mul(sa, swnvg__min(one, v)));
+		}
+
+		if (frag->type == SWNVG_SHADER_FILLIMG) {
+			const float* m = frag->paintMat;
+			swnvg__f4 tu = swnvg__madd(px, swnvg__set1(m[0]), swnvg__madd(py, swnvg__set1(m[2]), swnvg__set1(m[4])));
+			swnvg__f4 tv = swnvg__madd(px, swnvg__set1(m[1]), swnvg__madd(py, swnvg__set1(m[3]), swnvg__set1(m[5])));
+			swnvg__sample4(frag, swnvg__mul(tu, swnvg__set1(1.0f / frag->extent[0])), swnvg__mul(tv, swnvg__set1(1.0f / frag->extent[1])), &r, &g, &b, &a);
+			r = swnvg__mul(r, swnvg__set1(frag->innerCol[0]));
+			g = swnvg__mul(g, swnvg__set1(frag->innerCol[1]));
+			b = swnvg__mul(b, swnvg__set1(frag->innerCol[2]));
+			a = swnvg__mul(a, swnvg__set1(frag->innerCol[3]));
+		} else if (frag->solid) {
+			r = swnvg__set1(frag->innerCol[0]);
+			g = swnvg__set1(frag->innerCol[1]);
+			b = swnvg__set1(frag->innerCol[2]);
+			a = swnvg__set1(frag->innerCol[3]);
+		} else if (frag->linear) {
+			const float* m = frag->paintMat;
+			swnvg__f4 pty = swnvg__madd(px, swnvg__set1(m[1]), swnvg__madd(py, swnvg__set1(m[3]), swnvg__set1(m[5])));
+			swnvg__f4 d = swnvg__sub(swnvg__abs(pty), swnvg__set1(frag->extent[1]));
+			d = swnvg__clamp01(swnvg__mul(swnvg__add(d, swnvg__set1(frag->feather * 0.5f)), swnvg__set1(1.0f / frag->feather)));
+
+			r = swnvg__madd(d, swnvg__set1(frag->outerCol[0] - frag->innerCol[0]), swnvg__set1(frag->innerCol[0]));
+			g = swnvg__madd(d, swnvg__set1(frag->outerCol[1] - frag->innerCol[1]), swnvg__set1(frag->innerCol[1]));
+			b = swnvg__madd(d, swnvg__set1(frag->outerCol[2] - frag->innerCol[2]), swnvg__set1(frag->innerCol[2]));
+			a = swnvg__madd(d, swnvg__set1(frag->outerCol[3] - frag->innerCol[3]), swnvg__set1(frag->innerCol[3]));
+		} else {
+			// Box gradient, distance from a rounded rectangle
+			const float* m = frag->paintMat;
+			swnvg__f4 zero = swnvg__set1(0.0f);
+			swnvg__f4 rad = swnvg__set1(frag->radius);
+			swnvg__f4 ptx = swnvg__madd(px, swnvg__set1(m[0]), swnvg__madd(py, swnvg__set1(m[2]), swnvg__set1(m[4])));
+			swnvg__f4 pty = swnvg__madd(px, swnvg__set1(m[1]), swnvg__madd(py, swnvg__set1(m[3]), swnvg__set1(m[5])));
+			swnvg__f4 dx = swnvg__sub(swnvg__abs(ptx), swnvg__set1(frag->extent[0] - frag->radius));
+			swnvg__f4 dy = swnvg__sub(swnvg__abs(pty), swnvg__set1(frag->extent[1] - frag->radius));
+			swnvg__f4 ox = swnvg__max(dx, zero), oy = swnvg__max(dy, zero);
+			swnvg__f4 d = swnvg__add(swnvg__min(swnvg__max(dx, dy), zero), swnvg__sqrt(swnvg__madd(ox, ox, swnvg__mul(oy, oy))));
+			d = swnvg__sub(d, rad);
+			d = swnvg__clamp01(swnvg__mul(swnvg__add(d, swnvg__set1(frag->feather * 0.5f)), swnvg__set1(1.0f / frag->feather)));
+
+			r = swnvg__madd(d, swnvg__set1(frag->outerCol[0] - frag->innerCol[0]), swnvg__set1(frag->innerCol[0]));
+			g = swnvg__madd(d, swnvg__set1(frag->outerCol[1] - frag->innerCol[1]), swnvg__set1(frag->innerCol[1]));
+			b = swnvg__madd(d, swnvg__set1(frag->outerCol[2] - frag->innerCol[2]), swnvg__set1(frag->innerCol[2]));
+			a = swnvg__madd(d, swnvg__set1(frag->outerCol[3] - frag->innerCol[3]), swnvg__set1(frag->innerCol[3]));
+		}
+	}
+
+	if (frag->opaque && swnvg__all(alpha, n)) {
+		// Interior of an opaque solid fill replaces the pixels
+		int i;
+		for (i = 0; i < n; i++)
+			memcpy(&dst[i * 4], &frag->opaqueColor, 4);
+		return;
+	}
+
+	swnvg__blend4(dst, n, swnvg__mul(r, alpha), swnvg__mul(g, alpha), swnvg__mul(b, alpha), swnvg__mul(a, alpha));
+}
+
+//
+// Rasterization
+//
+
+static double swnvg__clampd(double v, double lo, double hi)
+{
+	return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static long long swnvg__floorDiv(long long num, long long den)
+{
+	long long q = num / den;
+	return (num % den != 0 && num < 0) ? q - 1 : q;
+}
+
+static long long swnvg__ceilDiv(long long num, long long den)
+{
+	long long q = num / den;
+	return (num % den != 0 && num > 0) ? q + 1 : q;
+}
+
+static long long swnvg__toFixed(float v)
+{
+	v = swnvg__minf(swnvg__maxf(v, (float)-SWNVG_MAX_COORD), (float)SWNVG_MAX_COORD);
+	return (long long)floorf(v * SWNVG_SUBPIXEL + 0.5f);
+}
+
+// Processes pixels [x0, x1] of row y covered by a triangle
+static void swnvg__span(SWNVGcontext* sw, SWNVGband* band, const SWNVGfragUniforms* frag, int mode, int winding,
+						int y, int x0, int x1, float u, float v, float dudx, float dvdx)
+{
+	unsigned char* stencil = &band->stencil[(y - band->y0) * sw->width];
+	unsigned char* dst = &sw->pixels[y * sw->stride];
+	swnvg__f4 cover = swnvg__set1(1.0f);
+	int x;
+
+	if (mode == SWNVG_RASTER_STENCIL) {
+		for (x = x0; x <= x1; x++)
+			stencil[x] = (unsigned char)(stencil[x] + winding);
+		return;
+	}
+
+
+	for (x = x0; x <= x1; x += 4) {
+		int n = swnvg__mini(4, x1 - x + 1);
+		float du = (x - x0) * dudx, dv = (x - x0) * dvdx;
+
+		if (mode == SWNVG_RASTER_SHADE_OUTSIDE) {
+			float c[4];
+			int i;
+			for (i = 0; i < 4; i++)
+				c[i] = (i < n && stencil[x + i] == 0) ? 1.0f : 0.0f;
+			if (c[0] + c[1] + c[2] + c[3] == 0.0f)
+				continue;
+			cover = swnvg__load(c);
+		}
+
+		swnvg__shade4(sw, frag, &dst[x * 4], x, y, n, swnvg__ramp(u + du, dudx), swnvg__ramp(v + dv, dvdx), cover);
+	}
+}
+
+static void swnvg__triangle(SWNVGcontext* sw, SWNVGband* band, const int* clip, const SWNVGfragUniforms* frag, int mode,
+							const NVGvertex* v0, const NVGvertex* v1, const NVGvertex* v2)
+{
+	const NVGvertex* v[3];
+	long long X[3], Y[3], A[3], B[3], C[3], area;
+	int incl[3], winding, i, y, y0, y1;
+	double invA[3], x0, y0f, dx1, dy1, dx2, dy2, det, dudx, dudy, dvdx, dvdy;
+	float ymin, ymax;
+
+	// Most triangles of a call are outside of the band
+	ymin = swnvg__minf(v0->y, swnvg__minf(v1->y, v2->y)) * sw->scale[1];
+	ymax = swnvg__maxf(v0->y, swnvg__maxf(v1->y, v2->y)) * sw->scale[1];
+	if (ymax < (float)band->y0 || ymin > (float)band->y1)
+		return;
+
+	v[0] = v0; v[1] = v1; v[2] = v2;
+	for (i = 0; i < 3; i++) {
+		X[i] = swnvg__toFixed(v[i]->x * sw->scale[0]);
+		Y[i] = swnvg__toFixed(v[i]->y * sw->scale[1]);
+	}
+
+	area = (X[1] - X[0]) * (Y[2] - Y[0]) - (Y[1] - Y[0]) * (X[2] - X[0]);
+	if (area == 0) return;
+
+	// Make the inside of all edges positive
+	winding = area > 0 ? 1 : -1;
+	if (area < 0) {
+		const NVGvertex* tv = v[1]; long long t;
+		v[1] = v[2]; v[2] = tv;
+		t = X[1]; X[1] = X[2]; X[2] = t;
+		t = Y[1]; Y[1] = Y[2]; Y[2] = t;
+	}
+
+	for (i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		A[i] = -(Y[j] - Y[i]);
+		B[i] = X[j] - X[i];
+		C[i] = -(A[i] * X[i] + B[i] * Y[i]);
+		// Top-left rule, pixel centers on an edge shared by two triangles belong to just one of them
+		incl[i] = A[i] > 0 || (A[i] == 0 && B[i] > 0);
+		invA[i] = A[i] != 0 ? 1.0 / (double)(A[i] * SWNVG_SUBPIXEL) : 0.0;
+	}
+
+	y0 = (int)swnvg__ceilDiv(swnvg__mini((int)Y[0], swnvg__mini((int)Y[1], (int)Y[2])) - SWNVG_SUBPIXEL/2, SWNVG_SUBPIXEL);
+	y1 = (int)swnvg__floorDiv(swnvg__maxi((int)Y[0], swnvg__maxi((int)Y[1], (int)Y[2])) - SWNVG_SUBPIXEL/2, SWNVG_SUBPIXEL);
+	y0 = swnvg__maxi(y0, swnvg__maxi(clip[1], band->y0));
+	y1 = swnvg__mini(y1, swnvg__mini(clip[3], band->y1) - 1);
+	if (y0 > y1) return;
+
+	// Attribute gradients for interpolation
+	x0 = (double)X[0] / SWNVG_SUBPIXEL;
+	y0f = (double)Y[0] / SWNVG_SUBPIXEL;
+	dx1 = (double)(X[1] - X[0]) / SWNVG_SUBPIXEL;
+	dy1 = (double)(Y[1] - Y[0]) / SWNVG_SUBPIXEL;
+	dx2 = (double)(X[2] - X[0]) / SWNVG_SUBPIXEL;
+	dy2 = (double)(Y[2] - Y[0]) / SWNVG_SUBPIXEL;
+	det = dx1 * dy2 - dx2 * dy1;
+	dudx = ((v[1]->u - v[0]->u) * dy2 - (v[2]->u - v[0]->u) * dy1) / det;
+	dudy = ((v[2]->u - v[0]->u) * dx1 - (v[1]->u - v[0]->u) * dx2) / det;
+	dvdx = ((v[1]->v - v[0]->v) * dy2 - (v[2]->v - v[0]->v) * dy1) / det;
+	dvdy = ((v[2]->v - v[0]->v) * dx1 - (v[1]->v - v[0]->v) * dx2) / det;
+
+	for (y = y0; y <= y1; y++) {
+		long long cy = (long long)y * SWNVG_SUBPIXEL + SWNVG_SUBPIXEL/2;
+		long long xs = clip[0], xe = clip[2] - 1;
+		double cx, cyf;
+
+		// Pixel x is inside of an edge when A * SUBPIXEL * x + k >= 0, the floating point estimate of the
+		// crossing is corrected with exact integer tests
+		for (i = 0; i < 3 && xs <= xe; i++) {
+			long long a = A[i] * SWNVG_SUBPIXEL;
+			long long k = B[i] * cy + C[i] + A[i] * (SWNVG_SUBPIXEL/2) + (incl[i] ? 0 : -1);
+			if (a > 0) {
+				long long x = (long long)ceil(swnvg__clampd(-k * invA[i], (double)xs, (double)xe + 1.0));
+				while (x > xs && a * (x - 1) + k >= 0) x--;
+				while (x <= xe && a * x + k < 0) x++;
+				xs = x;
+			} else if (a < 0) {
+				long long x = (long long)floor(swnvg__clampd(-k * invA[i], (double)xs - 1.0, (double)xe));
+				while (x < xe && a * (x + 1) + k >= 0) x++;
+				while (x >= xs && a * x + k < 0) x--;
+				xe = x;
+			} else if (k < 0) {
+				xe = xs - 1;
+			}
+		}
+
+		if (xs > xe) continue;
+
+		cx = xs + 0.5 - x0;
+		cyf = y + 0.5 - y0f;
+		swnvg__span(sw, band, frag, mode, winding, y, (int)xs, (int)xe,
+					(float)(v[0]->u + dudx * cx + dudy * cyf), (float)(v[0]->v + dvdx * cx + dvdy * cyf),
+					(float)dudx, (float)dvdx);
+	}
+}
+
+static void swnvg__triangleFan(SWNVGcontext* sw, SWNVGband* band, const int* clip, const SWNVGfragUniforms* frag, int mode,
+							   const NVGvertex* verts, int count)
+{
+	int i;
+	for (i = 2; i < count; i++)
+		swnvg__triangle(sw, band, clip, frag, mode, &verts[0], &verts[i - 1], &verts[i]);
+}
+
+static void swnvg__triangleStrip(SWNVGcontext* sw, SWNVGband* band, const int* clip, const SWNVGfragUniforms* frag, int mode,
+								 const NVGvertex* verts, int count)
+{
+	int i;
+	for (i = 2; i < count; i++)
+		swnvg__triangle(sw, band, clip, frag, mode, &verts[i - 2], &verts[i - 1], &verts[i]);
+}
+
+static int swnvg__pathVisible(const SWNVGpath* path, const int* clip)
+{
+	return path->rows[0] < clip[3] && path->rows[1] > clip[1];
+}
+
+static void swnvg__fill(SWNVGcontext* sw, SWNVGband* band, const int* clip, SWNVGcall* call)
+{
+	SWNVGpath* paths = &sw->paths[call->pathOffset];
+	const SWNVGfragUniforms* frag = &sw->uniforms[call->uniformOffset];
+	int i, npaths = call->pathCount, x, y;
+
+	// Draw shapes into stencil
+	for (i = 0; i < npaths; i++) {
+		if (swnvg__pathVisible(&paths[i], clip))
+			swnvg__triangleFan(sw, band, clip, frag, SWNVG_RASTER_STENCIL, &sw->verts[paths[i].fillOffset], paths[i].fillCount);
+	}
+
+	// Draw anti-aliased pixels
+	if (sw->flags & NVG_ANTIALIAS) {
+		for (i = 0; i < npaths; i++) {
+			if (swnvg__pathVisible(&paths[i], clip))
+				swnvg__triangleStrip(sw, band, clip, frag, SWNVG_RASTER_SHADE_OUTSIDE, &sw->verts[paths[i].strokeOffset], paths[i].strokeCount);
+		}
+	}
+
+	// Draw fill where stencil is set and clear it, the bounds quad has constant u = 0.5, v = 1
+	for (y = swnvg__maxi(clip[1], band->y0); y < swnvg__mini(clip[3], band->y1); y++) {
+		unsigned char* stencil = &band->stencil[(y - band->y0) * sw->width];
+		unsigned char* dst = &sw->pixels[y * sw->stride];
+
+		for (x = clip[0]; x < clip[2]; x += 4) {
+			int n = swnvg__mini(4, clip[2] - x);
+			float c[4];
+			for (i = 0; i < 4; i++) {
+				c[i] = (i < n && stencil[x + i] != 0) ? 1.0f : 0.0f;
+				if (i < n) stencil[x + i] = 0;
+			}
+			if (c[0] + c[1] + c[2] + c[3] == 0.0f)
+				continue;
+			swnvg__shade4(sw, frag, &dst[x * 4], x, y, n, swnvg__set1(0.5f), swnvg__set1(1.0f), swnvg__load(c));
+		}
+	}
+}
+
+static void swnvg__convexFill(SWNVGcontext* sw, SWNVGband* band, const int* clip, SWNVGcall* call)
+{
+	SWNVGpath* paths = &sw->paths[call->pathOffset];
+	const SWNVGfragUniforms* frag = &sw->uniforms[call->uniformOffset];
+	int i, npaths = call->pathCount;
+
+	for (i = 0; i < npaths; i++) {
+		if (!swnvg__pathVisible(&paths[i], clip))
+			continue;
+		swnvg__triangleFan(sw, band, clip, frag, SWNVG_RASTER_SHADE, &sw->verts[paths[i].fillOffset], paths[i].fillCount);
+		// Draw fringes
+		if (sw->flags & NVG_ANTIALIAS)
+			swnvg__triangleStrip(sw, band, clip, frag, SWNVG_RASTER_SHADE, &sw->verts[paths[i].strokeOffset], paths[i].strokeCount);
+	}
+}
+
+static void swnvg__stroke(SWNVGcontext* sw, SWNVGband* band, const int* clip, SWNVGcall* call)
+{
+	SWNVGpath* paths = &sw->paths[call->pathOffset];
+	const SWNVGfragUniforms* frag = &sw->uniforms[call->uniformOffset];
+	int i, npaths = call->pathCount;
+
+	for (i = 0; i < npaths; i++) {
+		if (swnvg__pathVisible(&paths[i], clip))
+			swnvg__triangleStrip(sw, band, clip, frag, SWNVG_RASTER_SHADE, &sw->verts[paths[i].strokeOffset], paths[i].strokeCount);
+	}
+}
+
+static void swnvg__triangles(SWNVGcontext* sw, SWNVGband* band, const int* clip, SWNVGcall* call)
+{
+	const SWNVGfragUniforms* frag = &sw->uniforms[call->uniformOffset];
+	const NVGvertex* verts = &sw->verts[call->triangleOffset];
+	int i;
+
+	for (i = 0; i + 2 < call->triangleCount; i += 3)
+		swnvg__triangle(sw, band, clip, frag, SWNVG_RASTER_SHADE, &verts[i], &verts[i + 1], &verts[i + 2]);
+}
+
+static void swnvg__renderBand(SWNVGcontext* sw, SWNVGband* band)
+{
+	int i;
+
+	for (i = 0; i < sw->ncalls; i++) {
+		SWNVGcall* call = &sw->calls[i];
+		int clip[4];
+
+		clip[0] = call->bounds[0];
+		clip[1] = swnvg__maxi(call->bounds[1], band->y0);
+		clip[2] = call->bounds[2];
+		clip[3] = swnvg__mini(call->bounds[3], band->y1);
+		if (clip[0] >= clip[2] || clip[1] >= clip[3])
+			continue;
+
+		if (call->type == SWNVG_FILL)
+			swnvg__fill(sw, band, clip, call);
+		else if (call->type == SWNVG_CONVEXFILL)
+			swnvg__convexFill(sw, band, clip, call);
+		else if (call->type == SWNVG_STROKE)
+			swnvg__stroke(sw, band, clip, call);
+		else if (call->type == SWNVG_TRIANGLES)
+			swnvg__triangles(sw, band, clip, call);
+	}
+}
+
+// Renders bands until there are none left
+static void swnvg__work(SWNVGworker* worker)
+{
+	SWNVGcontext* sw = worker->sw;
+	SWNVGband band;
+
+	band.stencil = worker->stencil;
+
+	for (;;) {
+		int index;
+
+		swnvg__lock(&sw->mutex);
+		index = sw->nextBand < sw->nbands ? sw->nextBand++ : -1;
+		swnvg__unlock(&sw->mutex);
+
+		if (index < 0)
+			break;
+
+		band.y0 = index * SWNVG_BAND_HEIGHT;
+		band.y1 = swnvg__mini(band.y0 + SWNVG_BAND_HEIGHT, sw->height);
+		swnvg__renderBand(sw, &band);
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI swnvg__workerMain(LPVOID param)
+#else
+static void* swnvg__workerMain(void* param)
+#endif
+{
+	SWNVGworker* worker = (SWNVGworker*)param;
+	SWNVGcontext* sw = worker->sw;
+	int generation = 0;
+
+	for (;;) {
+		swnvg__lock(&sw->mutex);
+		while (sw->generation == generation && !sw->quit)
+			swnvg__condWait(&sw->startCond, &sw->mutex);
+		generation = sw->generation;
+		swnvg__unlock(&sw->mutex);
+
+		if (sw->quit)
+			break;
+
+		swnvg__work(worker);
+
+		swnvg__lock(&sw->mutex);
+		if (--sw->running == 0)
+			swnvg__condBroadcast(&sw->doneCond);
+		swnvg__unlock(&sw->mutex);
+	}
+
+	return 0;
+}
+
+static void swnvg__stopWorkers(SWNVGcontext* sw)
+{
+	int i;
+
+	swnvg__lock(&sw->mutex);
+	sw->quit = 1;
+	swnvg__condBroadcast(&sw->startCond);
+	swnvg__unlock(&sw->mutex);
+
+	for (i = 1; i < sw->nworkers; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(sw->workers[i].thread, INFINITE);
+		CloseHandle(sw->workers[i].thread);
+#else
+		pthread_join(sw->workers[i].thread, NULL);
+#endif
+	}
+
+	sw->nworkers = 1;
+	sw->quit = 0;
+}
+
+static void swnvg__startWorkers(SWNVGcontext* sw, int count)
+{
+	int i;
+
+	sw->generation = 0;
+
+	for (i = 1; i < count; i++) {
+		SWNVGworker* worker = &sw->workers[i];
+		worker->sw = sw;
+#ifdef _WIN32
+		worker->thread = CreateThread(NULL, 0, swnvg__workerMain, worker, 0, NULL);
+		if (worker->thread == NULL) break;
+#else
+		if (pthread_create(&worker->thread, NULL, swnvg__workerMain, worker) != 0) break;
+#endif
+		sw->nworkers = i + 1;
+	}
+}
+
+static void swnvg__vertexBounds(const NVGvertex* verts, int count, float* bounds)
+{
+	int i;
+	for (i = 0; i < count; i++) {
+		bounds[0] = swnvg__minf(bounds[0], verts[i].x);
+		bounds[1] = swnvg__minf(bounds[1], verts[i].y);
+		bounds[2] = swnvg__maxf(bounds[2], verts[i].x);
+		bounds[3] = swnvg__maxf(bounds[3], verts[i].y);
+	}
+}
+
+static void swnvg__callBounds(SWNVGcontext* sw, SWNVGcall* call)
+{
+	SWNVGfragUniforms* frag = &sw->uniforms[call->uniformOffset];
+	float bounds[4] = { 1e30f, 1e30f, -1e30f, -1e30f };
+	int* inner = frag->scissorPixels;
+	int i;
+
+	if (call->type == SWNVG_TRIANGLES) {
+		swnvg__vertexBounds(&sw->verts[call->triangleOffset], call->triangleCount, bounds);
+	} else {
+		// Paths are skipped by bands they don't touch
+		for (i = 0; i < call->pathCount; i++) {
+			SWNVGpath* path = &sw->paths[call->pathOffset + i];
+			float pathBounds[4] = { 1e30f, 1e30f, -1e30f, -1e30f };
+			swnvg__vertexBounds(&sw->verts[path->fillOffset], path->fillCount, pathBounds);
+			swnvg__vertexBounds(&sw->verts[path->strokeOffset], path->strokeCount, pathBounds);
+			path->rows[0] = (int)floorf(swnvg__maxf(pathBounds[1] * sw->scale[1], -1.0f));
+			path->rows[1] = (int)ceilf(swnvg__minf(pathBounds[3] * sw->scale[1], (float)sw->height)) + 1;
+			bounds[0] = swnvg__minf(bounds[0], pathBounds[0]);
+			bounds[1] = swnvg__minf(bounds[1], pathBounds[1]);
+			bounds[2] = swnvg__maxf(bounds[2], pathBounds[2]);
+			bounds[3] = swnvg__maxf(bounds[3], pathBounds[3]);
+		}
+	}
+
+	if (frag->scissored) {
+		bounds[0] = swnvg__maxf(bounds[0], call->scissorBounds[0]);
+		bounds[1] = swnvg__maxf(bounds[1], call->scissorBounds[1]);
+		bounds[2] = swnvg__minf(bounds[2], call->scissorBounds[2]);
+		bounds[3] = swnvg__minf(bounds[3], call->scissorBounds[3]);
+	}
+
+	// Conservative pixel bounds, the exact coverage is decided by the rasterizer
+	call->bounds[0] = swnvg__maxi(0, (int)floorf(swnvg__maxf(bounds[0] * sw->scale[0], -1.0f)));
+	call->bounds[1] = swnvg__maxi(0, (int)floorf(swnvg__maxf(bounds[1] * sw->scale[1], -1.0f)));
+	call->bounds[2] = swnvg__mini(sw->width, (int)ceilf(swnvg__minf(bounds[2] * sw->scale[0], (float)sw->width)) + 1);
+	call->bounds[3] = swnvg__mini(sw->height, (int)ceilf(swnvg__minf(bounds[3] * sw->scale[1], (float)sw->height)) + 1);
+
+	// Pixels whose centers are inside of the scissor by more than half of the fringe skip the scissor mask,
+	// the margin keeps results identical to evaluating it
+	inner[0] = (int)ceilf(frag->scissorInner[0] * sw->scale[0] - 0.5f + 1e-3f);
+	inner[1] = (int)ceilf(frag->scissorInner[1] * sw->scale[1] - 0.5f + 1e-3f);
+	inner[2] = (int)floorf(frag->scissorInner[2] * sw->scale[0] - 0.5f - 1e-3f) + 1;
+	inner[3] = (int)floorf(frag->scissorInner[3] * sw->scale[1] - 0.5f - 1e-3f) + 1;
+
+	if (call->bounds[0] >= inner[0] && call->bounds[1] >= inner[1] && call->bounds[2] <= inner[2] && call->bounds[3] <= inner[3])
+		frag->scissored = 0;
+}
+
+static void swnvg__renderFlush(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	int i, threads;
+
+	if (sw->ncalls > 0 && sw->pixels != NULL && sw->view[0] > 0.0f && sw->view[1] > 0.0f) {
+		threads = sw->nthreads > 0 ? sw->nthreads : swnvg__cpuCount();
+		threads = swnvg__maxi(1, swnvg__mini(threads, SWNVG_MAX_THREADS));
+
+		if (threads != sw->nworkers) {
+			swnvg__stopWorkers(sw);
+			swnvg__startWorkers(sw, threads);
+		}
+
+		for (i = 0; i < sw->nworkers; i++) {
+			SWNVGworker* worker = &sw->workers[i];
+			int size = sw->width * SWNVG_BAND_HEIGHT;
+			if (worker->stencilSize < size) {
+				free(worker->stencil);
+				worker->stencil = (unsigned char*)malloc(size);
+				worker->stencilSize = worker->stencil != NULL ? size : 0;
+			}
+			if (worker->stencil == NULL) goto done;
+			memset(worker->stencil, 0, size);
+		}
+
+		sw->scale[0] = sw->width / sw->view[0];
+		sw->scale[1] = sw->height / sw->view[1];
+		sw->invScale[0] = 1.0f / sw->scale[0];
+		sw->invScale[1] = 1.0f / sw->scale[1];
+
+		for (i = 0; i < sw->ncalls; i++)
+			swnvg__callBounds(sw, &sw->calls[i]);
+
+		// Bands are shared by all workers, including this thread
+		swnvg__lock(&sw->mutex);
+		sw->nbands = (sw->height + SWNVG_BAND_HEIGHT - 1) / SWNVG_BAND_HEIGHT;
+		sw->nextBand = 0;
+		sw->running = sw->nworkers - 1;
+		sw->generation++;
+		swnvg__condBroadcast(&sw->startCond);
+		swnvg__unlock(&sw->mutex);
+
+		swnvg__work(&sw->workers[0]);
+
+		swnvg__lock(&sw->mutex);
+		while (sw->running > 0)
+			swnvg__condWait(&sw->doneCond, &sw->mutex);
+		swnvg__unlock(&sw->mutex);
+	}
+
+done:
+	// Reset calls
+	sw->nverts = 0;
+	sw->npaths = 0;
+	sw->ncalls = 0;
+	sw->nuniforms = 0;
+}
+
+static int swnvg__maxVertCount(const NVGpath* paths, int npaths)
+{
+	int i, count = 0;
+	for (i = 0; i < npaths; i++) {
+		count += paths[i].nfill;
+		count += paths[i].nstroke;
+	}
+	return count;
+}
+
+static SWNVGcall* swnvg__allocCall(SWNVGcontext* sw)
+{
+	SWNVGcall* ret = NULL;
+	if (sw->ncalls+1 > sw->ccalls) {
+		SWNVGcall* calls;
+		int ccalls = swnvg__maxi(sw->ncalls+1, 128) + sw->ccalls/2; // 1.5x Overallocate
+		calls = (SWNVGcall*)realloc(sw->calls, sizeof(SWNVGcall) * ccalls);
+		if (calls == NULL) return NULL;
+		sw->calls = calls;
+		sw->ccalls = ccalls;
+	}
+	ret = &sw->calls[sw->ncalls++];
+	memset(ret, 0, sizeof(SWNVGcall));
+	return ret;
+}
+
+static int swnvg__allocPaths(SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->npaths+n > sw->cpaths) {
+		SWNVGpath* paths;
+		int cpaths = swnvg__maxi(sw->npaths + n, 128) + sw->cpaths/2; // 1.5x Overallocate
+		paths = (SWNVGpath*)realloc(sw->paths, sizeof(SWNVGpath) * cpaths);
+		if (paths == NULL) return -1;
+		sw->paths = paths;
+		sw->cpaths = cpaths;
+	}
+	ret = sw->npaths;
+	sw->npaths += n;
+	return ret;
+}
+
+static int swnvg__allocVerts(SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->nverts+n > sw->cverts) {
+		NVGvertex* verts;
+		int cverts = swnvg__maxi(sw->nverts + n, 4096) + sw->cverts/2; // 1.5x Overallocate
+		verts = (NVGvertex*)realloc(sw->verts, sizeof(NVGvertex) * cverts);
+		if (verts == NULL) return -1;
+		sw->verts = verts;
+		sw->cverts = cverts;
+	}
+	ret = sw->nverts;
+	sw->nverts += n;
+	return ret;
+}
+
+static int swnvg__allocFragUniforms(SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->nuniforms+n > sw->cuniforms) {
+		SWNVGfragUniforms* uniforms;
+		int cuniforms = swnvg__maxi(sw->nuniforms+n, 128) + sw->cuniforms/2; // 1.5x Overallocate
+		uniforms = (SWNVGfragUniforms*)realloc(sw->uniforms, sizeof(SWNVGfragUniforms) * cuniforms);
+		if (uniforms == NULL) return -1;
+		sw->uniforms = uniforms;
+		sw->cuniforms = cuniforms;
+	}
+	ret = sw->nuniforms;
+	sw->nuniforms += n;
+	return ret;
+}
+
+static void swnvg__scissorBounds(SWNVGcall* call, NVGscissor* scissor)
+{
+	float ex, ey, cx, cy;
+
+	if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f)
+		return;
+
+	// Half a pixel of the anti-aliased scissor edge is added by the pixel rounding in swnvg__callBounds()
+	ex = fabsf(scissor->xform[0]) * scissor->extent[0] + fabsf(scissor->xform[2]) * scissor->extent[1] + 1.0f;
+	ey = fabsf(scissor->xform[1]) * scissor->extent[0] + fabsf(scissor->xform[3]) * scissor->extent[1] + 1.0f;
+	cx = scissor->xform[4];
+	cy = scissor->xform[5];
+
+	call->scissorBounds[0] = cx - ex;
+	call->scissorBounds[1] = cy - ey;
+	call->scissorBounds[2] = cx + ex;
+	call->scissorBounds[3] = cy + ey;
+}
+
+static void swnvg__renderFill(void* uptr, NVGpaint* paint, NVGscissor* scissor, float fringe,
+							  const float* bounds, const NVGpath* paths, int npaths)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw);
+	int i, maxverts, offset;
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_FILL;
+	call->pathOffset = swnvg__allocPaths(sw, npaths);
+	if (call->pathOffset == -1) goto error;
+	call->pathCount = npaths;
+	call->image = paint->image;
+
+	if (npaths == 1 && paths[0].convex)
+		call->type = SWNVG_CONVEXFILL;
+
+	// Allocate vertices for all the paths.
+	maxverts = swnvg__maxVertCount(paths, npaths);
+	offset = swnvg__allocVerts(sw, maxverts);
+	if (offset == -1) goto error;
+
+	for (i = 0; i < npaths; i++) {
+		SWNVGpath* copy = &sw->paths[call->pathOffset + i];
+		const NVGpath* path = &paths[i];
+		memset(copy, 0, sizeof(SWNVGpath));
+		if (path->nfill > 0) {
+			copy->fillOffset = offset;
+			copy->fillCount = path->nfill;
+			memcpy(&sw->verts[offset], path->fill, sizeof(NVGvertex) * path->nfill);
+			offset += path->nfill;
+		}
+		if (path->nstroke > 0) {
+			copy->strokeOffset = offset;
+			copy->strokeCount = path->nstroke;
+			memcpy(&sw->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+			offset += path->nstroke;
+		}
+	}
+
+	NVG_NOTUSED(bounds);
+	swnvg__scissorBounds(call, scissor);
+
+	// Stencil pass needs no shader, the bounds quad is covered directly
+	call->uniformOffset = swnvg__allocFragUniforms(sw, 1);
+	if (call->uniformOffset == -1) goto error;
+	if (!swnvg__convertPaint(sw, &sw->uniforms[call->uniformOffset], paint, scissor, fringe, fringe)) goto error;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderStroke(void* uptr, NVGpaint* paint, NVGscissor* scissor, float fringe,
+								float strokeWidth, const NVGpath* paths, int npaths)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw);
+	int i, maxverts, offset;
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_STROKE;
+	call->pathOffset = swnvg__allocPaths(sw, npaths);
+	if (call->pathOffset == -1) goto error;
+	call->pathCount = npaths;
+	call->image = paint->image;
+
+	// Allocate vertices for all the paths.
+	maxverts = swnvg__maxVertCount(paths, npaths);
+	offset = swnvg__allocVerts(sw, maxverts);
+	if (offset == -1) goto error;
+
+	for (i = 0; i < npaths; i++) {
+		SWNVGpath* copy = &sw->paths[call->pathOffset + i];
+		const NVGpath* path = &paths[i];
+		memset(copy, 0, sizeof(SWNVGpath));
+		if (path->nstroke) {
+			copy->strokeOffset = offset;
+			copy->strokeCount = path->nstroke;
+			memcpy(&sw->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+			offset += path->nstroke;
+		}
+	}
+
+	swnvg__scissorBounds(call, scissor);
+
+	// Fill shader
+	call->uniformOffset = swnvg__allocFragUniforms(sw, 1);
+	if (call->uniformOffset == -1) goto error;
+	if (!swnvg__convertPaint(sw, &sw->uniforms[call->uniformOffset], paint, scissor, strokeWidth, fringe)) goto error;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGscissor* scissor,
+								   const NVGvertex* verts, int nverts)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw);
+	SWNVGfragUniforms* frag;
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_TRIANGLES;
+	call->image = paint->image;
+
+	// Allocate vertices for all the paths.
+	call->triangleOffset = swnvg__allocVerts(sw, nverts);
+	if (call->triangleOffset == -1) goto error;
+	call->triangleCount = nverts;
+
+	memcpy(&sw->verts[call->triangleOffset], verts, sizeof(NVGvertex) * nverts);
+
+	swnvg__scissorBounds(call, scissor);
+
+	// Fill shader
+	call->uniformOffset = swnvg__allocFragUniforms(sw, 1);
+	if (call->uniformOffset == -1) goto error;
+	frag = &sw->uniforms[call->uniformOffset];
+	if (!swnvg__convertPaint(sw, frag, paint, scissor, 1.0f, 1.0f)) goto error;
+	frag->type = SWNVG_SHADER_IMG;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderDelete(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	int i;
+	if (sw == NULL) return;
+
+	swnvg__stopWorkers(sw);
+	swnvg__condDestroy(&sw->startCond);
+	swnvg__condDestroy(&sw->doneCond);
+	swnvg__mutexDestroy(&sw->mutex);
+
+	for (i = 0; i < SWNVG_MAX_THREADS; i++)
+		free(sw->workers[i].stencil);
+
+	for (i = 0; i < sw->ntextures; i++)
+		free(sw->textures[i].data);
+	free(sw->textures);
+
+	free(sw->paths);
+	free(sw->verts);
+	free(sw->uniforms);
+	free(sw->calls);
+
+	free(sw);
+}
+
+NVGcontext* nvgCreateSW(int flags)
+{
+	NVGparams params;
+	NVGcontext* ctx = NULL;
+	SWNVGcontext* sw = (SWNVGcontext*)malloc(sizeof(SWNVGcontext));
+	if (sw == NULL) goto error;
+	memset(sw, 0, sizeof(SWNVGcontext));
+
+	swnvg__mutexInit(&sw->mutex);
+	swnvg__condInit(&sw->startCond);
+	swnvg__condInit(&sw->doneCond);
+	sw->workers[0].sw = sw;
+	sw->nworkers = 1;
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = swnvg__renderCreate;
+	params.renderCreateTexture = swnvg__renderCreateTexture;
+	params.renderDeleteTexture = swnvg__renderDeleteTexture;
+	params.renderUpdateTexture = swnvg__renderUpdateTexture;
+	params.renderGetTextureSize = swnvg__renderGetTextureSize;
+	params.renderViewport = swnvg__renderViewport;
+	params.renderCancel = swnvg__renderCancel;
+	params.renderFlush = swnvg__renderFlush;
+	params.renderFill = swnvg__renderFill;
+	params.renderStroke = swnvg__renderStroke;
+	params.renderTriangles = swnvg__renderTriangles;
+	params.renderDelete = swnvg__renderDelete;
+	params.userPtr = sw;
+	params.edgeAntiAlias = flags & NVG_ANTIALIAS ? 1 : 0;
+	params.sdfText = flags & NVG_SDF_TEXT ? 1 : 0;
+
+	sw->flags = flags;
+
+	ctx = nvgCreateInternal(&params);
+	if (ctx == NULL) goto error;
+
+	return ctx;
+
+error:
+	// 'sw' is freed by nvgDeleteInternal.
+	if (ctx != NULL) nvgDeleteInternal(ctx);
+	return NULL;
+}
+
+void nvgDeleteSW(NVGcontext* ctx)
+{
+	nvgDeleteInternal(ctx);
+}
+
+void nvgswSetFramebuffer(NVGcontext* ctx, unsigned char* pixels, int width, int height, int stride)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	sw->pixels = pixels;
+	sw->width = width;
+	sw->height = height;
+	sw->stride = stride;
+}
+
+void nvgswSetThreadCount(NVGcontext* ctx, int count)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	sw->nthreads = count;
+}
+
+#endif /* NANOVG_SW_IMPLEMENTATION */
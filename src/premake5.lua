@@ -1,3 +1,4 @@
+include "bench"
 include "demo"
 include "glew"
 include "nanovg"